@@ -0,0 +1,723 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Native microbenchmarks of the launcher's hot functions.
+ * Build and run with `make bench`, see the Makefile. */
+
+#include <FL/Fl.H>
+#include <FL/Fl_PNG_Image.H>
+#include <FL/fl_draw.H>
+#include <FL/x.H>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "images.h"
+#include "dikeys.h"
+#include "configuration.hpp"
+#include "fastpng.hpp"
+#include "gamepaddb.hpp"
+#include "langpack.hpp"
+#include "metrics.hpp"
+#include "pixelcache.hpp"
+#include "scaledimage.hpp"
+#include "lang.h"
+#include "utf8.hpp"
+#include "bench.hpp"
+
+#define LABEL_LIMIT  87  /* kbButton width - 2 */
+
+/* synthetic PNGs for the decoder throughput, larger than the artwork */
+#define CORPUS_IMAGES  8
+#define CORPUS_W       1024
+#define CORPUS_H       768
+
+/* about the size of SDL_GameControllerDB, all platforms */
+#define GAMEPADDB_LINES  6000  /* keep in sync with the gamepaddb_index_6000 name */
+
+/* installed language packs must not add measurable startup time */
+#define LANGPACKS           50  /* keep in sync with the langpack_discover_50 name */
+#define LANGPACK_BUDGET_NS  1000000.0
+
+/* a metrics update must stay well below a microsecond */
+#define METRICS_HOT_NS  100
+
+
+typedef struct {
+	const char *name;
+	const unsigned char *data;
+	unsigned int size;
+} embeddedImage_t;
+
+#define IMAGE(x)  { "png_decode_" #x, x##_png, sizeof(x##_png) }
+static const embeddedImage_t images[] =
+{
+	IMAGE(arrow_01),
+	IMAGE(arrow_02),
+	IMAGE(arrow_03),
+	IMAGE(arrow_04),
+	IMAGE(back1),
+	IMAGE(back2),
+	IMAGE(back3),
+	IMAGE(button_01),
+	IMAGE(button_02),
+	IMAGE(button_03),
+	IMAGE(button_04),
+	IMAGE(button_05),
+	IMAGE(pad_controls_v02)
+};
+#undef IMAGE
+
+/* long localized key name, as returned by GetKeyNameText() on some layouts */
+static const char *longLabel =
+	"\xC3\x80\xC3\xA0\xC3\x81\xC3\xA1\xC3\x82\xC3\xA2\xC3\x84\xC3\xA4\xC3\x88"
+	"\xC3\xA8\xC3\x89\xC3\xA9\xC3\x8A\xC3\xAA\xC3\x8C\xC3\xAC\xC3\x8D\xC3\xAD";
+
+
+/* fixed advance per character; exercises the stripping loop without a display */
+static double fixed_width(const char *s)
+{
+	double w = 0;
+
+	for ( ; *s; ++s) {
+		if ((*s & 0xC0) != 0x80) {
+			w += 7;
+		}
+	}
+	return w;
+}
+
+static double flwidth(const char *s)
+{
+	return fl_width(s);
+}
+
+/* run the lang.h generator once, like the build does */
+static bool run_format_lang(const char *exe, const char *input)
+{
+	int status = 0;
+	pid_t pid = fork();
+
+	if (pid == -1) {
+		return false;
+	}
+
+	if (pid == 0) {
+		int in = open(input, O_RDONLY);
+		int out = open("/dev/null", O_WRONLY);
+
+		if (in == -1 || out == -1) {
+			_exit(127);
+		}
+		dup2(in, 0);
+		dup2(out, 1);
+		execl(exe, exe, static_cast<char *>(NULL));
+		_exit(127);
+	}
+
+	return waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+/* write n language packs with UI_ROWS rows each into dir */
+static bool write_langpacks(const char *dir, int n)
+{
+	char path[256];
+
+	for (int i = 0; i < n; ++i) {
+		snprintf(path, sizeof(path), "%s/lang-Pack%02d.txt", dir, i);
+		FILE *fp = fopen(path, "w");
+
+		if (!fp) {
+			return false;
+		}
+		for (int row = 0; row < UI_ROWS; ++row) {
+			fprintf(fp, "Pack %d string %d\n", i, row);
+		}
+		fclose(fp);
+	}
+	return true;
+}
+
+static void remove_langpacks(const char *dir, int n)
+{
+	char path[256];
+
+	for (int i = 0; i < n; ++i) {
+		snprintf(path, sizeof(path), "%s/lang-Pack%02d.txt", dir, i);
+		unlink(path);
+	}
+	rmdir(dir);
+}
+
+static void png_chunk(std::string &png, const char *type, const std::string &data)
+{
+	unsigned char len[4] = {
+		static_cast<unsigned char>(data.size() >> 24), static_cast<unsigned char>(data.size() >> 16),
+		static_cast<unsigned char>(data.size() >> 8), static_cast<unsigned char>(data.size())
+	};
+	std::string body = std::string(type, 4) + data;
+	uLong crc = crc32(0, reinterpret_cast<const Bytef *>(body.data()), body.size());
+	unsigned char c[4] = {
+		static_cast<unsigned char>(crc >> 24), static_cast<unsigned char>(crc >> 16),
+		static_cast<unsigned char>(crc >> 8), static_cast<unsigned char>(crc)
+	};
+
+	png.append(reinterpret_cast<char *>(len), 4);
+	png += body;
+	png.append(reinterpret_cast<char *>(c), 4);
+}
+
+/* w*h RGB (d = 3) or RGBA (d = 4) image with gradients and some noise;
+ * the rows cycle through all five filter types */
+static std::string make_png(int w, int h, int d, unsigned int seed)
+{
+	size_t stride = static_cast<size_t>(w) * d;
+	std::vector<unsigned char> prev(stride, 0), cur(stride);
+	std::string raw, png("\x89PNG\r\n\x1A\n", 8);
+
+	for (int y = 0; y < h; ++y) {
+		int filter = y % 5;
+
+		for (size_t i = 0; i < stride; ++i) {
+			seed = seed * 1103515245 + 12345;
+			cur[i] = static_cast<unsigned char>((i * 3 + y * 5) / 4 + ((seed >> 16) & 7));
+		}
+
+		raw += static_cast<char>(filter);
+		for (size_t i = 0; i < stride; ++i) {
+			int a = (i >= static_cast<size_t>(d)) ? cur[i - d] : 0;
+			int b = prev[i];
+			int c = (i >= static_cast<size_t>(d)) ? prev[i - d] : 0;
+			int p = a + b - c, pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+			int pred[5] = { 0, a, b, (a + b) >> 1, (pa <= pb && pa <= pc) ? a : (pb <= pc) ? b : c };
+
+			raw += static_cast<char>(cur[i] - pred[filter]);
+		}
+		prev = cur;
+	}
+
+	uLongf zlen = compressBound(raw.size());
+	std::string z(zlen, '\0');
+	compress2(reinterpret_cast<Bytef *>(&z[0]), &zlen, reinterpret_cast<const Bytef *>(raw.data()), raw.size(), 6);
+	z.resize(zlen);
+
+	unsigned char ihdr[13] = {
+		static_cast<unsigned char>(w >> 24), static_cast<unsigned char>(w >> 16),
+		static_cast<unsigned char>(w >> 8), static_cast<unsigned char>(w),
+		static_cast<unsigned char>(h >> 24), static_cast<unsigned char>(h >> 16),
+		static_cast<unsigned char>(h >> 8), static_cast<unsigned char>(h),
+		8, static_cast<unsigned char>(d == 4 ? 6 : 2), 0, 0, 0
+	};
+	png_chunk(png, "IHDR", std::string(reinterpret_cast<char *>(ihdr), 13));
+	png_chunk(png, "IDAT", z);
+	png_chunk(png, "IEND", "");
+
+	return png;
+}
+
+/* gamecontrollerdb.txt lookalike; every third line is for this platform */
+static std::string make_gamepaddb(int lines)
+{
+	static const char *platforms[] = { GAMEPADDB_PLATFORM, "Mac OS X", "Android" };
+	std::string db = "# Game Controller DB for SDL\n\n";
+	char guid[GAMEPADDB_GUID_LENGTH + 1];
+
+	for (int i = 0; i < lines; ++i) {
+		gamepadDb::usb_guid(guid, 0x045E + i / 3, 0x0200 + i / 3);
+		db += guid;
+		db += ",Controller " + std::to_string(i / 3);
+		db += ",a:b0,b:b1,back:b6,dpdown:h0.4,dpleft:h0.8,dpright:h0.2,dpup:h0.1,leftshoulder:b4,"
+			"leftstick:b8,lefttrigger:a2,leftx:a0,lefty:a1,rightshoulder:b5,rightstick:b9,"
+			"righttrigger:a5,rightx:a3,righty:a4,start:b7,x:b2,y:b3,platform:";
+		db += platforms[i % 3];
+		db += ",\n";
+	}
+	return db;
+}
+
+/* fastpng must decode to the same pixels as libpng */
+static bool fastpng_matches(const unsigned char *data, size_t size)
+{
+	Fl_PNG_Image png(NULL, data, static_cast<int>(size));
+	fastpngImage_t img;
+
+	if (!fastpng_decode(data, size, &img)) {
+		return false;
+	}
+
+	bool same = img.w == png.w() && img.h == png.h() && img.d == png.d() && png.count() == 1 &&
+		memcmp(img.pixels, png.data()[0], static_cast<size_t>(img.w) * img.h * img.d) == 0;
+
+	delete[] img.pixels;
+	return same;
+}
+
+static void print_throughput(benchmark &b, const char *name, size_t bytes)
+{
+	const benchResult_t *r = b.result(name);
+
+	if (r && r->median > 0) {
+		printf("%-36s %.1f MB/s decoded\n", name, bytes / r->median * 1000.0);
+	}
+}
+
+static void usage(const char *self)
+{
+	fprintf(stderr, "usage: %s [-o results.tsv] [-b baseline.tsv] [-t threshold] "
+		"[-f format_lang lang.txt] [filter]\n", self);
+}
+
+int main(int argc, char *argv[])
+{
+	const char *out = NULL, *baseline = NULL;
+	const char *formatLang = NULL, *langTxt = NULL;
+	double threshold = 0.10;
+	benchmark b;
+
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+			out = argv[++i];
+		} else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+			baseline = argv[++i];
+		} else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+			threshold = atof(argv[++i]);
+		} else if (strcmp(argv[i], "-f") == 0 && i + 2 < argc) {
+			formatLang = argv[++i];
+			langTxt = argv[++i];
+		} else if (argv[i][0] == '-') {
+			usage(argv[0]);
+			return 1;
+		} else {
+			b.filter(argv[i]);
+		}
+	}
+
+	/* main.conf encoding */
+	char tmpl[] = "/tmp/sonic-bench-XXXXXX";
+	int fd = mkstemp(tmpl);
+	if (fd == -1) {
+		perror("mkstemp()");
+		return 1;
+	}
+	close(fd);
+
+	wchar_t confFile[sizeof(tmpl)];
+	mbstowcs(confFile, tmpl, sizeof(tmpl));
+
+	configuration config(confFile, 1);
+	uchar buf[CONF_SIZE];
+
+	config.loadDefaultConfig();
+	config.encode(buf);
+
+	b.run("config_encode", [&]() { config.encode(buf); bench_keep(buf); });
+	b.run("config_decode", [&]() { bench_keep(config.decode(buf)); });
+	b.run("config_saveConfig", [&]() { bench_keep(config.saveConfig()); });
+	b.run("config_loadConfig", [&]() { bench_keep(config.loadConfig()); });
+
+	unlink(tmpl);
+
+	/* key validation */
+	b.run("isIgnoredKey_all_256", [&]() {
+		int n = 0;
+		for (int i = 0; i < 256; ++i) {
+			n += configuration::isIgnoredKey(static_cast<uchar>(i)) ? 1 : 0;
+		}
+		bench_keep(n);
+	});
+
+	uchar keys[KEYSTART] = { DIK_LEFT, DIK_RIGHT, DIK_UP, DIK_DOWN, DIK_SPACE, DIK_D, DIK_A, DIK_S, DIK_RETURN };
+	b.run("hasDuplicateKeys", [&]() {
+		bench_clobber();
+		bench_keep(configuration::hasDuplicateKeys(keys, KEYSTART));
+	});
+
+	/* label fitting */
+	b.run("label_fit_utf8_fixed_width", [&]() {
+		char s[128];
+		strcpy(s, longLabel);
+		fit_utf8_label(s, LABEL_LIMIT, fixed_width);
+		bench_keep(s);
+	});
+
+	if (getenv("DISPLAY")) {
+		fl_open_display();
+		fl_font(FL_HELVETICA, 12);
+
+		b.run("label_fit_utf8_fl_width", [&]() {
+			char s[128];
+			strcpy(s, longLabel);
+			fit_utf8_label(s, LABEL_LIMIT, flwidth);
+			bench_keep(s);
+		});
+	} else {
+		printf("%-36s skipped (no DISPLAY)\n", "label_fit_utf8_fl_width");
+	}
+
+	/* PNG decoding of the embedded images */
+	for (size_t i = 0; i < sizeof(images) / sizeof(*images); ++i) {
+		const embeddedImage_t *img = &images[i];
+
+		b.run(img->name, [&]() {
+			Fl_PNG_Image png(NULL, img->data, static_cast<int>(img->size));
+			bench_keep(png.w());
+		});
+	}
+
+	/* alternate decoder, see src/fastpng.hpp */
+	int decodeMismatches = 0;
+	size_t embeddedBytes = 0, corpusBytes = 0;
+	std::vector<std::string> corpus;
+
+	for (size_t i = 0; i < sizeof(images) / sizeof(*images); ++i) {
+		if (!fastpng_matches(images[i].data, images[i].size)) {
+			fprintf(stderr, "error: fastpng doesn't decode %s like libpng\n", images[i].name + strlen("png_decode_"));
+			decodeMismatches++;
+		}
+	}
+
+	for (int i = 0; i < CORPUS_IMAGES; ++i) {
+		corpus.push_back(make_png(CORPUS_W, CORPUS_H, (i & 1) ? 4 : 3, i));
+		corpusBytes += static_cast<size_t>(CORPUS_W) * CORPUS_H * ((i & 1) ? 4 : 3);
+
+		if (!fastpng_matches(reinterpret_cast<const unsigned char *>(corpus[i].data()), corpus[i].size())) {
+			fprintf(stderr, "error: fastpng doesn't decode corpus image %d like libpng\n", i);
+			decodeMismatches++;
+		}
+	}
+
+	b.run("png_embedded_libpng", [&]() {
+		embeddedBytes = 0;
+		for (size_t i = 0; i < sizeof(images) / sizeof(*images); ++i) {
+			Fl_PNG_Image png(NULL, images[i].data, static_cast<int>(images[i].size));
+			embeddedBytes += static_cast<size_t>(png.w()) * png.h() * png.d();
+		}
+	});
+
+	for (int sse2 = 0; sse2 <= 1; ++sse2) {
+		if (fastpng_sse2(sse2 == 1) != (sse2 == 1)) {
+			continue;
+		}
+
+		b.run(sse2 ? "png_embedded_fastpng_sse2" : "png_embedded_fastpng", [&]() {
+			for (size_t i = 0; i < sizeof(images) / sizeof(*images); ++i) {
+				fastpngImage_t img;
+				if (fastpng_decode(images[i].data, images[i].size, &img)) {
+					delete[] img.pixels;
+				}
+			}
+		});
+		b.run(sse2 ? "png_corpus_fastpng_sse2" : "png_corpus_fastpng", [&]() {
+			for (size_t i = 0; i < corpus.size(); ++i) {
+				fastpngImage_t img;
+				if (fastpng_decode(reinterpret_cast<const unsigned char *>(corpus[i].data()), corpus[i].size(), &img)) {
+					delete[] img.pixels;
+				}
+			}
+		});
+	}
+
+	b.run("png_corpus_libpng", [&]() {
+		for (size_t i = 0; i < corpus.size(); ++i) {
+			Fl_PNG_Image png(NULL, reinterpret_cast<const unsigned char *>(corpus[i].data()), static_cast<int>(corpus[i].size()));
+			bench_keep(png.w());
+		}
+	});
+
+	print_throughput(b, "png_embedded_libpng", embeddedBytes);
+	print_throughput(b, "png_embedded_fastpng", embeddedBytes);
+	print_throughput(b, "png_embedded_fastpng_sse2", embeddedBytes);
+	print_throughput(b, "png_corpus_libpng", corpusBytes);
+	print_throughput(b, "png_corpus_fastpng", corpusBytes);
+	print_throughput(b, "png_corpus_fastpng_sse2", corpusBytes);
+
+	/* on-disk pixel cache: a cold start decodes and writes the cache, a
+	 * warm one maps it and checks the pixels on lookup */
+	char cacheTmpl[] = "/tmp/sonic-pixels-XXXXXX";
+	int cacheErrors = 0;
+	size_t cacheBytes = 0;
+
+	fd = mkstemp(cacheTmpl);
+	if (fd == -1) {
+		perror("mkstemp()");
+		return 1;
+	}
+	close(fd);
+	unlink(cacheTmpl);
+
+	std::string cacheNew = std::string(cacheTmpl) + ".new";
+	wchar_t cacheFile[sizeof(cacheTmpl)];
+	mbstowcs(cacheFile, cacheTmpl, sizeof(cacheTmpl));
+
+	/* open, lookup of every embedded image; returns the misses */
+	auto cache_lookup = [&]() {
+		pixelCache c;
+		int misses = 0;
+
+		c.open(cacheFile);
+		for (size_t i = 0; i < sizeof(images) / sizeof(*images); ++i) {
+			const uchar *px;
+			int w, h, d;
+
+			if (c.find(pixelcache_hash(images[i].data, images[i].size), 100, &px, &w, &h, &d)) {
+				bench_keep(px[0]);
+			} else {
+				misses++;
+			}
+		}
+		return misses;
+	};
+
+	/* decode and write everything, with no cache left from before */
+	auto cache_build = [&]() {
+		pixelCache c;
+
+		unlink(cacheTmpl);
+		unlink(cacheNew.c_str());
+		c.open(cacheFile);
+		cacheBytes = 0;
+		for (size_t i = 0; i < sizeof(images) / sizeof(*images); ++i) {
+			Fl_PNG_Image png(NULL, images[i].data, static_cast<int>(images[i].size));
+			c.add(pixelcache_hash(images[i].data, images[i].size), 100,
+				reinterpret_cast<const uchar *>(png.data()[0]), png.w(), png.h(), png.d());
+			cacheBytes += static_cast<size_t>(png.w()) * png.h() * png.d();
+		}
+		return c.save();
+	};
+
+	b.run("pixelcache_embedded_cold", [&]() { bench_keep(cache_build()); });
+
+	/* the next open() moves the new file in place */
+	if (!cache_build() || cache_lookup() != 0) {
+		fprintf(stderr, "error: pixel cache misses after it was written\n");
+		cacheErrors++;
+	}
+
+	b.run("pixelcache_embedded_warm", [&]() { bench_keep(cache_lookup()); });
+	print_throughput(b, "pixelcache_embedded_warm", cacheBytes);
+
+	/* a damaged entry must be a miss, not garbage */
+	FILE *cacheFp = fopen(cacheTmpl, "r+b");
+	if (cacheFp && fseek(cacheFp, -1, SEEK_END) == 0) {
+		int c = fgetc(cacheFp);
+		fseek(cacheFp, -1, SEEK_END);
+		fputc(c ^ 0xFF, cacheFp);
+	}
+	if (cacheFp) {
+		fclose(cacheFp);
+	}
+	if (cache_lookup() != 1) {
+		fprintf(stderr, "error: damaged pixel cache entry wasn't rejected\n");
+		cacheErrors++;
+	}
+
+	unlink(cacheTmpl);
+	unlink(cacheNew.c_str());
+
+	/* resampling the largest image for 150% and 200% displays */
+	{
+		Fl_PNG_Image png(NULL, back1_png, sizeof(back1_png));
+		const uchar *data = reinterpret_cast<const uchar *>(png.data()[0]);
+		std::vector<uchar> out(static_cast<size_t>(png.w()) * png.h() * png.d() * 4);
+
+		b.run("resample_back1_150", [&]() {
+			resample_image(data, png.w(), png.h(), png.d(), png.ld(), out.data(), png.w() * 3 / 2, png.h() * 3 / 2);
+			bench_keep(out[0]);
+		});
+		b.run("resample_back1_200", [&]() {
+			resample_image(data, png.w(), png.h(), png.d(), png.ld(), out.data(), png.w() * 2, png.h() * 2);
+			bench_keep(out[0]);
+		});
+	}
+
+	/* language packs: discovery with none and with LANGPACKS installed,
+	 * mapping and indexing of the selected one */
+	char emptyDir[] = "/tmp/sonic-bench-XXXXXX";
+	char packDir[] = "/tmp/sonic-bench-XXXXXX";
+	int packRegressions = 0;
+
+	if (mkdtemp(emptyDir) && mkdtemp(packDir) && write_langpacks(packDir, LANGPACKS)) {
+		wchar_t wEmpty[sizeof(emptyDir)], wPacks[sizeof(packDir)];
+		langPacks packs;
+
+		mbstowcs(wEmpty, emptyDir, sizeof(emptyDir));
+		mbstowcs(wPacks, packDir, sizeof(packDir));
+
+		b.run("langpack_discover_none", [&]() { bench_keep(packs.discover(wEmpty)); });
+		b.run("langpack_discover_50", [&]() { bench_keep(packs.discover(wPacks)); });
+		b.run("langpack_select", [&]() {
+			bench_keep(packs.select(0, UI_ROWS));
+			bench_keep(packs.str(UI_ROWS - 1));
+			packs.select(-1, 0);
+		});
+
+		const benchResult_t *none = b.result("langpack_discover_none");
+		const benchResult_t *full = b.result("langpack_discover_50");
+
+		if (none && full && full->median - none->median > LANGPACK_BUDGET_NS) {
+			fprintf(stderr, "error: %d language packs add %.0f ns to startup (budget %.0f ns)\n",
+				LANGPACKS, full->median - none->median, LANGPACK_BUDGET_NS);
+			packRegressions++;
+		}
+	} else {
+		perror("language packs");
+	}
+	remove_langpacks(packDir, LANGPACKS);
+	rmdir(emptyDir);
+
+	/* controller database: index build, lookups, and a plain search for comparison */
+	std::string padDbText = make_gamepaddb(GAMEPADDB_LINES);
+	std::vector<std::string> padGuids;
+	gamepadDb padDb;
+	char guid[GAMEPADDB_GUID_LENGTH + 1];
+	size_t nextGuid = 0;
+	int padDbErrors = 0;
+
+	for (int i = 0; i < GAMEPADDB_LINES / 3; ++i) {
+		gamepadDb::usb_guid(guid, 0x045E + i, 0x0200 + i);
+		padGuids.push_back(guid);
+	}
+
+	b.run("gamepaddb_index_6000", [&]() { bench_keep(padDb.load(padDbText.data(), padDbText.size())); });
+
+	if (!padDb.load(padDbText.data(), padDbText.size()) || padDb.count() != padGuids.size()) {
+		fprintf(stderr, "error: gamepad database index has %zu of %zu GUIDs\n", padDb.count(), padGuids.size());
+		padDbErrors++;
+	}
+	for (size_t i = 0; i < padGuids.size(); ++i) {
+		if (gamepadDb::name(padDb.find(padGuids[i].c_str())) != "Controller " + std::to_string(i)) {
+			fprintf(stderr, "error: gamepad database lookup of %s failed\n", padGuids[i].c_str());
+			padDbErrors++;
+			break;
+		}
+	}
+
+	b.run("gamepaddb_lookup_hit", [&]() {
+		bench_keep(padDb.find(padGuids[nextGuid].c_str()).size());
+		nextGuid = (nextGuid + 1) % padGuids.size();
+	});
+	gamepadDb::usb_guid(guid, 0xFFFF, 0xFFFF);
+	b.run("gamepaddb_lookup_miss", [&]() { bench_keep(padDb.find(guid).size()); });
+	b.run("gamepaddb_search_hit", [&]() {
+		bench_keep(padDbText.find(padGuids[nextGuid]));
+		nextGuid = (nextGuid + 1) % padGuids.size();
+	});
+
+	/* the same from a mapped file, as the launcher opens it */
+	char padDbTmpl[] = "/tmp/sonic-gamepaddb-XXXXXX";
+
+	fd = mkstemp(padDbTmpl);
+	if (fd == -1) {
+		perror("mkstemp()");
+		return 1;
+	}
+	if (write(fd, padDbText.data(), padDbText.size()) != static_cast<ssize_t>(padDbText.size())) {
+		fprintf(stderr, "error: cannot write `%s'\n", padDbTmpl);
+		padDbErrors++;
+	}
+	close(fd);
+
+	wchar_t padDbFile[sizeof(padDbTmpl)];
+	mbstowcs(padDbFile, padDbTmpl, sizeof(padDbTmpl));
+
+	if (!padDb.open(padDbFile) || padDb.count() != padGuids.size() ||
+		gamepadDb::name(padDb.find(padGuids.back().c_str())) != "Controller " + std::to_string(padGuids.size() - 1))
+	{
+		fprintf(stderr, "error: gamepad database opened from a file doesn't match\n");
+		padDbErrors++;
+	}
+	padDb.close();
+	unlink(padDbTmpl);
+
+	/* metrics on the hot paths, and the export */
+	int metricsErrors = 0;
+	std::string metricsText;
+
+	b.run("metrics_counter_inc", [&]() { metrics::keyCaptureChanged.inc(); });
+	b.run("metrics_histogram_observe", [&]() { metrics::session.observe(1234567); });
+	b.run("metrics_text", [&]() {
+		metricsText.clear();
+		metrics::text(metricsText);
+		bench_keep(metricsText.size());
+	});
+
+	static const char *hotPaths[] = { "metrics_counter_inc", "metrics_histogram_observe" };
+
+	for (size_t i = 0; i < sizeof(hotPaths) / sizeof(*hotPaths); ++i) {
+		const benchResult_t *r = b.result(hotPaths[i]);
+
+		if (r && r->median >= METRICS_HOT_NS) {
+			fprintf(stderr, "error: %s takes %.1f ns, more than %d\n", hotPaths[i], r->median, METRICS_HOT_NS);
+			metricsErrors++;
+		}
+	}
+
+	metricsText.clear();
+	metrics::text(metricsText);
+	if (metricsText.size() < 6 || metricsText.compare(metricsText.size() - 6, 6, "# EOF\n") != 0 ||
+		metricsText.find("sonic_launcher_game_session_seconds_bucket{le=\"+Inf\"}") == std::string::npos)
+	{
+		fprintf(stderr, "error: malformed metrics text\n");
+		metricsErrors++;
+	}
+
+	/* lang.h generator */
+	if (formatLang && langTxt) {
+		if (run_format_lang(formatLang, langTxt)) {
+			b.run("format_lang", [&]() { bench_keep(run_format_lang(formatLang, langTxt)); });
+		} else {
+			fprintf(stderr, "error: cannot run `%s < %s'\n", formatLang, langTxt);
+		}
+	}
+
+	if (out && !b.write(out)) {
+		fprintf(stderr, "error: cannot write `%s'\n", out);
+		return 1;
+	}
+
+	/* a missing baseline fails like in the other benchmark targets */
+	int regressions = baseline ? b.compare(baseline, threshold) : 0;
+
+	if (regressions < 0) {
+		return 1;
+	}
+	if (regressions > 0) {
+		return 2;
+	}
+
+	if (packRegressions > 0 || decodeMismatches > 0 || padDbErrors > 0 || cacheErrors > 0 || metricsErrors > 0) {
+		return 2;
+	}
+
+	return 0;
+}
@@ -0,0 +1,209 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Small statistics-reporting benchmark harness for the native `make bench` build. */
+
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "clock.hpp"
+
+#define BENCH_SAMPLES        25
+#define BENCH_MIN_SAMPLE_US  2000
+
+
+/* keep the compiler from optimizing a value or memory writes away */
+template<typename T>
+static inline void bench_keep(T const &v)
+{
+	asm volatile("" : : "r,m"(v) : "memory");
+}
+
+static inline void bench_clobber(void)
+{
+	asm volatile("" : : : "memory");
+}
+
+typedef struct {
+	std::string name;
+	uint64_t iterations;  /* per sample */
+	double min;           /* all times in nanoseconds per operation */
+	double median;
+	double mean;
+	double p95;
+	double stddev;
+} benchResult_t;
+
+class benchmark
+{
+private:
+	std::vector<benchResult_t> _results;
+	const char *_filter = NULL;
+
+	static double nsPerOp(uint64_t us, uint64_t n) {
+		return static_cast<double>(us) * 1000.0 / static_cast<double>(n);
+	}
+
+public:
+	/* only run benchmarks whose name contains filter */
+	void filter(const char *s) { _filter = s; }
+
+	template<typename F>
+	void run(const char *name, F fn)
+	{
+		std::vector<double> v;
+		benchResult_t r;
+		uint64_t n = 1, t;
+		double sum = 0, sq = 0;
+
+		if (_filter && !strstr(name, _filter)) {
+			return;
+		}
+
+		/* calibrate: one sample should take at least BENCH_MIN_SAMPLE_US */
+		while (true) {
+			t = clock_us();
+			for (uint64_t i = 0; i < n; ++i) {
+				fn();
+			}
+			t = clock_us() - t;
+			if (t >= BENCH_MIN_SAMPLE_US || n >= (1ull << 30)) {
+				break;
+			}
+			n *= (t < BENCH_MIN_SAMPLE_US / 16) ? 16 : 2;
+		}
+
+		for (int s = 0; s < BENCH_SAMPLES; ++s) {
+			t = clock_us();
+			for (uint64_t i = 0; i < n; ++i) {
+				fn();
+			}
+			v.push_back(nsPerOp(clock_us() - t, n));
+		}
+
+		std::sort(v.begin(), v.end());
+
+		for (size_t i = 0; i < v.size(); ++i) {
+			sum += v[i];
+		}
+		r.mean = sum / v.size();
+		for (size_t i = 0; i < v.size(); ++i) {
+			sq += (v[i] - r.mean) * (v[i] - r.mean);
+		}
+
+		r.name = name;
+		r.iterations = n;
+		r.min = v.front();
+		r.median = v[v.size() / 2];
+		r.p95 = v[(v.size() * 95) / 100];
+		r.stddev = sqrt(sq / v.size());
+		_results.push_back(r);
+
+		printf("%-36s %12.1f ns/op  (min %.1f, p95 %.1f, sd %.1f, %llu ops/sample)\n",
+			name, r.median, r.min, r.p95, r.stddev, static_cast<unsigned long long>(n));
+		fflush(stdout);
+	}
+
+	/* NULL if the benchmark didn't run */
+	const benchResult_t *result(const char *name) const
+	{
+		for (size_t i = 0; i < _results.size(); ++i) {
+			if (_results[i].name == name) {
+				return &_results[i];
+			}
+		}
+		return NULL;
+	}
+
+	/* tab separated: name, median, mean, min, p95, stddev, iterations */
+	bool write(const char *file)
+	{
+		FILE *fp = fopen(file, "w");
+
+		if (!fp) {
+			return false;
+		}
+
+		fprintf(fp, "# name\tmedian_ns\tmean_ns\tmin_ns\tp95_ns\tstddev_ns\titerations\n");
+
+		for (size_t i = 0; i < _results.size(); ++i) {
+			const benchResult_t &r = _results[i];
+			fprintf(fp, "%s\t%.2f\t%.2f\t%.2f\t%.2f\t%.2f\t%llu\n", r.name.c_str(), r.median, r.mean,
+				r.min, r.p95, r.stddev, static_cast<unsigned long long>(r.iterations));
+		}
+
+		return fclose(fp) == 0;
+	}
+
+	/* compare medians against a file written by write();
+	 * returns the number of benchmarks slower than baseline * (1 + threshold),
+	 * or -1 if there's no baseline */
+	int compare(const char *file, double threshold)
+	{
+		FILE *fp = fopen(file, "r");
+		char line[512], name[256];
+		double median;
+		int regressions = 0;
+
+		if (!fp) {
+			fprintf(stderr, "error: no baseline in %s, run `make bench-baseline` to create one\n", file);
+			return -1;
+		}
+
+		printf("\ncomparison against %s (threshold %+.0f%%):\n", file, threshold * 100);
+
+		while (fgets(line, sizeof(line), fp)) {
+			if (line[0] == '#' || sscanf(line, "%255[^\t]\t%lf", name, &median) != 2) {
+				continue;
+			}
+
+			for (size_t i = 0; i < _results.size(); ++i) {
+				if (_results[i].name != name) {
+					continue;
+				}
+
+				double change = (_results[i].median - median) / median;
+				bool bad = (change > threshold);
+
+				printf("  %-36s %10.1f -> %10.1f ns/op  %+6.1f%%%s\n", name, median,
+					_results[i].median, change * 100, bad ? "  REGRESSION" : "");
+				regressions += bad ? 1 : 0;
+			}
+		}
+
+		fclose(fp);
+		return regressions;
+	}
+};
+
+#endif  /* BENCH_HPP */
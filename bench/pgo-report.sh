@@ -0,0 +1,145 @@
+#!/bin/sh
+# Compares the plain and the profile-guided build (make release-pgo):
+# binary size, and the startup times and page faults the launcher
+# reports in its metrics file (see src/metrics.hpp), median of -n runs
+# per build under Xvfb.
+#
+# usage: pgo-report.sh [-o results.tsv] [-n runs] plain.exe pgo.exe
+#
+# The launcher is a Win32 program and needs Wine; $RUNNER is the Wine
+# command, "wine" by default.
+
+set -e
+
+out=
+runs=15
+timeout=30
+
+while getopts o:n: opt; do
+	case $opt in
+	o) out="$OPTARG";;
+	n) runs="$OPTARG";;
+	*) exit 1;;
+	esac
+done
+shift $((OPTIND - 1))
+
+if [ $# -ne 2 ]; then
+	echo "usage: $0 [-o results.tsv] [-n runs] plain.exe pgo.exe" >&2
+	exit 1
+fi
+
+RUNNER="${RUNNER:-wine}"
+
+work="$(mktemp -d)"
+xvfb=
+
+cleanup() {
+	if [ -n "$xvfb" ]; then
+		kill $xvfb 2>/dev/null || true
+		wait $xvfb 2>/dev/null || true
+	fi
+	rm -rf "$work"
+}
+trap cleanup EXIT INT TERM
+
+if [ -z "$BENCH_DISPLAY" ]; then
+	display=:95
+	Xvfb $display -screen 0 1280x1024x24 -nolisten tcp >/dev/null 2>&1 &
+	xvfb=$!
+	sleep 1
+	if ! kill -0 $xvfb 2>/dev/null; then
+		echo "error: cannot start Xvfb" >&2
+		exit 1
+	fi
+else
+	display="$BENCH_DISPLAY"
+fi
+
+# is_ready <metrics file>
+is_ready() {
+	[ -f "$1" ] && awk '$1 == "sonic_launcher_startup_phase_seconds{phase=\"ready\"}" && $2 > 0 { r = 1 }
+		END { exit !r }' "$1"
+}
+
+# run_once <dir>: prints "<first_paint us> <ready us> <page faults>"
+run_once() {
+	metrics="$1/metrics.prom"
+	rm -f "$metrics"
+
+	(cd "$1" && SONICLAUNCHER_METRICS="$metrics" DISPLAY="$display" exec $RUNNER ./SonicLauncher.exe) >/dev/null 2>&1 &
+	pid=$!
+
+	# the file is rewritten on every state change, ready is the last one
+	waited=0
+	while ! is_ready "$metrics"; do
+		if ! kill -0 $pid 2>/dev/null || [ $waited -ge $((timeout * 20)) ]; then
+			kill $pid 2>/dev/null || true
+			wait $pid 2>/dev/null || true
+			echo "error: launcher didn't become ready" >&2
+			return 1
+		fi
+		sleep 0.05
+		waited=$((waited + 1))
+	done
+
+	# single instance: the next run must not find this one still alive
+	kill $pid 2>/dev/null || true
+	wait $pid 2>/dev/null || true
+
+	awk '
+		$1 == "sonic_launcher_startup_phase_seconds{phase=\"first_paint\"}" { paint = $2 * 1000000 }
+		$1 == "sonic_launcher_startup_phase_seconds{phase=\"ready\"}" { ready = $2 * 1000000 }
+		$1 == "sonic_launcher_startup_page_faults" { faults = $2 }
+		END { printf "%d %d %d\n", paint, ready, faults }' "$metrics"
+}
+
+# median < samples
+median() {
+	sort -n | awk '{ v[NR] = $1 } END { print v[int((NR - 1) * 0.5) + 1] }'
+}
+
+# measure <name> <exe>: prints "<size> <first_paint> <ready> <faults>"
+measure() {
+	mkdir -p "$work/$1"
+	cp "$2" "$work/$1/SonicLauncher.exe"
+
+	# warm up the page cache and the wine prefix
+	run_once "$work/$1" >/dev/null
+
+	: > "$work/$1/samples"
+	i=0
+	while [ $i -lt $runs ]; do
+		run_once "$work/$1" >> "$work/$1/samples"
+		i=$((i + 1))
+	done
+
+	printf '%s %s %s %s\n' "$(wc -c < "$2")" \
+		"$(cut -d' ' -f1 "$work/$1/samples" | median)" \
+		"$(cut -d' ' -f2 "$work/$1/samples" | median)" \
+		"$(cut -d' ' -f3 "$work/$1/samples" | median)"
+}
+
+plain="$(measure plain "$1")"
+pgo="$(measure pgo "$2")"
+
+results="$work/results.tsv"
+printf 'name\tplain\tpgo\tchange\n' > "$results"
+echo "$plain $pgo" | awk '
+	function row(name, a, b) {
+		change = (a > 0) ? (b / a - 1) * 100 : 0
+		printf "%s\t%d\t%d\t%+.1f%%\n", name, a, b, change
+	}
+	{
+		row("size_bytes", $1, $5)
+		row("first_paint_us", $2, $6)
+		row("ready_us", $3, $7)
+		row("page_faults", $4, $8)
+	}' >> "$results"
+
+column -t "$results" 2>/dev/null || cat "$results"
+
+if [ -n "$out" ]; then
+	mkdir -p "$(dirname "$out")"
+	cp "$results" "$out"
+fi
@@ -0,0 +1,103 @@
+#!/bin/sh
+# Training workload for the profile-guided build (make release-pgo). Runs
+# a launcher built with PGO=generate under Xvfb through the paths a
+# cabinet takes: startup and the first paint in every language, tab
+# switches and repaints of every view, key rebinds and language switches
+# replayed from an event log (see bench/replay-events.sh), and a
+# -QuickBoot launch. The
+# profiles are written next to the object files when the launcher exits,
+# so every run here has to end on its own.
+#
+# usage: pgo-train.sh launcher.exe events
+#
+# The launcher is a Win32 program and needs Wine; $RUNNER is the Wine
+# command, "wine" by default.
+
+set -e
+
+timeout=300
+
+if [ $# -ne 2 ]; then
+	echo "usage: $0 launcher.exe events" >&2
+	exit 1
+fi
+
+exe="$1"
+events="$2"
+RUNNER="${RUNNER:-wine}"
+
+# without it the rebinds and language switches go untrained
+if [ ! -f "$events" ]; then
+	echo "error: no event log at $events" >&2
+	exit 1
+fi
+
+work="$(mktemp -d)"
+xvfb=
+
+cleanup() {
+	if [ -n "$xvfb" ]; then
+		kill $xvfb 2>/dev/null || true
+		wait $xvfb 2>/dev/null || true
+	fi
+	rm -rf "$work"
+}
+trap cleanup EXIT INT TERM
+
+cp "$exe" "$work/"
+exe="./$(basename "$exe")"
+
+# the game for -QuickBoot: a second launcher finds the first one running,
+# hands its (empty) command line over and exits
+cp "$work/$exe" "$work/Sonic_vis.exe"
+
+if [ -z "$BENCH_DISPLAY" ]; then
+	display=:96
+	Xvfb $display -screen 0 1280x1024x24 -nolisten tcp >/dev/null 2>&1 &
+	xvfb=$!
+	sleep 1
+	if ! kill -0 $xvfb 2>/dev/null; then
+		echo "error: cannot start Xvfb" >&2
+		exit 1
+	fi
+else
+	display="$BENCH_DISPLAY"
+fi
+
+# write_conf <language>: default configuration (see configuration::encode)
+write_conf() {
+	# magic, 640x480, fullscreen, language, controls, vibra, display
+	printf '\235\336\062\001\200\002\340\001\000'"\\$(printf '%03o' "$1")"'\000\000\000' > "$work/main.conf"
+	# left, right, up, down, A, B, X, Y, start
+	printf '\313\000\000\000\315\000\000\000\310\000\000\000\320\000\000\000' >> "$work/main.conf"
+	printf '\071\000\000\000\040\000\000\000\036\000\000\000\037\000\000\000\034\000\000\000' >> "$work/main.conf"
+	# end number
+	printf '\245\006\000\000' >> "$work/main.conf"
+}
+
+# train <what> <args...>
+train() {
+	what="$1"
+	shift
+	echo "  $what"
+	if ! (cd "$work" && DISPLAY="$display" timeout $timeout $RUNNER "$exe" "$@") >/dev/null 2>&1; then
+		echo "error: $what failed" >&2
+		exit 1
+	fi
+}
+
+lang=0
+for name in en de es fr it ja; do
+	write_conf $lang
+	train "startup/$name" -BenchExpose expose.tsv
+	lang=$((lang + 1))
+done
+
+# builds and draws every view in every language
+write_conf 0
+train "views" -BenchRender render.tsv
+
+cp "$events" "$work/events"
+train "replay" -ReplayEvents events replay.tsv
+
+train "quickboot" -QuickBoot
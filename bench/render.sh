@@ -0,0 +1,104 @@
+#!/bin/sh
+# Offscreen render benchmark: runs the launcher with -BenchRender, which
+# draws every view (settings, keyboard and gamepad bindings) in every UI
+# language into an offscreen buffer and reports the draw times and a
+# checksum of the pixels (see bench_render() in src/benchmark.cpp).
+#
+# usage: render.sh [-o results.tsv] [-b baseline.tsv] [-t threshold] launcher.exe
+#
+# The launcher is a Win32 program and needs Wine; $RUNNER is the Wine
+# command, "wine" by default. Exits with 2 if the median draw time of any
+# view is slower than the baseline by more than the threshold (default
+# 0.10), or if its checksum differs from the baseline, and with 1 if the
+# baseline is missing; make bench-render-baseline writes one.
+
+set -e
+
+out=
+baseline=
+threshold=0.10
+timeout=300
+
+while getopts o:b:t: opt; do
+	case $opt in
+	o) out="$OPTARG";;
+	b) baseline="$OPTARG";;
+	t) threshold="$OPTARG";;
+	*) exit 1;;
+	esac
+done
+shift $((OPTIND - 1))
+
+if [ $# -ne 1 ]; then
+	echo "usage: $0 [-o results.tsv] [-b baseline.tsv] [-t threshold] launcher.exe" >&2
+	exit 1
+fi
+
+exe="$1"
+RUNNER="${RUNNER:-wine}"
+
+work="$(mktemp -d)"
+xvfb=
+
+cleanup() {
+	if [ -n "$xvfb" ]; then
+		kill $xvfb 2>/dev/null || true
+		wait $xvfb 2>/dev/null || true
+	fi
+	rm -rf "$work"
+}
+trap cleanup EXIT INT TERM
+
+# the launcher reads main.conf from its own directory; without one
+# the defaults are used, which keeps the checksums comparable
+cp "$exe" "$work/"
+exe="./$(basename "$exe")"
+
+# nothing is shown, but GDI under Wine still needs an X server
+if [ -z "$BENCH_DISPLAY" ]; then
+	display=:98
+	Xvfb $display -screen 0 1280x1024x24 -nolisten tcp >/dev/null 2>&1 &
+	xvfb=$!
+	sleep 1
+	if ! kill -0 $xvfb 2>/dev/null; then
+		echo "error: cannot start Xvfb" >&2
+		exit 1
+	fi
+else
+	display="$BENCH_DISPLAY"
+fi
+
+results="$work/results.tsv"
+
+if ! (cd "$work" && DISPLAY="$display" timeout $timeout $RUNNER "$exe" -BenchRender results.tsv) >/dev/null 2>&1 \
+	|| [ ! -s "$results" ]; then
+	echo "error: -BenchRender failed" >&2
+	exit 1
+fi
+
+column -t "$results" 2>/dev/null || cat "$results"
+
+if [ -n "$out" ]; then
+	mkdir -p "$(dirname "$out")"
+	cp "$results" "$out"
+fi
+
+if [ -n "$baseline" ]; then
+	if [ ! -f "$baseline" ]; then
+		echo "error: no baseline at $baseline" >&2
+		exit 1
+	fi
+	awk -F'\t' -v threshold="$threshold" '
+		FNR == 1 { next }
+		NR == FNR { base[$1] = $2; sum[$1] = $5; next }
+		!($1 in base) { next }
+		$5 != sum[$1] {
+			printf "CHANGED %s: checksum %s -> %s\n", $1, sum[$1], $5
+			failed++
+		}
+		base[$1] > 0 && $2 / base[$1] > 1 + threshold {
+			printf "REGRESSION %s: %d us -> %d us (%+.1f%%)\n", $1, base[$1], $2, ($2 / base[$1] - 1) * 100
+			failed++
+		}
+		END { exit failed ? 2 : 0 }' "$baseline" "$results" || exit 2
+fi
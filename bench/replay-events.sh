@@ -0,0 +1,128 @@
+#!/bin/sh
+# Writes the event log for bench/replay.sh and bench/pgo-train.sh: a
+# session on a fresh install in English, scripted against the window
+# layout in buildWindow() instead of recorded with -RecordEvents, so the
+# workload is the same on every machine. It toggles the settings, picks
+# languages and resolutions, switches tabs and views, and rebinds the
+# movement keys before resetting them, a few times over. The format is
+# the one eventlog_stop() in src/eventlog.cpp writes.
+#
+# usage: replay-events.sh events
+#
+# Update the coordinates here when the layout changes.
+
+set -e
+
+passes=3
+
+if [ $# -ne 1 ]; then
+	echo "usage: $0 events" >&2
+	exit 1
+fi
+
+# FLTK event numbers and state bits, and the log's menu pick
+PUSH=1
+RELEASE=2
+ENTER=3
+LEAVE=4
+KEYDOWN=8
+KEYUP=9
+MOVE=11
+PICK=255
+BUTTON1=16777216
+LEFT_MOUSE=65257
+
+byte() {
+	printf "\\$(printf '%03o' $(($1 & 255)))"
+}
+
+le16() {
+	byte $1
+	byte $(($1 >> 8))
+}
+
+le32() {
+	le16 $(($1 & 65535))
+	le16 $((($1 >> 16) & 65535))
+}
+
+# record <type> <clicks> <is_click> <x> <y> <state> <key>
+record() {
+	byte $1
+	byte $2
+	byte $3
+	byte 0
+	le16 $4
+	le16 $5
+	le32 $6
+	le32 $7
+}
+
+move() {
+	record $MOVE 0 0 $1 $2 0 0
+}
+
+# click <x> <y>
+click() {
+	move $1 $2
+	record $PUSH 0 0 $1 $2 $BUTTON1 $LEFT_MOUSE
+	record $RELEASE 0 1 $1 $2 0 $LEFT_MOUSE
+}
+
+# choose <x> <y> <item>: a MyChoice and what its pulldown returned
+choose() {
+	move $1 $2
+	record $PUSH 0 0 $1 $2 $BUTTON1 $LEFT_MOUSE
+	record $PICK 0 0 0 0 0 $3
+	record $RELEASE 0 1 $1 $2 0 $LEFT_MOUSE
+}
+
+# rebind <x> <y> <key>: click a key button, then press the key
+rebind() {
+	click $1 $2
+	record $KEYDOWN 0 0 $1 $2 0 $3
+	record $KEYUP 0 0 $1 $2 0 $3
+}
+
+session() {
+	record $ENTER 0 0 380 600 0 0
+
+	# "Settings": resolution, fullscreen and language
+	choose 200 124 2
+	choose 200 124 0
+	click 50 162
+	click 50 162
+	choose 200 240 1
+	choose 200 240 0
+
+	# "Player 1": rebind W, A, S, D and reset them
+	click 115 26
+	rebind 218 260 119
+	rebind 114 330 97
+	rebind 218 400 115
+	rebind 318 330 100
+	click 200 114
+
+	# the gamepad view and back
+	choose 200 76 1
+	move 300 300
+	choose 200 76 0
+
+	click 55 26
+	record $LEAVE 0 0 380 650 0 0
+}
+
+{
+	# header: magic, version, language (English)
+	printf 'SLEV'
+	byte 1
+	byte 0
+	byte 0
+	byte 0
+
+	i=0
+	while [ $i -lt $passes ]; do
+		session
+		i=$((i + 1))
+	done
+} > "$1"
@@ -0,0 +1,112 @@
+#!/bin/sh
+# Event handler benchmark: runs the launcher with -ReplayEvents, which
+# feeds a recorded event log to a window that isn't shown and reports the
+# time each event type takes per handling class (see eventlog_replay() in
+# src/eventlog.cpp). make bench-replay scripts the log with
+# bench/replay-events.sh; "SonicLauncher.exe -RecordEvents" records one.
+#
+# usage: replay.sh [-o results.tsv] [-b baseline.tsv] [-t threshold] launcher.exe events
+#
+# The launcher is a Win32 program and needs Wine; $RUNNER is the Wine
+# command, "wine" by default. Exits with 2 if the median of any handler is
+# slower than the baseline by more than the threshold (default 0.10), or
+# if it makes more allocations per event (ALLOCPROF=1 builds only), and
+# with 1 if the baseline is missing; make bench-replay-baseline writes one.
+
+set -e
+
+out=
+baseline=
+threshold=0.10
+timeout=300
+
+while getopts o:b:t: opt; do
+	case $opt in
+	o) out="$OPTARG";;
+	b) baseline="$OPTARG";;
+	t) threshold="$OPTARG";;
+	*) exit 1;;
+	esac
+done
+shift $((OPTIND - 1))
+
+if [ $# -ne 2 ]; then
+	echo "usage: $0 [-o results.tsv] [-b baseline.tsv] [-t threshold] launcher.exe events" >&2
+	exit 1
+fi
+
+exe="$1"
+events="$2"
+RUNNER="${RUNNER:-wine}"
+
+if [ ! -f "$events" ]; then
+	echo "error: no event log at $events, record one with -RecordEvents" >&2
+	exit 1
+fi
+
+work="$(mktemp -d)"
+xvfb=
+
+cleanup() {
+	if [ -n "$xvfb" ]; then
+		kill $xvfb 2>/dev/null || true
+		wait $xvfb 2>/dev/null || true
+	fi
+	rm -rf "$work"
+}
+trap cleanup EXIT INT TERM
+
+# without a main.conf the defaults are used, as when recording on a
+# fresh install
+cp "$exe" "$work/"
+cp "$events" "$work/events"
+exe="./$(basename "$exe")"
+
+# nothing is shown, but GDI under Wine still needs an X server
+if [ -z "$BENCH_DISPLAY" ]; then
+	display=:96
+	Xvfb $display -screen 0 1280x1024x24 -nolisten tcp >/dev/null 2>&1 &
+	xvfb=$!
+	sleep 1
+	if ! kill -0 $xvfb 2>/dev/null; then
+		echo "error: cannot start Xvfb" >&2
+		exit 1
+	fi
+else
+	display="$BENCH_DISPLAY"
+fi
+
+results="$work/results.tsv"
+
+if ! (cd "$work" && DISPLAY="$display" timeout $timeout $RUNNER "$exe" -ReplayEvents events results.tsv) >/dev/null 2>&1 \
+	|| [ ! -s "$results" ]; then
+	echo "error: -ReplayEvents failed" >&2
+	exit 1
+fi
+
+column -t "$results" 2>/dev/null || cat "$results"
+
+if [ -n "$out" ]; then
+	mkdir -p "$(dirname "$out")"
+	cp "$results" "$out"
+fi
+
+if [ -n "$baseline" ]; then
+	if [ ! -f "$baseline" ]; then
+		echo "error: no baseline at $baseline" >&2
+		exit 1
+	fi
+	awk -F'\t' -v threshold="$threshold" '
+		FNR == 1 { next }
+		NR == FNR { base[$1] = $3; allocs[$1] = $7; next }
+		!($1 in base) { next }
+		allocs[$1] != "-" && $7 != "-" && $7 > allocs[$1] {
+			printf "ALLOCS %s: %s -> %s per event\n", $1, allocs[$1], $7
+			failed++
+		}
+		base[$1] > 0 && $3 / base[$1] > 1 + threshold {
+			printf "REGRESSION %s: %d ns -> %d ns (%+.1f%%)\n", $1, base[$1], $3, ($3 / base[$1] - 1) * 100
+			failed++
+		}
+		END { exit failed ? 2 : 0 }' "$baseline" "$results" || exit 2
+fi
@@ -0,0 +1,219 @@
+#!/bin/sh
+# End-to-end startup benchmark: starts the launcher under Xvfb once per
+# language and measures the time from process start to the first painted
+# frame and to the first idle pass of the event loop. The launcher reports
+# both through $SONICLAUNCHER_STARTUP_MARKS (see startup_mark() in
+# src/trace.cpp).
+#
+# usage: startup.sh [-o results.tsv] [-b baseline.tsv] [-t threshold] [-n runs] [-c cpus] [-p] launcher.exe
+#
+# The launcher is a Win32 program and needs Wine; $RUNNER is the Wine
+# command, "wine" by default. -c pins it to a taskset(1) CPU list, e.g.
+# "0,1" for the 2-core cabinet profile. Exits with 2 if the median of any
+# measurement is slower than the baseline by more than the threshold
+# (default 0.10), and with 1 if the baseline is missing; make
+# bench-startup-baseline writes one.
+#
+# -p is for a launcher built with PIXELCACHE=1: every language is measured
+# cold, with the pixel cache deleted before each run, and warm, with the
+# cache the previous run wrote.
+
+set -e
+
+out=
+baseline=
+threshold=0.10
+runs=15
+cpus=
+pixelcache=
+timeout=30
+
+while getopts o:b:t:n:c:p opt; do
+	case $opt in
+	o) out="$OPTARG";;
+	b) baseline="$OPTARG";;
+	t) threshold="$OPTARG";;
+	n) runs="$OPTARG";;
+	c) cpus="$OPTARG";;
+	p) pixelcache=1;;
+	*) exit 1;;
+	esac
+done
+shift $((OPTIND - 1))
+
+if [ $# -ne 1 ]; then
+	echo "usage: $0 [-o results.tsv] [-b baseline.tsv] [-t threshold] [-n runs] [-c cpus] [-p] launcher.exe" >&2
+	exit 1
+fi
+
+exe="$1"
+RUNNER="${RUNNER:-wine}"
+
+if [ -n "$cpus" ]; then
+	RUNNER="taskset -c $cpus $RUNNER"
+fi
+
+work="$(mktemp -d)"
+xvfb=
+
+cleanup() {
+	if [ -n "$xvfb" ]; then
+		kill $xvfb 2>/dev/null || true
+		wait $xvfb 2>/dev/null || true
+	fi
+	rm -rf "$work"
+}
+trap cleanup EXIT INT TERM
+
+# the launcher reads main.conf from its own directory
+cp "$exe" "$work/"
+exe="./$(basename "$exe")"
+
+# private X server, so a desktop session doesn't skew the numbers
+if [ -z "$BENCH_DISPLAY" ]; then
+	display=:97
+	Xvfb $display -screen 0 1280x1024x24 -nolisten tcp >/dev/null 2>&1 &
+	xvfb=$!
+	sleep 1
+	if ! kill -0 $xvfb 2>/dev/null; then
+		echo "error: cannot start Xvfb" >&2
+		exit 1
+	fi
+else
+	display="$BENCH_DISPLAY"
+fi
+
+# write_conf <language>: default configuration (see configuration::encode)
+write_conf() {
+	# magic, 640x480, fullscreen, language, controls, vibra, display
+	printf '\235\336\062\001\200\002\340\001\000'"\\$(printf '%03o' "$1")"'\000\000\000' > "$work/main.conf"
+	# left, right, up, down, A, B, X, Y, start
+	printf '\313\000\000\000\315\000\000\000\310\000\000\000\320\000\000\000' >> "$work/main.conf"
+	printf '\071\000\000\000\040\000\000\000\036\000\000\000\037\000\000\000\034\000\000\000' >> "$work/main.conf"
+	# end number
+	printf '\245\006\000\000' >> "$work/main.conf"
+}
+
+# relative to the launcher's directory, so it means the same to Wine
+cache=pixels.cache
+
+last=ready
+if [ -n "$pixelcache" ]; then
+	last=pixels_saved
+fi
+
+drop_cache() {
+	rm -f "$work/$cache" "$work/$cache.new"
+}
+
+now_us() {
+	date +%s%6N
+}
+
+# run_once: prints "<first_paint us> <ready us>" relative to process start
+run_once() {
+	marks="$work/marks"
+	rm -f "$marks"
+
+	start=$(now_us)
+	(cd "$work" && SONICLAUNCHER_STARTUP_MARKS="$marks" SONICLAUNCHER_PIXEL_CACHE="$cache" DISPLAY="$display" \
+		exec $RUNNER "$exe") >/dev/null 2>&1 &
+	pid=$!
+
+	# with -p, until the launcher has written the pixel cache
+	waited=0
+	while ! grep -q "^$last " "$marks" 2>/dev/null; do
+		if ! kill -0 $pid 2>/dev/null || [ $waited -ge $((timeout * 20)) ]; then
+			kill $pid 2>/dev/null || true
+			wait $pid 2>/dev/null || true
+			echo "error: launcher didn't become ready" >&2
+			return 1
+		fi
+		sleep 0.05
+		waited=$((waited + 1))
+	done
+
+	# single instance: the next run must not find this one still alive
+	kill $pid 2>/dev/null || true
+	wait $pid 2>/dev/null || true
+
+	awk -v start=$start '
+		$1 == "first_paint" { paint = $2 - start }
+		$1 == "ready" { ready = $2 - start }
+		END { print paint, ready }' "$marks"
+}
+
+# percentiles <name> < samples: prints "<name>\t<p50>\t<p90>\t<max>"
+percentiles() {
+	sort -n | awk -v name="$1" '
+		{ v[NR] = $1 }
+		END {
+			p50 = v[int((NR - 1) * 0.5) + 1]
+			p90 = v[int((NR - 1) * 0.9) + 1]
+			printf "%s\t%d\t%d\t%d\n", name, p50, p90, v[NR]
+		}'
+}
+
+results="$work/results.tsv"
+printf 'name\tp50_us\tp90_us\tmax_us\n' > "$results"
+
+languages="en de es fr it ja"
+lang=0
+
+# measure <row suffix> <cold>: $runs runs of the current language
+measure() {
+	: > "$work/samples"
+	i=0
+	while [ $i -lt $runs ]; do
+		if [ -n "$2" ]; then
+			drop_cache
+		fi
+		run_once >> "$work/samples"
+		i=$((i + 1))
+	done
+
+	cut -d' ' -f1 "$work/samples" | percentiles "first_paint/$name$1" >> "$results"
+	cut -d' ' -f2 "$work/samples" | percentiles "ready/$name$1" >> "$results"
+}
+
+for name in $languages; do
+	write_conf $lang
+	# warm up the page cache and the wine prefix
+	drop_cache
+	run_once >/dev/null
+
+	if [ -n "$pixelcache" ]; then
+		measure /cold 1
+		# leaves the cache of the last cold run for the warm ones
+		measure /warm
+	else
+		measure ""
+	fi
+	lang=$((lang + 1))
+done
+
+column -t "$results" 2>/dev/null || cat "$results"
+
+if [ -n "$out" ]; then
+	mkdir -p "$(dirname "$out")"
+	cp "$results" "$out"
+fi
+
+if [ -n "$baseline" ]; then
+	if [ ! -f "$baseline" ]; then
+		echo "error: no baseline at $baseline" >&2
+		exit 1
+	fi
+	# compare medians, as with the microbenchmarks
+	awk -F'\t' -v threshold="$threshold" '
+		FNR == 1 { next }
+		NR == FNR { base[$1] = $2; next }
+		($1 in base) && base[$1] > 0 {
+			ratio = $2 / base[$1]
+			if (ratio > 1 + threshold) {
+				printf "REGRESSION %s: %d us -> %d us (%+.1f%%)\n", $1, base[$1], $2, (ratio - 1) * 100
+				failed++
+			}
+		}
+		END { exit failed ? 2 : 0 }' "$baseline" "$results" || exit 2
+fi
@@ -0,0 +1,596 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef SL_ALLOCPROF
+
+#ifdef _WIN32
+#include <windows.h>
+#include <malloc.h>
+#else
+#include <dlfcn.h>
+#include <malloc.h>
+#include <pthread.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "allocprof.hpp"
+
+#define ALLOCPROF_PHASES  16
+#define ALLOCPROF_SITES   64
+#define ALLOCPROF_TOP     10
+#define ALLOCPROF_SAMPLE  16  /* default sampling interval */
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#define CALLER()  _ReturnAddress()
+#else
+#define CALLER()  __builtin_return_address(0)
+#endif
+
+#ifdef __GNUC__
+/* the originals, with -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc,--wrap=free */
+extern "C" {
+	void *__real_malloc(size_t size);
+	void *__real_calloc(size_t num, size_t size);
+	void *__real_realloc(void *ptr, size_t size);
+	void __real_free(void *ptr);
+}
+#define sys_malloc  __real_malloc
+#define sys_free    __real_free
+#else
+#define sys_malloc  malloc
+#define sys_free    free
+#endif
+
+
+typedef struct {
+	std::atomic<void *> addr;
+	std::atomic<unsigned int> count;
+} allocSite_t;
+
+typedef struct {
+	const char *name;
+	std::atomic<unsigned int> runs;
+	std::atomic<uint64_t> allocs;
+	std::atomic<uint64_t> frees;
+	std::atomic<uint64_t> bytes;
+	std::atomic<int64_t> peak;  /* highest growth of the live bytes during a run */
+	int64_t base;  /* live bytes when the current run started */
+	allocSite_t sites[ALLOCPROF_SITES];
+	std::atomic<unsigned int> dropped;
+} allocPhase_t;
+
+/* phase 0 collects everything outside of a phase: static initialization,
+ * idle time, other threads */
+static allocPhase_t phases[ALLOCPROF_PHASES];
+static std::atomic<unsigned int> phaseCount(1);
+
+/* the running phase and the thread it belongs to; a thread_local would
+ * do, but MinGW's emulated TLS allocates on a thread's first access,
+ * from inside the hooks */
+static std::atomic<unsigned int> current(0);
+static std::atomic<uintptr_t> currentThread(0);
+static std::atomic<int64_t> live(0);
+static std::atomic<uint64_t> total(0);
+static std::atomic<unsigned int> sampleTick(0);
+static unsigned int sampleEvery = ALLOCPROF_SAMPLE;
+static bool registered = false;
+static bool dumped = false;
+
+
+static size_t block_size(void *ptr)
+{
+#ifdef _WIN32
+	return _msize(ptr);
+#else
+	return malloc_usable_size(ptr);
+#endif
+}
+
+static uintptr_t thread_id(void)
+{
+#ifdef _WIN32
+	return GetCurrentThreadId();
+#else
+	return static_cast<uintptr_t>(pthread_self());
+#endif
+}
+
+/* the phase the calling thread is in */
+static allocPhase_t *phase(void)
+{
+	unsigned int i = current.load(std::memory_order_acquire);
+
+	if (i != 0 && currentThread.load(std::memory_order_relaxed) != thread_id()) {
+		i = 0;
+	}
+	return &phases[i];
+}
+
+static void sample(allocPhase_t *p, void *site)
+{
+	unsigned int h = static_cast<unsigned int>((reinterpret_cast<uintptr_t>(site) >> 2) * 2654435761u);
+
+	for (unsigned int i = 0; i < ALLOCPROF_SITES; ++i) {
+		allocSite_t *s = &p->sites[(h + i) % ALLOCPROF_SITES];
+		void *expected = NULL;
+
+		if (s->addr.load(std::memory_order_relaxed) == site ||
+			s->addr.compare_exchange_strong(expected, site) || expected == site)
+		{
+			s->count.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+	}
+
+	p->dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+/* doesn't allocate, so it's safe to call from the hooks */
+static void record_alloc(size_t size, void *site)
+{
+	allocPhase_t *p = phase();
+	int64_t now = live.fetch_add(size, std::memory_order_relaxed) + size;
+
+	p->allocs.fetch_add(1, std::memory_order_relaxed);
+	p->bytes.fetch_add(size, std::memory_order_relaxed);
+	total.fetch_add(1, std::memory_order_relaxed);
+
+	if (now - p->base > p->peak.load(std::memory_order_relaxed)) {
+		p->peak.store(now - p->base, std::memory_order_relaxed);
+	}
+
+	if (sampleTick.fetch_add(1, std::memory_order_relaxed) % sampleEvery == 0) {
+		sample(p, site);
+	}
+}
+
+static void record_free(size_t size)
+{
+	allocPhase_t *p = phase();
+
+	p->frees.fetch_add(1, std::memory_order_relaxed);
+	live.fetch_sub(size, std::memory_order_relaxed);
+}
+
+static void *counted_malloc(size_t size, void *site)
+{
+	void *ptr = sys_malloc(size);
+
+	if (ptr) {
+		record_alloc(block_size(ptr), site);
+	}
+	return ptr;
+}
+
+static void counted_free(void *ptr)
+{
+	if (ptr) {
+		record_free(block_size(ptr));
+		sys_free(ptr);
+	}
+}
+
+/* for the over-aligned operator new; _aligned_malloc() blocks need
+ * their own free */
+static void *counted_aligned_malloc(size_t size, size_t align, void *site)
+{
+	void *ptr;
+
+#ifdef _WIN32
+	if ((ptr = _aligned_malloc(size, align)) != NULL) {
+		record_alloc(_aligned_msize(ptr, align, 0), site);
+	}
+#else
+	if (posix_memalign(&ptr, align, size) != 0) {
+		ptr = NULL;
+	} else {
+		record_alloc(block_size(ptr), site);
+	}
+#endif
+	return ptr;
+}
+
+static void counted_aligned_free(void *ptr, size_t align)
+{
+#ifdef _WIN32
+	if (ptr) {
+		record_free(_aligned_msize(ptr, align, 0));
+		_aligned_free(ptr);
+	}
+#else
+	(void)align;
+	counted_free(ptr);
+#endif
+}
+
+#ifdef __GNUC__
+extern "C" {
+
+void *__wrap_malloc(size_t size)
+{
+	return counted_malloc(size, CALLER());
+}
+
+void *__wrap_calloc(size_t num, size_t size)
+{
+	void *ptr = __real_calloc(num, size);
+
+	if (ptr) {
+		record_alloc(block_size(ptr), CALLER());
+	}
+	return ptr;
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+	size_t old = ptr ? block_size(ptr) : 0;
+	void *ret = __real_realloc(ptr, size);
+
+	if (ret) {
+		if (ptr) {
+			record_free(old);
+		}
+		record_alloc(block_size(ret), CALLER());
+	} else if (ptr && size == 0) {
+		/* freed */
+		record_free(old);
+	}
+	return ret;
+}
+
+void __wrap_free(void *ptr)
+{
+	counted_free(ptr);
+}
+
+}  /* extern "C" */
+#endif  /* __GNUC__ */
+
+void *operator new(size_t size)
+{
+	void *ptr = counted_malloc(size ? size : 1, CALLER());
+
+	if (!ptr) {
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void *operator new[](size_t size)
+{
+	void *ptr = counted_malloc(size ? size : 1, CALLER());
+
+	if (!ptr) {
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+	return counted_malloc(size ? size : 1, CALLER());
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+	return counted_malloc(size ? size : 1, CALLER());
+}
+
+void operator delete(void *ptr) noexcept
+{
+	counted_free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+	counted_free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+	counted_free(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept
+{
+	counted_free(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept
+{
+	counted_free(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept
+{
+	counted_free(ptr);
+}
+
+void *operator new(size_t size, std::align_val_t align)
+{
+	void *ptr = counted_aligned_malloc(size ? size : 1, static_cast<size_t>(align), CALLER());
+
+	if (!ptr) {
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void *operator new[](size_t size, std::align_val_t align)
+{
+	void *ptr = counted_aligned_malloc(size ? size : 1, static_cast<size_t>(align), CALLER());
+
+	if (!ptr) {
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void *operator new(size_t size, std::align_val_t align, const std::nothrow_t &) noexcept
+{
+	return counted_aligned_malloc(size ? size : 1, static_cast<size_t>(align), CALLER());
+}
+
+void *operator new[](size_t size, std::align_val_t align, const std::nothrow_t &) noexcept
+{
+	return counted_aligned_malloc(size ? size : 1, static_cast<size_t>(align), CALLER());
+}
+
+void operator delete(void *ptr, std::align_val_t align) noexcept
+{
+	counted_aligned_free(ptr, static_cast<size_t>(align));
+}
+
+void operator delete[](void *ptr, std::align_val_t align) noexcept
+{
+	counted_aligned_free(ptr, static_cast<size_t>(align));
+}
+
+void operator delete(void *ptr, size_t, std::align_val_t align) noexcept
+{
+	counted_aligned_free(ptr, static_cast<size_t>(align));
+}
+
+void operator delete[](void *ptr, size_t, std::align_val_t align) noexcept
+{
+	counted_aligned_free(ptr, static_cast<size_t>(align));
+}
+
+void operator delete(void *ptr, std::align_val_t align, const std::nothrow_t &) noexcept
+{
+	counted_aligned_free(ptr, static_cast<size_t>(align));
+}
+
+void operator delete[](void *ptr, std::align_val_t align, const std::nothrow_t &) noexcept
+{
+	counted_aligned_free(ptr, static_cast<size_t>(align));
+}
+
+static void dump_atexit(void)
+{
+	if (!dumped) {
+		allocprof::dump();
+	}
+}
+
+/* only called from the UI thread */
+bool allocprof::begin(const char *name)
+{
+	unsigned int i, n = phaseCount.load();
+
+	if (current.load() != 0) {
+		return false;
+	}
+
+	if (!registered) {
+		const char *env = getenv("SONICLAUNCHER_ALLOCPROF_SAMPLE");
+
+		if (env && atoi(env) > 0) {
+			sampleEvery = atoi(env);
+		}
+		atexit(dump_atexit);
+		registered = true;
+	}
+
+	for (i = 1; i < n; ++i) {
+		if (strcmp(phases[i].name, name) == 0) {
+			break;
+		}
+	}
+
+	if (i == n) {
+		if (n == ALLOCPROF_PHASES) {
+			return false;
+		}
+		phases[i].name = name;
+		phaseCount.store(n + 1);
+	}
+
+	phases[i].runs.fetch_add(1);
+	phases[i].base = live.load();
+	currentThread.store(thread_id());
+	current.store(i, std::memory_order_release);
+
+	return true;
+}
+
+void allocprof::end(const char *name)
+{
+	unsigned int i = current.load();
+
+	if (i != 0 && currentThread.load() == thread_id() && strcmp(phases[i].name, name) == 0) {
+		current.store(0);
+	}
+}
+
+int allocprof::exit_code(int rv)
+{
+	dumped = true;
+	return dump() ? rv : ALLOCPROF_OVER_BUDGET;
+}
+
+uint64_t allocprof::allocations()
+{
+	return total.load(std::memory_order_relaxed);
+}
+
+/* "module+0xoffset", for addr2line on an unstripped binary */
+static void site_name(void *addr, char *buf, size_t size)
+{
+#ifdef _WIN32
+	HMODULE mod = NULL;
+	char path[MAX_PATH];
+	const char *base;
+
+	if (GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+		reinterpret_cast<LPCSTR>(addr), &mod) && GetModuleFileNameA(mod, path, sizeof(path)) > 0)
+	{
+		base = strrchr(path, '\\') ? strrchr(path, '\\') + 1 : path;
+		snprintf(buf, size, "%s+0x%lx", base, static_cast<unsigned long>(
+			reinterpret_cast<uintptr_t>(addr) - reinterpret_cast<uintptr_t>(mod)));
+		return;
+	}
+#else
+	Dl_info info;
+
+	if (dladdr(addr, &info) && info.dli_fname) {
+		const char *base = strrchr(info.dli_fname, '/') ? strrchr(info.dli_fname, '/') + 1 : info.dli_fname;
+		snprintf(buf, size, "%s+0x%lx", base, static_cast<unsigned long>(
+			reinterpret_cast<uintptr_t>(addr) - reinterpret_cast<uintptr_t>(info.dli_fbase)));
+		return;
+	}
+#endif
+	snprintf(buf, size, "%p", addr);
+}
+
+/* allocations per run allowed for a phase, from the file in
+ * $SONICLAUNCHER_ALLOC_BUDGET with "<phase>\t<allocations>" lines;
+ * returns -1 if there's none */
+static long budget(const char *phase)
+{
+	const char *file = getenv("SONICLAUNCHER_ALLOC_BUDGET");
+	char line[128], name[64];
+	long n, ret = -1;
+	FILE *fp;
+
+	if (!file || !*file || (fp = fopen(file, "r")) == NULL) {
+		return -1;
+	}
+
+	while (fgets(line, sizeof(line), fp)) {
+		if (sscanf(line, "%63[^\t]\t%ld", name, &n) == 2 && strcmp(name, phase) == 0) {
+			ret = n;
+			break;
+		}
+	}
+
+	fclose(fp);
+	return ret;
+}
+
+bool allocprof::dump()
+{
+	const char *file = getenv("SONICLAUNCHER_ALLOCPROF");
+	unsigned int n = phaseCount.load();
+	bool withinBudget = true;
+	FILE *fp;
+
+	if (!file || !*file) {
+		file = "SonicLauncher.allocprof.txt";
+	}
+
+	if ((fp = fopen(file, "w")) == NULL) {
+		return false;
+	}
+
+	fprintf(fp, "phase\truns\tallocs\tfrees\tbytes\tpeak\tallocs_per_run\tbytes_per_run\tbudget\n");
+
+	for (unsigned int i = 0; i < n; ++i) {
+		const allocPhase_t *p = &phases[i];
+		const char *name = (i == 0) ? "other" : p->name;
+		unsigned int runs = std::max(p->runs.load(), 1u);
+		unsigned long long allocs = p->allocs.load();
+		long limit = (i == 0) ? -1 : budget(name);
+		const char *status = "-";
+
+		if (limit >= 0) {
+			if (allocs / runs > static_cast<unsigned long long>(limit)) {
+				status = "OVER";
+				withinBudget = false;
+			} else {
+				status = "ok";
+			}
+		}
+
+		fprintf(fp, "%s\t%u\t%llu\t%llu\t%llu\t%lld\t%llu\t%llu\t%s\n", name, p->runs.load(), allocs,
+			static_cast<unsigned long long>(p->frees.load()), static_cast<unsigned long long>(p->bytes.load()),
+			static_cast<long long>(p->peak.load()), allocs / runs,
+			static_cast<unsigned long long>(p->bytes.load()) / runs, status);
+	}
+
+	fprintf(fp, "\n# call sites, 1 in %u allocations sampled\nphase\tsite\tsamples\n", sampleEvery);
+
+	for (unsigned int i = 0; i < n; ++i) {
+		const allocPhase_t *p = &phases[i];
+		std::pair<unsigned int, void *> top[ALLOCPROF_SITES];
+		unsigned int count = 0;
+		char buf[512];
+
+		for (unsigned int j = 0; j < ALLOCPROF_SITES; ++j) {
+			if (p->sites[j].addr.load()) {
+				top[count++] = std::make_pair(p->sites[j].count.load(), p->sites[j].addr.load());
+			}
+		}
+		std::sort(top, top + count, [] (const std::pair<unsigned int, void *> &a, const std::pair<unsigned int, void *> &b) {
+			return a.first > b.first;
+		});
+
+		for (unsigned int j = 0; j < count && j < ALLOCPROF_TOP; ++j) {
+			site_name(top[j].second, buf, sizeof(buf));
+			fprintf(fp, "%s\t%s\t%u\n", (i == 0) ? "other" : p->name, buf, top[j].first);
+		}
+
+		if (p->dropped.load() > 0) {
+			fprintf(fp, "%s\t(table full)\t%u\n", (i == 0) ? "other" : p->name, p->dropped.load());
+		}
+	}
+
+	fclose(fp);
+
+	if (!withinBudget) {
+		fprintf(stderr, "allocprof: allocation budget exceeded, see %s\n", file);
+	}
+
+	return withinBudget;
+}
+
+#endif  /* SL_ALLOCPROF */
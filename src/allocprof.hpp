@@ -0,0 +1,97 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Allocation profiler. Compiled out unless SL_ALLOCPROF is defined
+ * (make ALLOCPROF=1). Replaces the global operator new/delete and, with
+ * the linker's --wrap, malloc/calloc/realloc/free. Allocations are
+ * counted per phase (allocations, frees, bytes, peak of live bytes) and
+ * every n-th call site is sampled. The report is written on exit to
+ * $SONICLAUNCHER_ALLOCPROF or SonicLauncher.allocprof.txt. A launcher
+ * with a phase over its budget exits with ALLOCPROF_OVER_BUDGET, since
+ * a -mwindows build has no stderr to complain to. */
+
+#ifndef ALLOCPROF_HPP
+#define ALLOCPROF_HPP
+
+#ifdef SL_ALLOCPROF
+
+#include <stdint.h>
+
+#define ALLOCPROF_OVER_BUDGET  3
+
+/* phases don't nest: a phase started while another one is running is
+ * counted as part of the running one. Only the thread that started a
+ * phase counts toward it, the others count as "other". */
+#define ALLOCPROF_BEGIN(name)  allocprof::begin(name)
+#define ALLOCPROF_END(name)    allocprof::end(name)
+
+/* count the rest of the current block */
+#define ALLOCPROF_SCOPE(name)  allocScope ALLOCPROF_CONCAT(_allocprof_scope_, __LINE__)(name)
+
+/* allocations so far, in all phases and threads */
+#define ALLOCPROF_ALLOCATIONS()  allocprof::allocations()
+
+/* write the report now; the exit code rv, or ALLOCPROF_OVER_BUDGET if
+ * a phase is over its budget or the report can't be written */
+#define ALLOCPROF_EXIT(rv)  allocprof::exit_code(rv)
+
+#define ALLOCPROF_CONCAT_(a,b)  a##b
+#define ALLOCPROF_CONCAT(a,b)   ALLOCPROF_CONCAT_(a,b)
+
+namespace allocprof
+{
+	bool begin(const char *name);
+	void end(const char *name);
+	bool dump();
+	int exit_code(int rv);
+	uint64_t allocations();
+}
+
+class allocScope
+{
+private:
+	const char *_name;
+	bool _started;
+
+public:
+	allocScope(const char *name) : _name(name), _started(allocprof::begin(name)) {}
+
+	~allocScope() {
+		if (_started) {
+			allocprof::end(_name);
+		}
+	}
+};
+
+#else
+
+#define ALLOCPROF_BEGIN(name)
+#define ALLOCPROF_END(name)
+#define ALLOCPROF_SCOPE(name)
+#define ALLOCPROF_ALLOCATIONS()  0
+#define ALLOCPROF_EXIT(rv)  (rv)
+
+#endif  /* SL_ALLOCPROF */
+
+#endif  /* ALLOCPROF_HPP */
@@ -0,0 +1,179 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Bump allocator for the launcher's UI objects. Widgets, menus and label
+ * strings of one window live in a few large chunks and are released
+ * together when the window is torn down: destructors run newest first,
+ * so child widgets leave their groups before the groups are destroyed. */
+
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_CHUNK_SIZE  (32 * 1024)
+
+
+class arena
+{
+private:
+	typedef struct chunk {
+		struct chunk *next;
+		size_t size;
+		size_t used;
+	} chunk_t;
+
+	typedef struct dtor {
+		void (*fn)(void *);
+		void *obj;
+		struct dtor *next;
+	} dtor_t;
+
+	chunk_t *_chunks = NULL;  /* newest first */
+	dtor_t *_dtors = NULL;  /* newest first */
+	size_t _bytes = 0;
+
+	template<class T>
+	static void destroy(void *p) { static_cast<T *>(p)->~T(); }
+
+	static char *data(chunk_t *c) { return reinterpret_cast<char *>(c) + sizeof(chunk_t); }
+
+	/* offset of the next free address in c with the given alignment */
+	static size_t aligned(chunk_t *c, size_t align) {
+		uintptr_t p = reinterpret_cast<uintptr_t>(data(c) + c->used);
+		return c->used + (((p + align - 1) & ~static_cast<uintptr_t>(align - 1)) - p);
+	}
+
+public:
+	arena() {}
+	arena(const arena &) = delete;
+	arena &operator=(const arena &) = delete;
+
+	~arena() {
+		release();
+		while (_chunks) {
+			chunk_t *next = _chunks->next;
+			free(_chunks);
+			_chunks = next;
+		}
+	}
+
+	/* raw memory, valid until release() */
+	void *alloc(size_t size, size_t align = alignof(max_align_t))
+	{
+		chunk_t *c = _chunks;
+		size_t off = c ? aligned(c, align) : 0;
+
+		if (!c || off + size > c->size) {
+			/* oversized requests get a chunk of their own */
+			size_t n = (size + align > ARENA_CHUNK_SIZE) ? size + align : ARENA_CHUNK_SIZE;
+
+			if ((c = static_cast<chunk_t *>(malloc(sizeof(chunk_t) + n))) == NULL) {
+				throw std::bad_alloc();
+			}
+			c->next = _chunks;
+			c->size = n;
+			c->used = 0;
+			_chunks = c;
+			off = aligned(c, align);
+		}
+
+		c->used = off + size;
+		_bytes += size;
+
+		return data(c) + off;
+	}
+
+	/* construct an object that is destroyed by release() */
+	template<class T, class... Args>
+	T *make(Args&&... args)
+	{
+		void *p = alloc(sizeof(T), alignof(T));
+
+		if (std::is_trivially_destructible<T>::value) {
+			return new (p) T(std::forward<Args>(args)...);
+		}
+
+		dtor_t *d = static_cast<dtor_t *>(alloc(sizeof(dtor_t), alignof(dtor_t)));
+		T *o = new (p) T(std::forward<Args>(args)...);
+
+		d->fn = destroy<T>;
+		d->obj = o;
+		d->next = _dtors;
+		_dtors = d;
+
+		return o;
+	}
+
+	/* zero-initialized array of plain structs, e.g. Fl_Menu_Item */
+	template<class T>
+	T *array(size_t n)
+	{
+		static_assert(std::is_trivially_destructible<T>::value, "arena arrays aren't destroyed");
+		void *p = alloc(sizeof(T) * n, alignof(T));
+		memset(p, 0, sizeof(T) * n);
+		return static_cast<T *>(p);
+	}
+
+	char *strdup(const char *s)
+	{
+		size_t n = strlen(s) + 1;
+		char *p = static_cast<char *>(alloc(n, 1));
+		memcpy(p, s, n);
+		return p;
+	}
+
+	/* destroy all objects and free the memory; one chunk of the default
+	 * size is kept for reuse */
+	void release()
+	{
+		while (_dtors) {
+			dtor_t *d = _dtors;
+			_dtors = d->next;
+			d->fn(d->obj);
+		}
+
+		while (_chunks && (_chunks->next || _chunks->size != ARENA_CHUNK_SIZE)) {
+			chunk_t *c = _chunks;
+			_chunks = c->next;
+			free(c);
+		}
+
+		if (_chunks) {
+			_chunks->used = 0;
+		}
+		_bytes = 0;
+	}
+
+	/* bytes handed out since the last release() */
+	size_t bytes() const { return _bytes; }
+};
+
+#endif  /* ARENA_HPP */
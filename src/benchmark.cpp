@@ -0,0 +1,175 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <windows.h>
+
+#include <algorithm>
+#include <vector>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <FL/fl_draw.H>
+#include <FL/x.H>
+
+#include "benchmark.hpp"
+#include "clock.hpp"
+
+
+/* FNV-1a */
+static uint32_t checksum(const uchar *p, size_t n)
+{
+	uint32_t h = 2166136261u;
+
+	for (size_t i = 0; i < n; ++i) {
+		h = (h ^ p[i]) * 16777619u;
+	}
+	return h;
+}
+
+/* p50, p90 and max of t, which gets sorted */
+static void print_times(FILE *fp, std::vector<uint64_t> &t)
+{
+	size_t n = t.size();
+
+	std::sort(t.begin(), t.end());
+	fprintf(fp, "%llu\t%llu\t%llu",
+		static_cast<unsigned long long>(t[(n - 1) / 2]),
+		static_cast<unsigned long long>(t[(n - 1) * 9 / 10]),
+		static_cast<unsigned long long>(t[n - 1]));
+}
+
+/* repaint everything and wait until GDI is done with it */
+static uint64_t repaint(Fl_Window *win)
+{
+	uint64_t start = clock_us();
+
+	win->redraw();
+	Fl::flush();
+	GdiFlush();
+
+	return clock_us() - start;
+}
+
+bool bench_expose(Fl_Window *win, const benchView_t *views, size_t n,
+	size_t (*cache)(bool on), int iterations, const char *file)
+{
+	std::vector<uint64_t> t(iterations);
+	FILE *fp = fopen(file, "w");
+
+	if (!fp || iterations < 1) {
+		if (fp) {
+			fclose(fp);
+		}
+		return false;
+	}
+
+	fprintf(fp, "view\tcache\tp50_us\tp90_us\tmax_us\tcache_bytes\n");
+
+	for (size_t i = 0; i < n; ++i) {
+		views[i].show();
+		Fl::check();
+
+		for (int on = 0; on <= 1; ++on) {
+			cache(on == 1);
+
+			/* the first paint fills the cache */
+			repaint(win);
+			size_t bytes = cache(on == 1);
+
+			for (int j = 0; j < iterations; ++j) {
+				t[j] = repaint(win);
+			}
+
+			fprintf(fp, "%s\t%s\t", views[i].name, on ? "on" : "off");
+			print_times(fp, t);
+			fprintf(fp, "\t%llu\n", static_cast<unsigned long long>(bytes));
+		}
+	}
+
+	fclose(fp);
+	return true;
+}
+
+bool bench_render(const benchUi_t *ui, const char * const *langs, int nlangs,
+	const benchView_t *views, size_t nviews, int iterations, const char *file)
+{
+	std::vector<uint64_t> t(iterations);
+	bool ok = true;
+	FILE *fp = fopen(file, "w");
+
+	if (!fp || iterations < 1) {
+		if (fp) {
+			fclose(fp);
+		}
+		return false;
+	}
+
+	fprintf(fp, "view\tp50_us\tp90_us\tmax_us\tchecksum\n");
+
+	for (int l = 0; l < nlangs && ok; ++l) {
+		Fl_Window *win = ui->build(l);
+		Fl_Offscreen off = fl_create_offscreen(win->w(), win->h());
+
+		if (!off) {
+			ui->teardown();
+			ok = false;
+			break;
+		}
+
+		for (size_t v = 0; v < nviews; ++v) {
+			views[v].show();
+			fl_begin_offscreen(off);
+
+			/* the first draw fills the caches */
+			ui->draw(win);
+
+			for (int j = 0; j < iterations; ++j) {
+				uint64_t start = clock_us();
+				ui->draw(win);
+				GdiFlush();
+				t[j] = clock_us() - start;
+			}
+
+			uchar *px = fl_read_image(NULL, 0, 0, win->w(), win->h());
+			fl_end_offscreen();
+
+			fprintf(fp, "%s/%s\t", views[v].name, langs[l]);
+			print_times(fp, t);
+
+			if (px) {
+				fprintf(fp, "\t%08x\n", checksum(px, static_cast<size_t>(win->w()) * win->h() * 3));
+				delete[] px;
+			} else {
+				fprintf(fp, "\t-\n");
+				ok = false;
+			}
+		}
+
+		fl_delete_offscreen(off);
+		ui->teardown();
+	}
+
+	fclose(fp);
+	return ok;
+}
@@ -0,0 +1,65 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* In-process UI benchmarks, started from the command line. They write
+ * their results as tab-separated values. -BenchExpose needs the window
+ * on a real (or virtual) display, -BenchRender only draws offscreen. */
+
+#ifndef BENCHMARK_HPP
+#define BENCHMARK_HPP
+
+#include <FL/Fl.H>
+#include <FL/Fl_Window.H>
+
+#include <stddef.h>
+
+#define BENCH_EXPOSE_ITERATIONS  200
+#define BENCH_RENDER_ITERATIONS  100
+
+
+typedef struct {
+	const char *name;
+	void (*show)(void);  /* bring the view to front */
+} benchView_t;
+
+/* hooks into the launcher for -BenchRender */
+typedef struct {
+	Fl_Window *(*build)(int lang);  /* build the window in a UI language without showing it */
+	void (*draw)(Fl_Window *win);   /* draw all of it into the current drawable */
+	void (*teardown)(void);
+} benchUi_t;
+
+/* repaint the whole window a number of times for each view, once without
+ * and once with the cached static layers; cache(on) switches between them
+ * and returns the memory used by the cached layers */
+bool bench_expose(Fl_Window *win, const benchView_t *views, size_t n,
+	size_t (*cache)(bool on), int iterations, const char *file);
+
+/* draw each view in each of nlangs languages into an offscreen buffer;
+ * writes the draw times and a checksum of the pixels, so that changes to
+ * the speed and to the looks show up */
+bool bench_render(const benchUi_t *ui, const char * const *langs, int nlangs,
+	const benchView_t *views, size_t nviews, int iterations, const char *file);
+
+#endif  /* BENCHMARK_HPP */
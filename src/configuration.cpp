@@ -22,29 +22,57 @@
  * SOFTWARE.
  */
 
-#include <windows.h>
-
-#ifndef DIRECTINPUT_VERSION
-#define DIRECTINPUT_VERSION 0x0800
-#endif
-#include <dinput.h>
-
 #include <FL/Fl.H>
 
-#include <algorithm>
-#include <vector>
+#include <string>
 #include <ctype.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <wchar.h>
 
+#include "dikeys.h"
 #include "configuration.hpp"
+#include "metrics.hpp"
+#include "trace.hpp"
 
-#define CONF_SIZE     53
 #define TO_UINT16(x)  static_cast<uint16_t>(((0xFF & x[0]) << 0 | (0xFF & x[1]) << 8))
 #define TO_UINT32(x)  static_cast<uint32_t>(((0xFF & x[0]) << 0 | (0xFF & x[1]) << 8 | (0xFF & x[2]) << 16 | (0xFF & x[3]) << 24))
 
 
+/* field names of the text interface, indexed by key type */
+static const char *keyFields[] =
+{
+	NULL,
+	"key_up",
+	"key_down",
+	"key_left",
+	"key_right",
+	"key_a",
+	"key_b",
+	"key_x",
+	"key_y",
+	"key_start"
+};
+
+
+static FILE *open_file(const wchar_t *path, bool write)
+{
+#ifdef _WIN32
+	FILE *fp = NULL;
+	return (_wfopen_s(&fp, path, write ? L"wb" : L"rb") == 0) ? fp : NULL;
+#else
+	char buf[4096];
+
+	if (wcstombs(buf, path, sizeof(buf)) >= sizeof(buf)) {
+		return NULL;
+	}
+	return fopen(buf, write ? "wb" : "rb");
+#endif
+}
+
+
 const res_t configuration::resList[SZRESLIST] =
 {
 	{640, 480, "640x480"},
@@ -130,23 +158,28 @@ bool configuration::isIgnoredKey(uchar dx)
 	return false;
 }
 
-bool configuration::loadConfig(void)
+bool configuration::hasDuplicateKeys(const uchar *keys, int n)
 {
-	FILE *fp = NULL;
-	unsigned char buf[CONF_SIZE];
-	unsigned char *p = buf;
-	bool resFound = false;
-	std::vector<uchar> v;
+	uint32_t seen[256 / 32] = { 0 };
 
-	if (_wfopen_s(&fp, _confFile, L"rb") != 0) {
-		return false;
-	}
+	for (int i = 0; i < n; ++i) {
+		uint32_t bit = 1u << (keys[i] & 31);
+		uint32_t *word = &seen[keys[i] >> 5];
 
-	if (fread(&buf, 1, CONF_SIZE, fp) != CONF_SIZE) {
-		fclose(fp);
-		return false;
+		if (*word & bit) {
+			return true;
+		}
+		*word |= bit;
 	}
-	fclose(fp);
+
+	return false;
+}
+
+bool configuration::decode(const uchar *buf)
+{
+	const uchar *p = buf;
+	uchar keys[KEYSTART];
+	bool resFound = false;
 
 	/* magic number */
 	if (TO_UINT32(p) != 20111005) {
@@ -180,21 +213,21 @@ bool configuration::loadConfig(void)
 	_display = (p[4] > _screenCount - 1) ? 0 : p[4];
 	p += 5;
 
-#define GETKEY(var,def) \
+#define GETKEY(n,var,def) \
 	var=p[0]; \
 	p+=4; \
 	if (isIgnoredKey(var)) { var=def; } \
-	v.push_back(var);
-
-	GETKEY(_keyLeft, DIK_LEFT);
-	GETKEY(_keyRight, DIK_RIGHT);
-	GETKEY(_keyUp, DIK_UP);
-	GETKEY(_keyDown, DIK_DOWN);
-	GETKEY(_keyA, DIK_SPACE);
-	GETKEY(_keyB, DIK_D);
-	GETKEY(_keyX, DIK_A);
-	GETKEY(_keyY, DIK_S);
-	GETKEY(_keyStart, DIK_RETURN);
+	keys[n]=var;
+
+	GETKEY(0, _keyLeft, DIK_LEFT);
+	GETKEY(1, _keyRight, DIK_RIGHT);
+	GETKEY(2, _keyUp, DIK_UP);
+	GETKEY(3, _keyDown, DIK_DOWN);
+	GETKEY(4, _keyA, DIK_SPACE);
+	GETKEY(5, _keyB, DIK_D);
+	GETKEY(6, _keyX, DIK_A);
+	GETKEY(7, _keyY, DIK_S);
+	GETKEY(8, _keyStart, DIK_RETURN);
 
 #undef GETKEY
 
@@ -203,13 +236,76 @@ bool configuration::loadConfig(void)
 		return false;
 	}
 
-	std::sort(v.begin(), v.end());
-	
-	if (std::unique(v.begin(), v.end()) != v.end()) {
-		/* duplicate keys */
+	return !hasDuplicateKeys(keys, KEYSTART);
+}
+
+void configuration::encode(uchar *buf)
+{
+	uchar *p = buf;
+
+	memset(buf, 0, CONF_SIZE);
+
+	/* magic number (20111005) */
+	p[0] = 0x9D;
+	p[1] = 0xDE;
+	p[2] = 0x32;
+	p[3] = 0x01;
+	p += 4;
+
+	p[0] = static_cast<uchar>(_resW);
+	p[1] = static_cast<uchar>(_resW >> 8);
+	p[2] = static_cast<uchar>(_resH);
+	p[3] = static_cast<uchar>(_resH >> 8);
+	p += 4;
+
+	p[0] = _fullscreen;
+	p[1] = _language;
+	p[2] = _controls;
+	p[3] = _vibra;
+	p[4] = _display;
+	p += 5;
+
+	/* the DIK_* values don't exceed 255, so it's not a real uint32_t value */
+	p[0] = _keyLeft;
+	p[4] = _keyRight;
+	p[8] = _keyUp;
+	p[12] = _keyDown;
+	p[16] = _keyA;
+	p[20] = _keyB;
+	p[24] = _keyX;
+	p[28] = _keyY;
+	p[32] = _keyStart;
+	p += 36;
+
+	/* end number (1701) */
+	p[0] = 0xA5;
+	p[1] = 0x06;
+}
+
+bool configuration::loadConfig(void)
+{
+	TRACE_SCOPE("configuration::loadConfig");
+	FILE *fp = NULL;
+	uchar buf[CONF_SIZE];
+
+	if ((fp = open_file(_confFile, false)) == NULL) {
+		metrics::configLoadMissing.inc();
+		return false;
+	}
+
+	if (fread(&buf, 1, CONF_SIZE, fp) != CONF_SIZE) {
+		fclose(fp);
+		metrics::configLoadInvalid.inc();
 		return false;
 	}
+	fclose(fp);
 
+	if (!decode(buf)) {
+		metrics::configLoadInvalid.inc();
+		return false;
+	}
+
+	metrics::configLoadOk.inc();
 	return true;
 }
 
@@ -241,52 +337,22 @@ void configuration::loadDefaultConfig(void)
 
 bool configuration::saveConfig(void)
 {
+	TRACE_SCOPE("configuration::saveConfig");
 	FILE *fp = NULL;
+	uchar buf[CONF_SIZE];
+	bool rv;
 
-	if (_wfopen_s(&fp, _confFile, L"wb") != 0) {
+	if ((fp = open_file(_confFile, true)) == NULL) {
+		metrics::configSaveError.inc();
 		return false;
 	}
 
-	/* magic number (20111005) */
-	putc(0x9D, fp);
-	putc(0xDE, fp);
-	putc(0x32, fp);
-	putc(0x01, fp);
-
-	putc(static_cast<uchar>(_resW), fp);
-	putc(static_cast<uchar>(_resW >> 8), fp);
-	putc(static_cast<uchar>(_resH), fp);
-	putc(static_cast<uchar>(_resH >> 8), fp);
-
-	putc(_fullscreen, fp);
-	putc(_language, fp);
-	putc(_controls, fp);
-	putc(_vibra, fp);
-	putc(_display, fp);
-
-	/* the DIK_* values don't exceed 255, so it's not a real uint32_t value */
-#define SETKEY(x)  putc(x, fp); putc(0x00, fp); putc(0x00, fp); putc(0x00, fp);
-
-	SETKEY(_keyLeft);
-	SETKEY(_keyRight);
-	SETKEY(_keyUp);
-	SETKEY(_keyDown);
-	SETKEY(_keyA);
-	SETKEY(_keyB);
-	SETKEY(_keyX);
-	SETKEY(_keyY);
-	SETKEY(_keyStart);
-
-#undef SETKEY
-
-	/* end number (1701) */
-	putc(0xA5, fp);
-	putc(0x06, fp);
-	putc(0x00, fp);
-	putc(0x00, fp);
+	encode(buf);
+	rv = (fwrite(buf, 1, CONF_SIZE, fp) == CONF_SIZE);
+	rv = (fclose(fp) == 0) && rv;
 
-	fclose(fp);
-	return true;
+	(rv ? metrics::configSaveOk : metrics::configSaveError).inc();
+	return rv;
 }
 
 /* get key */
@@ -312,7 +378,7 @@ uchar configuration::key(int type)
 		return _keyY;
 	case KEYSTART:
 		return _keyStart;
-	default:
+	default:
 		break;
 	}
 
@@ -351,13 +417,106 @@ void configuration::key(uchar n, int type)
 	case KEYSTART:
 		_keyStart = n;
 		break;
-	default:
+	default:
 		break;
 	}
 }
 
+std::string configuration::dump(void)
+{
+	char buf[64];
+	std::string s;
+
+	snprintf(buf, sizeof(buf), "resolution=%ux%u\n", _resW, _resH);
+	s = buf;
+	snprintf(buf, sizeof(buf), "fullscreen=%u\n", _fullscreen);
+	s += buf;
+	snprintf(buf, sizeof(buf), "language=%u\n", _language);
+	s += buf;
+	snprintf(buf, sizeof(buf), "controls=%u\n", _controls);
+	s += buf;
+	snprintf(buf, sizeof(buf), "vibra=%u\n", _vibra);
+	s += buf;
+	snprintf(buf, sizeof(buf), "display=%u\n", _display);
+	s += buf;
+
+	for (int i = KEYUP; i <= KEYSTART; ++i) {
+		snprintf(buf, sizeof(buf), "%s=0x%02X\n", keyFields[i], key(i));
+		s += buf;
+	}
+
+	return s;
+}
+
+bool configuration::set(const char *field, const char *value)
+{
+	char *end = NULL;
+	unsigned long n;
+
+	if (!field || !value || !*value) {
+		return false;
+	}
+
+	if (strcmp(field, "resolution") == 0) {
+		unsigned int w = 0, h = 0;
+
+		if (sscanf(value, "%ux%u", &w, &h) != 2) {
+			return false;
+		}
+		for (int i = 0; i < SZRESLIST; ++i) {
+			if (resList[i].w == w && resList[i].h == h) {
+				resN(i);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	n = strtoul(value, &end, 0);
+	if (*end != 0 || n > 0xFF) {
+		return false;
+	}
+
+	if (strcmp(field, "fullscreen") == 0) {
+		_fullscreen = (n == 0) ? 0 : 1;
+	} else if (strcmp(field, "language") == 0) {
+		_language = static_cast<uchar>(n);
+	} else if (strcmp(field, "controls") == 0) {
+		_controls = (n == GAMEPAD_CTRLS) ? GAMEPAD_CTRLS : KEYBOARD_CTRLS;
+	} else if (strcmp(field, "vibra") == 0) {
+		_vibra = (n == 0) ? 0 : 1;
+	} else if (strcmp(field, "display") == 0) {
+		/* no screens were counted, nothing is valid */
+		if (_screenCount < 1 || n >= static_cast<unsigned long>(_screenCount)) {
+			return false;
+		}
+		_display = static_cast<uchar>(n);
+	} else {
+		for (int i = KEYUP; i <= KEYSTART; ++i) {
+			if (strcmp(field, keyFields[i]) == 0) {
+				if (n == 0 || isIgnoredKey(static_cast<uchar>(n))) {
+					return false;
+				}
+				for (int j = KEYUP; j <= KEYSTART; ++j) {
+					if (j != i && key(j) == n) {
+						/* duplicate keys */
+						return false;
+					}
+				}
+				key(static_cast<uchar>(n), i);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	return true;
+}
+
 configuration::configuration(const wchar_t *filename)
 {
+	TRACE_SCOPE("configuration::configuration");
+
 	_confFile = filename;
 	_screenCount = static_cast<uchar>(Fl::screen_count());
 
@@ -366,3 +525,9 @@ configuration::configuration(const wchar_t *filename)
 	}
 }
 
+configuration::configuration(const wchar_t *filename, uchar screenCount)
+{
+	_confFile = filename;
+	_screenCount = (screenCount == 0) ? 1 : screenCount;
+}
+
@@ -25,7 +25,10 @@
 #include <stdint.h>
 #include <wchar.h>
 
+#include <string>
+
 #define SZRESLIST 12
+#define CONF_SIZE 53  /* size of main.conf */
 
 #define KEYBOARD_CTRLS 0
 #define GAMEPAD_CTRLS 1
@@ -81,13 +84,21 @@ private:
 public:
 	configuration(const wchar_t *filename);
 
+	/* doesn't query the screens, so it works without a display connection */
+	configuration(const wchar_t *filename, uchar screenCount);
+
 	bool loadConfig();
 	void setDefaultKeys();
 	void loadDefaultConfig();
 	bool saveConfig();
 
+	/* convert from/to the main.conf file format; buf holds CONF_SIZE bytes */
+	bool decode(const uchar *buf);
+	void encode(uchar *buf);
+
 	uchar screenCount() { return _screenCount; }
 	static bool isIgnoredKey(uchar dx);
+	static bool hasDuplicateKeys(const uchar *keys, int n);
 	static const char *getReslistL(int n);
 
 	/* get config values */
@@ -111,5 +122,9 @@ public:
 	void vibra(uchar n)      { _vibra = n; }
 	void display(uchar n)    { _display = n; }
 	void key(uchar n, int type);
+
+	/* text interface ("field=value" lines), used by the control channel */
+	std::string dump();
+	bool set(const char *field, const char *value);
 };
 
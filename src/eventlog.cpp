@@ -0,0 +1,398 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <FL/Fl_Group.H>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "allocprof.hpp"
+#include "clock.hpp"
+#include "eventlog.hpp"
+
+#define EVENTLOG_PICK      0xFF
+#define EVENTLOG_HEADER    8
+#define EVENTLOG_RECORD    16
+
+
+/* little endian on disk:
+ * 0 type, 1 clicks, 2 is_click, 3 unused, 4 x, 6 y, 8 state,
+ * 12 key (the button for mouse events, dx and dy for the wheel,
+ * the item for picks) */
+typedef struct {
+	uint8_t type;
+	uint8_t clicks;
+	uint8_t isClick;
+	int16_t x, y;
+	uint32_t state;
+	int32_t key;
+} eventRecord_t;
+
+typedef struct {
+	std::vector<uint64_t> ns;
+	std::vector<uint32_t> allocs;
+} handlerStats_t;
+
+static Fl_Window *recWindow = NULL;
+static uint8_t recLang = 0;
+static std::vector<eventRecord_t> recEvents;
+
+static bool replaying = false;
+static int replayPick = -1;
+
+
+static const char *event_name(int e)
+{
+	switch (e) {
+	case FL_PUSH:       return "push";
+	case FL_RELEASE:    return "release";
+	case FL_ENTER:      return "enter";
+	case FL_LEAVE:      return "leave";
+	case FL_DRAG:       return "drag";
+	case FL_KEYDOWN:    return "keydown";
+	case FL_KEYUP:      return "keyup";
+	case FL_MOVE:       return "move";
+	case FL_MOUSEWHEEL: return "wheel";
+	case EVENTLOG_PICK: return "pick";
+	default:            return NULL;
+	}
+}
+
+static void put16(uint8_t *p, uint16_t v)
+{
+	p[0] = static_cast<uint8_t>(v);
+	p[1] = static_cast<uint8_t>(v >> 8);
+}
+
+static void put32(uint8_t *p, uint32_t v)
+{
+	put16(p, static_cast<uint16_t>(v));
+	put16(p + 2, static_cast<uint16_t>(v >> 16));
+}
+
+static uint16_t get16(const uint8_t *p)
+{
+	return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+	return get16(p) | (static_cast<uint32_t>(get16(p + 2)) << 16);
+}
+
+static int record_dispatch(int e, Fl_Window *w)
+{
+	if (w == recWindow && event_name(e)) {
+		eventRecord_t r;
+
+		r.type = static_cast<uint8_t>(e);
+		r.clicks = static_cast<uint8_t>(Fl::event_clicks());
+		r.isClick = Fl::event_is_click() ? 1 : 0;
+		r.x = static_cast<int16_t>(Fl::event_x());
+		r.y = static_cast<int16_t>(Fl::event_y());
+		r.state = static_cast<uint32_t>(Fl::event_state());
+
+		if (e == FL_MOUSEWHEEL) {
+			r.key = static_cast<int32_t>(static_cast<uint32_t>(static_cast<uint16_t>(Fl::event_dx())) |
+				(static_cast<uint32_t>(static_cast<uint16_t>(Fl::event_dy())) << 16));
+		} else {
+			r.key = Fl::event_key();
+		}
+		recEvents.push_back(r);
+	}
+
+	return Fl::handle_(e, w);
+}
+
+bool eventlog_record(Fl_Window *win, int lang)
+{
+	if (recWindow || !win) {
+		return false;
+	}
+
+	recWindow = win;
+	recLang = static_cast<uint8_t>(lang);
+	recEvents.clear();
+	Fl::event_dispatch(record_dispatch);
+
+	return true;
+}
+
+bool eventlog_stop(const char *file)
+{
+	uint8_t buf[EVENTLOG_RECORD];
+	FILE *fp;
+	bool ok;
+
+	if (!recWindow) {
+		return false;
+	}
+	Fl::event_dispatch(NULL);
+	recWindow = NULL;
+
+	if ((fp = fopen(file, "wb")) == NULL) {
+		return false;
+	}
+
+	memset(buf, 0, sizeof(buf));
+	memcpy(buf, EVENTLOG_MAGIC, 4);
+	buf[4] = EVENTLOG_VERSION;
+	buf[5] = recLang;
+	ok = (fwrite(buf, 1, EVENTLOG_HEADER, fp) == EVENTLOG_HEADER);
+
+	for (size_t i = 0; i < recEvents.size() && ok; ++i) {
+		const eventRecord_t *r = &recEvents[i];
+
+		buf[0] = r->type;
+		buf[1] = r->clicks;
+		buf[2] = r->isClick;
+		buf[3] = 0;
+		put16(buf + 4, static_cast<uint16_t>(r->x));
+		put16(buf + 6, static_cast<uint16_t>(r->y));
+		put32(buf + 8, r->state);
+		put32(buf + 12, static_cast<uint32_t>(r->key));
+		ok = (fwrite(buf, 1, EVENTLOG_RECORD, fp) == EVENTLOG_RECORD);
+	}
+
+	if (fclose(fp) != 0) {
+		ok = false;
+	}
+	recEvents.clear();
+
+	return ok;
+}
+
+void eventlog_pick(int item)
+{
+	if (recWindow) {
+		eventRecord_t r;
+
+		memset(&r, 0, sizeof(r));
+		r.type = EVENTLOG_PICK;
+		r.key = item;
+		recEvents.push_back(r);
+	}
+}
+
+bool eventlog_replay_pick(int *item)
+{
+	if (!replaying) {
+		return false;
+	}
+
+	/* never open a pulldown while replaying, it would wait for the user */
+	*item = replayPick;
+	replayPick = -1;
+	return true;
+}
+
+bool eventlog_replaying(void)
+{
+	return replaying;
+}
+
+static bool load(const char *file, int *lang, std::vector<eventRecord_t> &events)
+{
+	uint8_t buf[EVENTLOG_RECORD];
+	FILE *fp = fopen(file, "rb");
+	bool ok;
+
+	if (!fp) {
+		return false;
+	}
+
+	ok = (fread(buf, 1, EVENTLOG_HEADER, fp) == EVENTLOG_HEADER &&
+		memcmp(buf, EVENTLOG_MAGIC, 4) == 0 && buf[4] == EVENTLOG_VERSION);
+	*lang = buf[5];
+
+	while (ok && fread(buf, 1, EVENTLOG_RECORD, fp) == EVENTLOG_RECORD) {
+		eventRecord_t r;
+
+		r.type = buf[0];
+		r.clicks = buf[1];
+		r.isClick = buf[2];
+		r.x = static_cast<int16_t>(get16(buf + 4));
+		r.y = static_cast<int16_t>(get16(buf + 6));
+		r.state = get32(buf + 8);
+		r.key = static_cast<int32_t>(get32(buf + 12));
+
+		if (!event_name(r.type)) {
+			ok = false;
+		}
+		events.push_back(r);
+	}
+
+	fclose(fp);
+	return ok;
+}
+
+/* the topmost visible widget under X,Y, like FLTK picks it for a click */
+static Fl_Widget *widget_at(Fl_Widget *o, int X, int Y)
+{
+	Fl_Group *g = o->as_group();
+
+	for (int i = g ? g->children() - 1 : -1; i >= 0; --i) {
+		Fl_Widget *c = g->child(i);
+
+		if (c->visible() && X >= c->x() && Y >= c->y() && X < c->x() + c->w() && Y < c->y() + c->h()) {
+			return widget_at(c, X, Y);
+		}
+	}
+
+	return o;
+}
+
+/* "<event>/<class>", with the innermost launcher class the event goes to */
+static std::string handler_key(const eventlogUi_t *ui, Fl_Window *win, const eventRecord_t *r)
+{
+	Fl_Widget *o;
+	const char *name = NULL;
+
+	if (r->type == FL_KEYDOWN || r->type == FL_KEYUP) {
+		o = (Fl::focus() && Fl::focus()->window() == win) ? Fl::focus() : win;
+	} else {
+		o = widget_at(win, r->x, r->y);
+	}
+
+	for ( ; o && !name; o = o->parent()) {
+		name = ui->handler(o);
+	}
+
+	return std::string(event_name(r->type)) + "/" + (name ? name : "other");
+}
+
+static void set_event(Fl_Window *win, const eventRecord_t *r)
+{
+	static char empty[1] = "";
+
+	Fl::e_x = r->x;
+	Fl::e_y = r->y;
+	Fl::e_x_root = win->x() + r->x;
+	Fl::e_y_root = win->y() + r->y;
+	Fl::e_state = static_cast<int>(r->state);
+	Fl::e_clicks = r->clicks;
+	Fl::e_is_click = r->isClick;
+	Fl::e_text = empty;
+	Fl::e_length = 0;
+
+	if (r->type == FL_MOUSEWHEEL) {
+		Fl::e_dx = static_cast<int16_t>(r->key & 0xFFFF);
+		Fl::e_dy = static_cast<int16_t>(static_cast<uint32_t>(r->key) >> 16);
+	} else {
+		Fl::e_keysym = r->key;
+	}
+}
+
+/* p50, p90, p99 and max of t, which gets sorted */
+static void print_percentiles(FILE *fp, std::vector<uint64_t> &t)
+{
+	size_t n = t.size();
+
+	std::sort(t.begin(), t.end());
+	fprintf(fp, "%llu\t%llu\t%llu\t%llu",
+		static_cast<unsigned long long>(t[(n - 1) / 2]),
+		static_cast<unsigned long long>(t[(n - 1) * 9 / 10]),
+		static_cast<unsigned long long>(t[(n - 1) * 99 / 100]),
+		static_cast<unsigned long long>(t[n - 1]));
+}
+
+bool eventlog_replay(const eventlogUi_t *ui, const char *logFile, int iterations, const char *reportFile)
+{
+	std::vector<eventRecord_t> events;
+	std::map<std::string, handlerStats_t> stats;
+	int lang = 0;
+	FILE *fp;
+
+	if (iterations < 1 || !load(logFile, &lang, events) || events.empty()) {
+		return false;
+	}
+
+	replaying = true;
+
+	for (int it = 0; it < iterations; ++it) {
+		Fl_Window *win = ui->build(lang);
+
+		/* keys go to the focus widget, clicks move it */
+		Fl::focus(win);
+
+		for (size_t i = 0; i < events.size(); ++i) {
+			const eventRecord_t *r = &events[i];
+
+			if (r->type == EVENTLOG_PICK) {
+				continue;  /* taken with the push before it */
+			}
+
+			replayPick = (i + 1 < events.size() && events[i + 1].type == EVENTLOG_PICK) ? events[i + 1].key : -1;
+			set_event(win, r);
+
+			handlerStats_t &s = stats[handler_key(ui, win, r)];
+			uint64_t allocs = ALLOCPROF_ALLOCATIONS();
+			uint64_t start = clock_ns();
+
+			Fl::handle_(r->type, win);
+
+			uint64_t ns = clock_ns() - start;
+			allocs = ALLOCPROF_ALLOCATIONS() - allocs;
+
+			s.ns.push_back(ns);
+			s.allocs.push_back(static_cast<uint32_t>(allocs));
+		}
+
+		ui->teardown();
+	}
+
+	replaying = false;
+	replayPick = -1;
+
+	if ((fp = fopen(reportFile, "w")) == NULL) {
+		return false;
+	}
+
+	fprintf(fp, "handler\tevents\tp50_ns\tp90_ns\tp99_ns\tmax_ns\tallocs_per_event\tmax_allocs\n");
+
+	for (auto &it : stats) {
+		handlerStats_t &s = it.second;
+
+		fprintf(fp, "%s\t%lu\t", it.first.c_str(), static_cast<unsigned long>(s.ns.size()));
+		print_percentiles(fp, s.ns);
+#ifdef SL_ALLOCPROF
+		uint64_t sum = 0;
+
+		for (size_t i = 0; i < s.allocs.size(); ++i) {
+			sum += s.allocs[i];
+		}
+		fprintf(fp, "\t%.2f\t%lu\n", static_cast<double>(sum) / s.allocs.size(),
+			static_cast<unsigned long>(*std::max_element(s.allocs.begin(), s.allocs.end())));
+#else
+		fprintf(fp, "\t-\t-\n");
+#endif
+	}
+
+	return fclose(fp) == 0;
+}
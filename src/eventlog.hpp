@@ -0,0 +1,75 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Records the mouse and keyboard events that reach the launcher window
+ * and replays them, to time the UI's event handlers.
+ *
+ * -RecordEvents installs an Fl::event_dispatch() hook and appends every
+ * event for the window to a log of fixed 16 byte records. Menus run their
+ * own window, so MyChoice logs the item its pulldown returned instead of
+ * the events that picked it.
+ *
+ * -ReplayEvents builds the window without showing it and feeds the log
+ * to Fl::handle_() as fast as it can, timing each event and counting the
+ * allocations it makes (those need make ALLOCPROF=1). The report groups
+ * the events by type and by the launcher class that handles them. */
+
+#ifndef EVENTLOG_HPP
+#define EVENTLOG_HPP
+
+#include <FL/Fl.H>
+#include <FL/Fl_Window.H>
+
+#define EVENTLOG_MAGIC              "SLEV"
+#define EVENTLOG_VERSION            1
+#define EVENTLOG_REPLAY_ITERATIONS  20
+
+
+/* hooks into the launcher for -ReplayEvents */
+typedef struct {
+	Fl_Window *(*build)(int lang);  /* build the window in a UI language without showing it */
+	void (*teardown)(void);
+	const char *(*handler)(Fl_Widget *o);  /* name of o's class, or NULL for a stock widget */
+} eventlogUi_t;
+
+/* start logging the events for win; lang is the UI language to replay in */
+bool eventlog_record(Fl_Window *win, int lang);
+
+/* stop logging and write the log */
+bool eventlog_stop(const char *file);
+
+/* the menu item a pulldown returned, -1 for none */
+void eventlog_pick(int item);
+
+/* while replaying, the recorded item to use instead of opening the
+ * pulldown; false otherwise */
+bool eventlog_replay_pick(int *item);
+
+bool eventlog_replaying(void);
+
+/* replay the log against a fresh window a number of times and write the
+ * per handler latency percentiles and allocations */
+bool eventlog_replay(const eventlogUi_t *ui, const char *logFile, int iterations, const char *reportFile);
+
+#endif  /* EVENTLOG_HPP */
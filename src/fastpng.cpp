@@ -0,0 +1,448 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <string.h>
+#include <zlib.h>
+
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+#define FASTPNG_X86
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#include "fastpng.hpp"
+#include "trace.hpp"
+
+#ifdef __GNUC__
+#define SSE2_FUNC  __attribute__((target("sse2")))
+#else
+#define SSE2_FUNC
+#endif
+
+enum {
+	FILTER_NONE,
+	FILTER_SUB,
+	FILTER_UP,
+	FILTER_AVG,
+	FILTER_PAETH
+};
+
+enum {
+	COLOR_GRAY = 0,
+	COLOR_RGB = 2,
+	COLOR_PALETTE = 3,
+	COLOR_GRAY_ALPHA = 4,
+	COLOR_RGBA = 6
+};
+
+#define MAX_IDAT  64
+
+
+static bool useSSE2 = true;
+
+static unsigned int be32(const unsigned char *p)
+{
+	return (static_cast<unsigned int>(p[0]) << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+static bool cpu_has_sse2(void)
+{
+#if defined(__x86_64__) || defined(_M_X64)
+	return true;
+#elif defined(FASTPNG_X86) && defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	return (info[3] & (1 << 26)) != 0;
+#elif defined(FASTPNG_X86)
+	return __builtin_cpu_supports("sse2");
+#else
+	return false;
+#endif
+}
+
+bool fastpng_sse2(bool enable)
+{
+	useSSE2 = enable && cpu_has_sse2();
+	return useSSE2;
+}
+
+
+/* scalar unfiltering, any bpp */
+
+static void unfilter_sub(unsigned char *row, size_t n, int bpp)
+{
+	for (size_t i = bpp; i < n; ++i) {
+		row[i] += row[i - bpp];
+	}
+}
+
+static void unfilter_up(unsigned char *row, const unsigned char *prev, size_t n)
+{
+	/* vectorized by the compiler */
+	for (size_t i = 0; i < n; ++i) {
+		row[i] += prev[i];
+	}
+}
+
+static void unfilter_avg(unsigned char *row, const unsigned char *prev, size_t n, int bpp)
+{
+	size_t i;
+
+	for (i = 0; i < static_cast<size_t>(bpp); ++i) {
+		row[i] += prev[i] >> 1;
+	}
+	for ( ; i < n; ++i) {
+		row[i] += (row[i - bpp] + prev[i]) >> 1;
+	}
+}
+
+static inline unsigned char paeth(int a, int b, int c)
+{
+	int pa = b - c;
+	int pb = a - c;
+	int pc = pa + pb;
+
+	pa = (pa < 0) ? -pa : pa;
+	pb = (pb < 0) ? -pb : pb;
+	pc = (pc < 0) ? -pc : pc;
+
+	if (pa <= pb && pa <= pc) {
+		return static_cast<unsigned char>(a);
+	}
+	return static_cast<unsigned char>((pb <= pc) ? b : c);
+}
+
+static void unfilter_paeth(unsigned char *row, const unsigned char *prev, size_t n, int bpp)
+{
+	size_t i;
+
+	for (i = 0; i < static_cast<size_t>(bpp); ++i) {
+		row[i] += prev[i];
+	}
+	for ( ; i < n; ++i) {
+		row[i] += paeth(row[i - bpp], prev[i], prev[i - bpp]);
+	}
+}
+
+
+#ifdef FASTPNG_X86
+/* SSE2 unfiltering for 3 and 4 bytes per pixel, one pixel at a time,
+ * along the lines of libpng's filter_sse2_intrinsics.c */
+
+SSE2_FUNC static inline __m128i load_px(const unsigned char *p, int bpp)
+{
+	int v = 0;
+	memcpy(&v, p, bpp);
+	return _mm_cvtsi32_si128(v);
+}
+
+SSE2_FUNC static inline void store_px(unsigned char *p, __m128i v, int bpp)
+{
+	int n = _mm_cvtsi128_si32(v);
+	memcpy(p, &n, bpp);
+}
+
+SSE2_FUNC static void unfilter_sub_sse2(unsigned char *row, size_t n, int bpp)
+{
+	__m128i a = _mm_setzero_si128();
+
+	for (size_t i = 0; i < n; i += bpp) {
+		a = _mm_add_epi8(load_px(row + i, bpp), a);
+		store_px(row + i, a, bpp);
+	}
+}
+
+SSE2_FUNC static void unfilter_avg_sse2(unsigned char *row, const unsigned char *prev, size_t n, int bpp)
+{
+	const __m128i one = _mm_set1_epi8(1);
+	__m128i a = _mm_setzero_si128();
+
+	for (size_t i = 0; i < n; i += bpp) {
+		__m128i b = load_px(prev + i, bpp);
+		/* _mm_avg_epu8 rounds up, PNG rounds down */
+		__m128i avg = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), one));
+
+		a = _mm_add_epi8(load_px(row + i, bpp), avg);
+		store_px(row + i, a, bpp);
+	}
+}
+
+SSE2_FUNC static inline __m128i abs_epi16(__m128i x)
+{
+	return _mm_max_epi16(x, _mm_sub_epi16(_mm_setzero_si128(), x));
+}
+
+SSE2_FUNC static inline __m128i select(__m128i mask, __m128i x, __m128i y)
+{
+	return _mm_or_si128(_mm_and_si128(mask, x), _mm_andnot_si128(mask, y));
+}
+
+SSE2_FUNC static void unfilter_paeth_sse2(unsigned char *row, const unsigned char *prev, size_t n, int bpp)
+{
+	const __m128i zero = _mm_setzero_si128();
+	/* left, above and above left, as 16 bit values */
+	__m128i a = zero, c = zero;
+
+	for (size_t i = 0; i < n; i += bpp) {
+		__m128i b = _mm_unpacklo_epi8(load_px(prev + i, bpp), zero);
+		__m128i pa = _mm_sub_epi16(b, c);
+		__m128i pb = _mm_sub_epi16(a, c);
+		__m128i pc = _mm_add_epi16(pa, pb);
+
+		pa = abs_epi16(pa);
+		pb = abs_epi16(pb);
+		pc = abs_epi16(pc);
+
+		__m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+		__m128i nearest = select(_mm_cmpeq_epi16(smallest, pa), a,
+			select(_mm_cmpeq_epi16(smallest, pb), b, c));
+		__m128i d = _mm_add_epi8(load_px(row + i, bpp), _mm_packus_epi16(nearest, nearest));
+
+		store_px(row + i, d, bpp);
+		a = _mm_unpacklo_epi8(d, zero);
+		c = b;
+	}
+}
+#endif  /* FASTPNG_X86 */
+
+static bool unfilter_row(int filter, unsigned char *row, const unsigned char *prev, size_t n, int bpp)
+{
+#ifdef FASTPNG_X86
+	bool sse2 = useSSE2 && (bpp == 3 || bpp == 4);
+#else
+	const bool sse2 = false;
+#endif
+
+	switch (filter) {
+	case FILTER_NONE:
+		break;
+	case FILTER_SUB:
+#ifdef FASTPNG_X86
+		if (sse2) {
+			unfilter_sub_sse2(row, n, bpp);
+			break;
+		}
+#endif
+		unfilter_sub(row, n, bpp);
+		break;
+	case FILTER_UP:
+		unfilter_up(row, prev, n);
+		break;
+	case FILTER_AVG:
+#ifdef FASTPNG_X86
+		if (sse2) {
+			unfilter_avg_sse2(row, prev, n, bpp);
+			break;
+		}
+#endif
+		unfilter_avg(row, prev, n, bpp);
+		break;
+	case FILTER_PAETH:
+#ifdef FASTPNG_X86
+		if (sse2) {
+			unfilter_paeth_sse2(row, prev, n, bpp);
+			break;
+		}
+#endif
+		unfilter_paeth(row, prev, n, bpp);
+		break;
+	default:
+		return false;
+	}
+
+	return true;
+}
+
+
+bool fastpng_decode(const unsigned char *png, size_t size, fastpngImage_t *out)
+{
+	static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	const unsigned char *idat[MAX_IDAT];
+	unsigned int idatLength[MAX_IDAT];
+	int idats = 0;
+	unsigned char palette[256][4];
+	int paletteSize = 0;
+	bool paletteAlpha = false;
+	unsigned int w = 0, h = 0;
+	int color = -1;
+
+	TRACE_SCOPE("fastpng_decode");
+
+	if (size < 8 + 25 || memcmp(png, signature, 8) != 0) {
+		return false;
+	}
+
+	/* collect the chunks; the CRCs aren't checked */
+	for (size_t pos = 8; pos + 12 <= size; ) {
+		unsigned int length = be32(png + pos);
+		const unsigned char *type = png + pos + 4;
+		const unsigned char *data = png + pos + 8;
+
+		if (length > size - pos - 12) {
+			return false;
+		}
+
+		if (memcmp(type, "IHDR", 4) == 0) {
+			if (length != 13) {
+				return false;
+			}
+			w = be32(data);
+			h = be32(data + 4);
+			color = data[9];
+
+			/* 8 bit, deflate, adaptive filtering, not interlaced */
+			if (data[8] != 8 || data[10] != 0 || data[11] != 0 || data[12] != 0) {
+				return false;
+			}
+		} else if (memcmp(type, "PLTE", 4) == 0) {
+			paletteSize = length / 3;
+
+			if (paletteSize > 256) {
+				return false;
+			}
+			for (int i = 0; i < paletteSize; ++i) {
+				palette[i][0] = data[i * 3];
+				palette[i][1] = data[i * 3 + 1];
+				palette[i][2] = data[i * 3 + 2];
+				palette[i][3] = 255;
+			}
+		} else if (memcmp(type, "tRNS", 4) == 0) {
+			/* a transparent color would need an alpha channel added */
+			if (color != COLOR_PALETTE || static_cast<int>(length) > paletteSize) {
+				return false;
+			}
+			for (unsigned int i = 0; i < length; ++i) {
+				palette[i][3] = data[i];
+			}
+			paletteAlpha = true;
+		} else if (memcmp(type, "IDAT", 4) == 0) {
+			if (idats == MAX_IDAT) {
+				return false;
+			}
+			idat[idats] = data;
+			idatLength[idats++] = length;
+		} else if (memcmp(type, "IEND", 4) == 0) {
+			break;
+		}
+
+		pos += length + 12;
+	}
+
+	int bpp;
+
+	switch (color) {
+	case COLOR_GRAY:       bpp = 1; break;
+	case COLOR_GRAY_ALPHA: bpp = 2; break;
+	case COLOR_RGB:        bpp = 3; break;
+	case COLOR_RGBA:       bpp = 4; break;
+	case COLOR_PALETTE:    bpp = 1; break;
+	default:
+		return false;
+	}
+
+	if (w == 0 || h == 0 || w > 16384 || h > 16384 || idats == 0 || (color == COLOR_PALETTE && paletteSize == 0)) {
+		return false;
+	}
+
+	/* inflate everything at once; each row starts with its filter type */
+	size_t stride = static_cast<size_t>(w) * bpp;
+	size_t rawSize = (stride + 1) * h;
+	unsigned char *raw = new unsigned char[rawSize];
+	z_stream zs;
+	int rc = Z_OK;
+
+	memset(&zs, 0, sizeof(zs));
+
+	if (inflateInit(&zs) != Z_OK) {
+		delete[] raw;
+		return false;
+	}
+
+	zs.next_out = raw;
+	zs.avail_out = static_cast<uInt>(rawSize);
+
+	for (int i = 0; i < idats && rc == Z_OK; ++i) {
+		zs.next_in = const_cast<Bytef *>(idat[i]);
+		zs.avail_in = idatLength[i];
+		rc = inflate(&zs, Z_NO_FLUSH);
+
+		if (rc == Z_BUF_ERROR && zs.avail_out == 0) {
+			rc = Z_STREAM_END;  /* trailing data */
+		}
+	}
+	inflateEnd(&zs);
+
+	if ((rc != Z_OK && rc != Z_STREAM_END) || zs.avail_out != 0) {
+		delete[] raw;
+		return false;
+	}
+
+	/* unfilter in place; the first row has a row of zeros above it */
+	unsigned char *zeros = new unsigned char[stride]();
+	const unsigned char *prev = zeros;
+
+	for (unsigned int y = 0; y < h; ++y) {
+		unsigned char *row = raw + y * (stride + 1);
+
+		if (!unfilter_row(row[0], row + 1, prev, stride, bpp)) {
+			delete[] zeros;
+			delete[] raw;
+			return false;
+		}
+		prev = row + 1;
+	}
+	delete[] zeros;
+
+	/* drop the filter bytes, expand palette images */
+	int d = (color == COLOR_PALETTE) ? (paletteAlpha ? 4 : 3) : bpp;
+	unsigned char *pixels = new unsigned char[static_cast<size_t>(w) * h * d];
+
+	for (unsigned int y = 0; y < h; ++y) {
+		const unsigned char *row = raw + y * (stride + 1) + 1;
+		unsigned char *px = pixels + static_cast<size_t>(y) * w * d;
+
+		if (color != COLOR_PALETTE) {
+			memcpy(px, row, stride);
+			continue;
+		}
+
+		for (unsigned int x = 0; x < w; ++x, px += d) {
+			/* out-of-range indices are black, as in libpng */
+			const unsigned char *p = (row[x] < paletteSize) ? palette[row[x]] : NULL;
+			static const unsigned char black[4] = { 0, 0, 0, 255 };
+
+			memcpy(px, p ? p : black, d);
+		}
+	}
+	delete[] raw;
+
+	out->pixels = pixels;
+	out->w = static_cast<int>(w);
+	out->h = static_cast<int>(h);
+	out->d = d;
+
+	return true;
+}
@@ -0,0 +1,52 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Alternate decoder for the embedded PNGs (make FASTPNG=1). It handles
+ * what the artwork uses: 8 bit gray, gray + alpha, RGB, RGBA and palette
+ * images without interlacing. The image data is inflated in one call into
+ * a buffer of its final size instead of row by row, and the rows are
+ * unfiltered with SSE2 where the CPU has it. The inflate itself is stock
+ * zlib, about half of the decode time (see README.md). Anything else is
+ * left to libpng (Fl_PNG_Image). */
+
+#ifndef FASTPNG_HPP
+#define FASTPNG_HPP
+
+#include <stddef.h>
+
+
+typedef struct {
+	unsigned char *pixels;  /* allocated with new[] */
+	int w;
+	int h;
+	int d;  /* 1 to 4 channels, like Fl_PNG_Image */
+} fastpngImage_t;
+
+/* false if the data is broken or uses a format that isn't supported */
+bool fastpng_decode(const unsigned char *png, size_t size, fastpngImage_t *out);
+
+/* use SSE2 if the CPU supports it (the default); returns whether it's used */
+bool fastpng_sse2(bool enable);
+
+#endif  /* FASTPNG_HPP */
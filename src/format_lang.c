@@ -9,114 +9,224 @@
 
 // compile: cl /O2 format_lang.c
 // usage: format_lang.exe < lang.txt > lang.h
+//
+// lang.txt has one row per string and one column per language, separated
+// by '|'. The output is a single pool with all strings and a table of
+// offsets into it, indexed by string ID and language.
 
+#include <ctype.h>
 #include <stdio.h>
+#include <string.h>
 
+#define LANGUAGES  6
+#define MAX_INPUT  (256 * 1024)
 
-int main(void)
+
+static const char *ui[] = {
+  "Settings",
+  "0GraphicsSettings",  // unused
+  "GraphicsDevice",
+  "Resolution",
+  "Fullscreen",
+  "0AudioSettings",  // unused
+  "0OutputDevice",  // unused
+  "Language",
+  "ControllerSelection",
+  "0AdditionalController",  // unused
+  "0ControllerNumber",  // unused
+  "0Layout",  // unused
+  "0ConfigurationLayout",  // unused
+  "Movement",
+  "Action",
+  "Up",
+  "Down",
+  "Left",
+  "Right",
+  "Jump",
+  "Start",
+  "SaveSettings",
+  "Player",
+  "Select",
+  "Back",
+  "Keyboard",
+  "Gamepad",
+  "ScoreAttack",
+  "Press",
+  "ResetToDefault",
+  "0Configuration",  // unused
+  "0ConfigurationSaved",  // unused
+  "SuperSonic",
+  "Vibrate",
+  "0Leaderboards",  // unused
+  NULL
+};
+
+/* "GraphicsDevice" -> "UI_GRAPHICS_DEVICE" */
+static void print_id(const char *s)
 {
-  char c = getchar();
-  char hex, newEntry;
-  size_t i;
-
-  const char *ui[] = {
-    "Settings",
-    "0GraphicsSettings",  // unused
-    "GraphicsDevice",
-    "Resolution",
-    "Fullscreen",
-    "0AudioSettings",  // unused
-    "0OutputDevice",  // unused
-    "Language",
-    "ControllerSelection",
-    "0AdditionalController",  // unused
-    "0ControllerNumber",  // unused
-    "0Layout",  // unused
-    "0ConfigurationLayout",  // unused
-    "Movement",
-    "Action",
-    "Up",
-    "Down",
-    "Left",
-    "Right",
-    "Jump",
-    "Start",
-    "SaveSettings",
-    "Player",
-    "Select",
-    "Back",
-    "Keyboard",
-    "Gamepad",
-    "ScoreAttack",
-    "Press",
-    "ResetToDefault",
-    "0Configuration",  // unused
-    "0ConfigurationSaved",  // unused
-    "SuperSonic",
-    "Vibrate",
-    "0Leaderboards",  // unused
-    NULL
-  };
-
-  if (c == EOF || c == '\0') {
-    return 1;
+  const char *p;
+
+  printf("UI_");
+
+  for (p = s; *p; p++) {
+    if (p != s && isupper((unsigned char)*p)) {
+      putchar('_');
+    }
+    putchar(toupper((unsigned char)*p));
   }
+}
 
-  printf("const char *ui_%s[] = { \"", ui[0]);
-  newEntry = 0;
-  hex = 0;
-  i = 1;
+/* print a string literal terminated with "\0" */
+static void print_literal(const char *s)
+{
+  int hex = 0;
+
+  putchar('"');
+
+  for ( ; *s; s++) {
+    unsigned char c = (unsigned char)*s;
 
-  while (c != EOF && c != 0) {
     if (c >= ' ' && c <= '~') {
-      if (c == '|') {
-        printf("\", \"");
-        newEntry = 1;
-        hex = 0;
-      } else {
-        if (hex) {
-          printf("\" \"");
-        }
-        putchar(c);
-        newEntry = 0;
-        hex = 0;
+      if (hex) {
+        /* a hex escape would swallow the next character */
+        printf("\" \"");
       }
-    } else if (c >= '\a' && c <= '\r') {
-      if (c == '\n') {
-        printf("\" };\n");
-        if (ui[i] == NULL) {
-          return 0;
-        }
-        if (ui[i][0] == '0') {
-          const char *p = ui[i];
-          p++;
-          printf("//const char *ui_%s[] = { \"", p);
-        } else {
-          printf("const char *ui_%s[] = { \"", ui[i]);
-        }
-        newEntry = 0;
-        hex = 0;
-        i++;
+      if (c == '"' || c == '\\') {
+        putchar('\\');
       }
+      putchar(c);
+      hex = 0;
     } else {
-      if (!hex) {
-        if (!newEntry) {
-          printf("\" \"");
-        }
-      }
-      printf("\\x%02X", (unsigned char)c);
-      newEntry = 0;
+      printf("\\x%02X", c);
       hex = 1;
     }
+  }
+
+  printf("\\0\"");
+}
 
-    c = getchar();
+int main(void)
+{
+  static char buf[MAX_INPUT + 1];
+  static const char *rows[sizeof(ui) / sizeof(*ui)][LANGUAGES];
+  size_t ids = sizeof(ui) / sizeof(*ui) - 1;
+  size_t len, n, i, j, offset;
+  char *p, *next;
+
+  len = fread(buf, 1, MAX_INPUT + 1, stdin);
+
+  if (len == 0 || len > MAX_INPUT) {
+    fprintf(stderr, "lang.txt: empty or too large\n");
+    return 1;
   }
+  buf[len] = 0;
+
+  /* split into rows and columns */
+  for (p = buf, n = 0; *p; p = next, n++) {
+    if ((next = strchr(p, '\n')) != NULL) {
+      *next++ = 0;
+    } else {
+      next = p + strlen(p);
+    }
+
+    len = strlen(p);
+    if (len > 0 && p[len - 1] == '\r') {
+      p[--len] = 0;
+    }
+
+    if (len == 0 && *next == 0) {
+      break;  /* trailing newline */
+    }
+
+    if (n >= ids) {
+      fprintf(stderr, "lang.txt:%u: more rows than string IDs (%u)\n", (unsigned)(n + 1), (unsigned)ids);
+      return 1;
+    }
 
-  if (!hex) {
-    putchar('"');
+    for (j = 0; j < LANGUAGES; j++) {
+      rows[n][j] = p;
+
+      if ((p = strchr(p, '|')) == NULL) {
+        break;
+      }
+      *p++ = 0;
+    }
+
+    if (j != LANGUAGES - 1 || p != NULL) {
+      fprintf(stderr, "lang.txt:%u: expected %d columns\n", (unsigned)(n + 1), LANGUAGES);
+      return 1;
+    }
+  }
+
+  if (n != ids) {
+    fprintf(stderr, "lang.txt: %u rows, expected %u\n", (unsigned)n, (unsigned)ids);
+    return 1;
+  }
+
+  printf("/* generated from lang.txt by format_lang.c, don't edit */\n\n");
+  printf("#ifndef LANG_H\n#define LANG_H\n\n");
+  printf("#define UI_LANGUAGES  %d\n", LANGUAGES);
+  printf("#define UI_ROWS       %u  /* rows in lang.txt, including unused ones */\n\n", (unsigned)ids);
+
+  printf("enum {\n");
+  for (i = 0; i < ids; i++) {
+    if (ui[i][0] != '0') {
+      printf("  ");
+      print_id(ui[i]);
+      printf(",\n");
+    }
+  }
+  printf("  UI_STRINGS\n};\n\n");
+
+  printf("/* all strings, NUL separated */\n");
+  printf("static const char ui_pool[] =");
+  for (i = 0; i < ids; i++) {
+    if (ui[i][0] == '0') {
+      continue;  /* unused */
+    }
+    for (j = 0; j < LANGUAGES; j++) {
+      printf("\n  ");
+      print_literal(rows[i][j]);
+    }
+  }
+  printf(";\n\n");
+
+  printf("/* offsets into ui_pool by string ID and language */\n");
+  printf("static constexpr unsigned short ui_offsets[UI_STRINGS][UI_LANGUAGES] = {\n");
+  offset = 0;
+  for (i = 0; i < ids; i++) {
+    if (ui[i][0] == '0') {
+      continue;
+    }
+    printf("  {");
+    for (j = 0; j < LANGUAGES; j++) {
+      printf(j == 0 ? " %u" : ", %u", (unsigned)offset);
+      offset += strlen(rows[i][j]) + 1;
+    }
+    printf(" },  /* ");
+    print_id(ui[i]);
+    printf(" */\n");
+  }
+  printf("};\n\n");
+
+  /* for language packs, which have all rows of lang.txt */
+  printf("/* row in lang.txt by string ID */\n");
+  printf("static constexpr unsigned char ui_rows[UI_STRINGS] = {");
+  for (i = 0, n = 0; i < ids; i++) {
+    if (ui[i][0] != '0') {
+      printf(n++ == 0 ? " %u" : ", %u", (unsigned)i);
+    }
   }
-  printf(" };\n");
+  printf(" };\n\n");
+
+  if (offset > 0xFFFF) {
+    fprintf(stderr, "lang.txt: string pool exceeds 64 KiB\n");
+    return 1;
+  }
+
+  printf("static inline const char *ui_str(int id, unsigned int lang)\n{\n");
+  printf("  return ui_pool + ui_offsets[id][lang];\n}\n\n");
+  printf("#endif  /* LANG_H */\n");
 
   return 0;
 }
-
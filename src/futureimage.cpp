@@ -0,0 +1,252 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+
+#ifdef SL_FASTPNG
+#include "fastpng.hpp"
+#endif
+#include "futureimage.hpp"
+#include "trace.hpp"
+
+
+/* size and channels from the IHDR chunk, which always comes first */
+static int png_u32(const unsigned char *p)
+{
+	return (p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+static int png_width(const unsigned char *png, int size)
+{
+	return (size >= 24) ? png_u32(png + 16) : 0;
+}
+
+static int png_height(const unsigned char *png, int size)
+{
+	return (size >= 24) ? png_u32(png + 20) : 0;
+}
+
+static int png_depth(const unsigned char *png, int size)
+{
+	if (size < 26) {
+		return 3;
+	}
+
+	switch (png[25]) {
+	case 0:  return 1;  /* gray */
+	case 4:  return 2;  /* gray + alpha */
+	case 6:  return 4;  /* RGBA */
+	default: return 3;  /* RGB, palette */
+	}
+}
+
+pixelCache *futureImage::_cache = NULL;
+
+futureImage::futureImage(const unsigned char *png, int size)
+	: Fl_Image(png_width(png, size), png_height(png, size), png_depth(png, size)),
+	  _png(png),
+	  _size(size),
+	  _decoded(false)
+{}
+
+futureImage::~futureImage()
+{
+	delete _img;
+}
+
+void futureImage::decode()
+{
+	if (_decoded.load()) {
+		return;
+	}
+
+	_lock.lock();
+
+	if (!_img) {
+		TRACE_SCOPE("futureImage::decode");
+		const unsigned char *cached;
+		int W, H, D;
+
+		/* the cached pixels are mapped read-only; FLTK copies them
+		 * before changing them */
+		if (_cache) {
+			_hash = pixelcache_hash(_png, _size);
+
+			if (_cache->find(_hash, 100, &cached, &W, &H, &D)) {
+				_img = new Fl_RGB_Image(cached, W, H, D);
+				_decoded.store(true);
+				_lock.unlock();
+				return;
+			}
+		}
+#ifdef SL_FASTPNG
+		fastpngImage_t px;
+
+		if (fastpng_decode(_png, _size, &px)) {
+			_img = new Fl_RGB_Image(px.pixels, px.w, px.h, px.d);
+			_img->alloc_array = 1;
+		}
+#endif
+		if (!_img) {
+			_img = new Fl_PNG_Image(NULL, _png, _size);
+		}
+		if (_cache && _img->count() == 1 && _img->ld() == 0) {
+			_cache->add(_hash, 100, reinterpret_cast<const unsigned char *>(_img->data()[0]), _img->w(), _img->h(), _img->d());
+		}
+		_decoded.store(true);
+	}
+
+	_lock.unlock();
+}
+
+void futureImage::wait()
+{
+	if (_bound) {
+		return;
+	}
+
+	/* blocks while a worker decodes it */
+	decode();
+
+	w(_img->w());
+	h(_img->h());
+	d(_img->d());
+	ld(_img->ld());
+	data(_img->data(), _img->count());
+	_bound = true;
+}
+
+Fl_Image *futureImage::copy(int W, int H)
+{
+	wait();
+	return _img->copy(W, H);
+}
+
+void futureImage::color_average(Fl_Color c, float i)
+{
+	wait();
+	_img->color_average(c, i);
+	data(_img->data(), _img->count());
+}
+
+void futureImage::desaturate()
+{
+	wait();
+	_img->desaturate();
+	d(_img->d());
+	ld(_img->ld());
+	data(_img->data(), _img->count());
+}
+
+void futureImage::draw(int X, int Y, int W, int H, int cx, int cy)
+{
+	wait();
+	_img->draw(X, Y, W, H, cx, cy);
+}
+
+void futureImage::uncache()
+{
+	if (_img) {
+		_img->uncache();
+	}
+}
+
+
+/* the pool: workers take the next image until there are none left */
+static futureImage **queue = NULL;
+static size_t queueLength = 0;
+static std::atomic<size_t> queueNext(0);
+static thread workers[DECODE_MAX_THREADS];
+
+static void worker(void *)
+{
+	size_t i;
+
+	while ((i = queueNext.fetch_add(1)) < queueLength) {
+		queue[i]->decode();
+	}
+}
+
+/* the ones the process may run on, so a launcher pinned to two cores
+ * (start /affinity, taskset) sizes the pool like a 2-core machine */
+static int processors(void)
+{
+#ifdef _WIN32
+	DWORD_PTR mask, system;
+	int n = 0;
+
+	if (GetProcessAffinityMask(GetCurrentProcess(), &mask, &system)) {
+		for ( ; mask; mask &= mask - 1) {
+			++n;
+		}
+	}
+	if (n == 0) {
+		SYSTEM_INFO si;
+		GetSystemInfo(&si);
+		n = static_cast<int>(si.dwNumberOfProcessors);
+	}
+	return n;
+#else
+	cpu_set_t set;
+
+	if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+		return CPU_COUNT(&set);
+	}
+	return static_cast<int>(sysconf(_SC_NPROCESSORS_ONLN));
+#endif
+}
+
+void futureImage::decode_all(futureImage **images, size_t n)
+{
+	/* the main thread keeps starting up on the remaining processor */
+	int threads = std::min(std::min(processors() - 1, DECODE_MAX_THREADS), static_cast<int>(n));
+
+	queue = images;
+	queueLength = n;
+	queueNext.store(0);
+
+	for (int i = 0; i < threads; ++i) {
+		workers[i].start(worker, NULL);
+	}
+}
+
+void futureImage::wait_all()
+{
+	TRACE_SCOPE("futureImage::wait_all");
+
+	for (size_t i = 0; i < queueLength; ++i) {
+		queue[i]->wait();
+	}
+
+	for (int i = 0; i < DECODE_MAX_THREADS; ++i) {
+		workers[i].join();
+	}
+}
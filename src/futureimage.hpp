@@ -0,0 +1,90 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Embedded PNGs decoded on worker threads. The size is read from the PNG
+ * header right away, so widgets can be laid out with it; everything that
+ * needs the pixels waits for the decoder, or decodes the image itself if
+ * no worker got to it yet. */
+
+#ifndef FUTUREIMAGE_HPP
+#define FUTUREIMAGE_HPP
+
+#include <FL/Fl.H>
+#include <FL/Fl_Image.H>
+#include <FL/Fl_PNG_Image.H>
+
+#include <atomic>
+#include <stddef.h>
+
+#include "pixelcache.hpp"
+#include "threads.hpp"
+
+#define DECODE_MAX_THREADS  4
+
+
+class futureImage : public Fl_Image
+{
+private:
+	const unsigned char *_png;
+	int _size;
+	Fl_RGB_Image *_img = NULL;
+	std::atomic<bool> _decoded;
+	bool _bound = false;  /* pixels copied into this image */
+	uint64_t _hash = 0;
+	mutex _lock;
+
+	static pixelCache *_cache;
+
+public:
+	futureImage(const unsigned char *png, int size);
+	~futureImage();
+
+	/* decode, unless that already happened; called by the workers */
+	void decode();
+
+	/* wait until decoded; the image is complete afterwards */
+	void wait();
+
+	/* start decoding n images on up to DECODE_MAX_THREADS workers, one
+	 * less than there are processors */
+	static void decode_all(futureImage **images, size_t n);
+
+	/* wait for all images passed to decode_all() and the workers */
+	static void wait_all();
+
+	/* look up decoded pixels in c before decoding, and add them after a
+	 * miss; set before decode_all() */
+	static void cache(pixelCache *c) { _cache = c; }
+
+	/* of the embedded PNG, once decoded with a cache */
+	uint64_t hash() const { return _hash; }
+
+	Fl_Image *copy(int W, int H);
+	void color_average(Fl_Color c, float i);
+	void desaturate();
+	void draw(int X, int Y, int W, int H, int cx = 0, int cy = 0);
+	void uncache();
+};
+
+#endif  /* FUTUREIMAGE_HPP */
@@ -0,0 +1,247 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <windows.h>
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <wchar.h>
+
+#include "clock.hpp"
+#include "game.hpp"
+#include "trace.hpp"
+
+#define PAGE_SIZE_4K  4096
+
+
+/* a job that kills its processes when its last handle is closed, or
+ * only holds them with kill = false */
+static bool set_kill_on_close(HANDLE job, bool kill)
+{
+	JOBOBJECT_EXTENDED_LIMIT_INFORMATION limit;
+
+	SecureZeroMemory(&limit, sizeof(limit));
+	limit.BasicLimitInformation.LimitFlags = kill ? JOB_OBJECT_LIMIT_KILL_ON_JOB_CLOSE : 0;
+
+	return SetInformationJobObject(job, JobObjectExtendedLimitInformation, &limit, sizeof(limit)) != FALSE;
+}
+
+bool gameProcess::spawn(const wchar_t *dir, bool suspended)
+{
+	std::wstring command = dir;
+	STARTUPINFOW si;
+
+	if (_running) {
+		return false;
+	}
+
+	command += L"\\Sonic_vis.exe";
+
+	SecureZeroMemory(&si, sizeof(si));
+	si.cb = sizeof(si);
+	SecureZeroMemory(&_pi, sizeof(_pi));
+
+	/* CreateProcessW() may modify the command line buffer */
+	std::vector<wchar_t> buf(command.begin(), command.end());
+	buf.push_back(0);
+
+	TRACE_SCOPE("CreateProcessW");
+
+	if (CreateProcessW(NULL, buf.data(), NULL, NULL, FALSE, suspended ? CREATE_SUSPENDED : 0, NULL, NULL, &si, &_pi) == FALSE) {
+		return false;
+	}
+
+	_running = true;
+	_resumed = suspended ? 0 : clock_us();
+
+	/* Windows closes the handle when the launcher dies, which takes a
+	 * suspended game along instead of leaving it behind */
+	if (suspended) {
+		_job = CreateJobObjectW(NULL, NULL);
+
+		if (!_job || !set_kill_on_close(_job, true) || !AssignProcessToJobObject(_job, _pi.hProcess)) {
+			discard();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool gameProcess::resume()
+{
+	if (!_running) {
+		return false;
+	}
+
+	/* from here on the game outlives the launcher */
+	if (_job && !set_kill_on_close(_job, false)) {
+		return false;
+	}
+
+	uint64_t now = clock_us();
+
+	/* still suspended: discard() has to kill it, and so does the job */
+	if (ResumeThread(_pi.hThread) == static_cast<DWORD>(-1)) {
+		if (_job) {
+			set_kill_on_close(_job, true);
+		}
+		return false;
+	}
+
+	_resumed = now;
+	return true;
+}
+
+DWORD gameProcess::wait(DWORD *exitCode)
+{
+	DWORD rv;
+
+	if (!_running) {
+		return WAIT_FAILED;
+	}
+
+	rv = WaitForSingleObject(_pi.hProcess, INFINITE);
+
+	if (rv == WAIT_OBJECT_0 && exitCode) {
+		GetExitCodeProcess(_pi.hProcess, exitCode);
+	}
+
+	return rv;
+}
+
+void gameProcess::close()
+{
+	if (!_running) {
+		return;
+	}
+
+	if (_job) {
+		CloseHandle(_job);
+		_job = NULL;
+	}
+	CloseHandle(_pi.hProcess);
+	CloseHandle(_pi.hThread);
+	SecureZeroMemory(&_pi, sizeof(_pi));
+	_running = false;
+}
+
+void gameProcess::discard()
+{
+	if (suspended()) {
+		TerminateProcess(_pi.hProcess, 1);
+		WaitForSingleObject(_pi.hProcess, INFINITE);
+	}
+	close();
+	_resumed = 0;
+}
+
+bool gamePrefetch::mapFile(const wchar_t *path)
+{
+	HANDLE file, map;
+	const void *view;
+	DWORD size;
+
+	file = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	size = GetFileSize(file, NULL);
+	if (size == 0 || size == INVALID_FILE_SIZE) {
+		CloseHandle(file);
+		return false;
+	}
+
+	/* the mapping keeps its own reference to the file */
+	map = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(file);
+	if (!map) {
+		return false;
+	}
+
+	if ((view = MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0)) == NULL) {
+		CloseHandle(map);
+		return false;
+	}
+
+	_maps.push_back(map);
+	_views.push_back(view);
+	_bytes += size;
+
+	return true;
+}
+
+size_t gamePrefetch::load(const wchar_t *dir)
+{
+	std::wstring path = dir;
+	std::wstring pattern = path + L"\\*.dll";
+	WIN32_FIND_DATAW fd;
+	HANDLE h;
+
+	release();
+	mapFile((path + L"\\Sonic_vis.exe").c_str());
+
+	if ((h = FindFirstFileW(pattern.c_str(), &fd)) != INVALID_HANDLE_VALUE) {
+		do {
+			if ((fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0) {
+				mapFile((path + L"\\" + fd.cFileName).c_str());
+			}
+		} while (FindNextFileW(h, &fd));
+		FindClose(h);
+	}
+
+	touch();
+	return _bytes;
+}
+
+void gamePrefetch::touch()
+{
+	volatile uint8_t sum = 0;
+
+	for (size_t i = 0; i < _views.size(); ++i) {
+		const uint8_t *p = reinterpret_cast<const uint8_t *>(_views[i]);
+		MEMORY_BASIC_INFORMATION mbi;
+
+		if (VirtualQuery(p, &mbi, sizeof(mbi)) == 0) {
+			continue;
+		}
+		for (size_t off = 0; off < mbi.RegionSize; off += PAGE_SIZE_4K) {
+			sum += p[off];
+		}
+	}
+	(void)sum;
+}
+
+void gamePrefetch::release()
+{
+	for (size_t i = 0; i < _views.size(); ++i) {
+		UnmapViewOfFile(_views[i]);
+		CloseHandle(_maps[i]);
+	}
+	_views.clear();
+	_maps.clear();
+	_bytes = 0;
+}
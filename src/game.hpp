@@ -0,0 +1,91 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef GAME_HPP
+#define GAME_HPP
+
+#include <windows.h>
+#include <stdint.h>
+#include <vector>
+
+
+/* the Sonic_vis.exe child process */
+class gameProcess
+{
+private:
+	PROCESS_INFORMATION _pi;
+	HANDLE _job = NULL;  /* kills a suspended process with the launcher */
+	bool _running = false;
+	uint64_t _resumed = 0;
+
+public:
+	gameProcess() { SecureZeroMemory(&_pi, sizeof(_pi)); }
+	gameProcess(const gameProcess &) = delete;
+	gameProcess &operator=(const gameProcess &) = delete;
+	~gameProcess() { discard(); }
+
+	/* create the process in the game directory; a suspended process
+	 * doesn't execute any code until resume() was called. Until then it's
+	 * in a job object that kills it when the launcher goes away without
+	 * calling discard(). */
+	bool spawn(const wchar_t *dir, bool suspended);
+	bool resume();
+
+	/* WaitForSingleObject() result; exitCode is set on WAIT_OBJECT_0 */
+	DWORD wait(DWORD *exitCode);
+
+	void close();
+
+	/* kill a process that was never resumed, then close() */
+	void discard();
+
+	bool running() { return _running; }
+	bool suspended() { return _running && _resumed == 0; }
+
+	/* clock_us() timestamp of when the main thread was released */
+	uint64_t resumed() { return _resumed; }
+};
+
+/* Maps the game executable and its DLLs and touches every page, so a
+ * relaunch doesn't have to wait for the disk. The views are kept open
+ * to keep the pages referenced between runs. */
+class gamePrefetch
+{
+private:
+	std::vector<HANDLE> _maps;
+	std::vector<const void *> _views;
+	size_t _bytes = 0;
+
+	bool mapFile(const wchar_t *path);
+
+public:
+	~gamePrefetch() { release(); }
+
+	size_t load(const wchar_t *dir);
+	void touch();
+	void release();
+	size_t bytes() { return _bytes; }
+};
+
+#endif  /* GAME_HPP */
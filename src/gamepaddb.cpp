@@ -0,0 +1,269 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+
+#include "gamepaddb.hpp"
+#include "trace.hpp"
+
+
+static bool is_guid(const char *p)
+{
+	for (int i = 0; i < GAMEPADDB_GUID_LENGTH; ++i) {
+		if (!((p[i] >= '0' && p[i] <= '9') || (p[i] >= 'a' && p[i] <= 'f'))) {
+			return false;
+		}
+	}
+	return p[GAMEPADDB_GUID_LENGTH] == ',';
+}
+
+/* lines without a platform field apply everywhere */
+static bool for_this_platform(const char *line, const char *eol)
+{
+	static const char key[] = "platform:";
+	static const char platform[] = GAMEPADDB_PLATFORM ",";
+	std::string_view s(line, eol - line);
+	size_t pos = s.find(key);
+
+	if (pos == std::string_view::npos) {
+		return true;
+	}
+	return s.compare(pos + sizeof(key) - 1, sizeof(platform) - 1, platform) == 0;
+}
+
+/* splitmix64 finalizer */
+static uint64_t mix(uint64_t x)
+{
+	x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+	x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+	return x ^ (x >> 31);
+}
+
+uint64_t gamepadDb::hash(const char *guid) const
+{
+	uint64_t h = 14695981039346656037ull ^ _seed;
+
+	/* FNV-1a */
+	for (int i = 0; i < GAMEPADDB_GUID_LENGTH; ++i) {
+		h = (h ^ static_cast<unsigned char>(guid[i])) * 1099511628211ull;
+	}
+	return mix(h);
+}
+
+size_t gamepadDb::slot(uint64_t h, uint32_t d) const
+{
+	return static_cast<size_t>(mix(h + d) % _slots.size());
+}
+
+/* place the lines, fullest buckets first; false if a bucket doesn't fit
+ * with any displacement, then the caller tries another seed */
+bool gamepadDb::build(const std::vector<uint32_t> &lines)
+{
+	size_t nbuckets = lines.size() / GAMEPADDB_BUCKET_KEYS + 1;
+	std::vector<std::vector<uint32_t>> buckets(nbuckets);
+	std::vector<size_t> order(nbuckets);
+	std::vector<size_t> taken;
+
+	_displace.assign(nbuckets, 0);
+	_slots.assign(lines.size() + lines.size() / 8 + 1, 0);
+
+	for (size_t i = 0; i < lines.size(); ++i) {
+		buckets[(hash(_data + lines[i]) >> 32) % nbuckets].push_back(lines[i]);
+	}
+
+	for (size_t i = 0; i < nbuckets; ++i) {
+		order[i] = i;
+	}
+	std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+		return buckets[a].size() > buckets[b].size();
+	});
+
+	for (size_t i = 0; i < nbuckets && !buckets[order[i]].empty(); ++i) {
+		const std::vector<uint32_t> &bucket = buckets[order[i]];
+		uint32_t d;
+
+		for (d = 0; d < GAMEPADDB_MAX_DISPLACE; ++d) {
+			taken.clear();
+
+			for (size_t k = 0; k < bucket.size(); ++k) {
+				size_t s = slot(hash(_data + bucket[k]), d);
+
+				if (_slots[s] != 0 || std::find(taken.begin(), taken.end(), s) != taken.end()) {
+					break;
+				}
+				taken.push_back(s);
+			}
+
+			if (taken.size() == bucket.size()) {
+				break;
+			}
+		}
+
+		if (d == GAMEPADDB_MAX_DISPLACE) {
+			return false;
+		}
+
+		_displace[order[i]] = d;
+		for (size_t k = 0; k < bucket.size(); ++k) {
+			_slots[taken[k]] = bucket[k] + 1;
+		}
+	}
+
+	return true;
+}
+
+bool gamepadDb::load(const char *data, size_t size)
+{
+	TRACE_SCOPE("gamepadDb::load");
+
+	std::vector<uint32_t> lines;
+
+	/* open() calls this with the file it just mapped */
+	reset();
+
+	if (size >= UINT32_MAX) {
+		return false;
+	}
+	_data = data;
+	_size = size;
+
+	for (const char *p = data, *end = data + size; p < end; ) {
+		const char *eol = static_cast<const char *>(memchr(p, '\n', end - p));
+
+		if (!eol) {
+			eol = end;
+		}
+		if (eol - p > GAMEPADDB_GUID_LENGTH && is_guid(p) && for_this_platform(p, eol)) {
+			lines.push_back(static_cast<uint32_t>(p - data));
+		}
+		p = eol + 1;
+	}
+
+	/* by GUID, later lines after earlier ones; keep the last of each GUID */
+	std::stable_sort(lines.begin(), lines.end(), [&](uint32_t a, uint32_t b) {
+		return memcmp(data + a, data + b, GAMEPADDB_GUID_LENGTH) < 0;
+	});
+	size_t n = 0;
+
+	for (size_t i = 0; i < lines.size(); ++i) {
+		if (i + 1 < lines.size() && memcmp(data + lines[i], data + lines[i + 1], GAMEPADDB_GUID_LENGTH) == 0) {
+			continue;
+		}
+		lines[n++] = lines[i];
+	}
+	lines.resize(n);
+
+	for (int seed = 0; seed < GAMEPADDB_SEEDS; ++seed) {
+		_seed = mix(seed);
+
+		if (build(lines)) {
+			return true;
+		}
+	}
+
+	reset();
+	return false;
+}
+
+bool gamepadDb::open(const wchar_t *path)
+{
+	close();
+
+	if (!_map.open(path, false)) {
+		return false;
+	}
+	if (!load(_map.data(), _map.size())) {
+		_map.close();
+		return false;
+	}
+	return true;
+}
+
+void gamepadDb::close()
+{
+	_map.close();
+	reset();
+}
+
+void gamepadDb::reset()
+{
+	_data = NULL;
+	_size = 0;
+	_displace.clear();
+	_slots.clear();
+}
+
+size_t gamepadDb::count() const
+{
+	return _slots.size() - std::count(_slots.begin(), _slots.end(), 0u);
+}
+
+std::string_view gamepadDb::find(const char *guid) const
+{
+	if (_slots.empty()) {
+		return std::string_view();
+	}
+
+	uint64_t h = hash(guid);
+	uint32_t line = _slots[slot(h, _displace[(h >> 32) % _displace.size()])];
+
+	if (line == 0 || memcmp(_data + line - 1, guid, GAMEPADDB_GUID_LENGTH) != 0) {
+		return std::string_view();
+	}
+
+	const char *p = _data + line - 1;
+	const char *eol = static_cast<const char *>(memchr(p, '\n', _size - (line - 1)));
+	size_t n = eol ? eol - p : _size - (line - 1);
+
+	if (n > 0 && p[n - 1] == '\r') {
+		n--;
+	}
+	return std::string_view(p, n);
+}
+
+std::string_view gamepadDb::name(std::string_view line)
+{
+	if (line.size() <= GAMEPADDB_GUID_LENGTH + 1) {
+		return std::string_view();
+	}
+
+	std::string_view s = line.substr(GAMEPADDB_GUID_LENGTH + 1);
+	return s.substr(0, s.find(','));
+}
+
+void gamepadDb::usb_guid(char *guid, unsigned int vendor, unsigned int product)
+{
+	/* bus 3 (USB), vendor and product as little endian 16 bit values */
+	snprintf(guid, GAMEPADDB_GUID_LENGTH + 1, "03000000%02x%02x0000%02x%02x000000000000",
+		vendor & 0xFF, (vendor >> 8) & 0xFF, product & 0xFF, (product >> 8) & 0xFF);
+}
+
+void gamepadDb::raw_guid(char *guid, const unsigned char *bytes)
+{
+	for (int i = 0; i < GAMEPADDB_GUID_LENGTH / 2; ++i) {
+		snprintf(guid + i * 2, 3, "%02x", bytes[i]);
+	}
+}
@@ -0,0 +1,98 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* SDL game controller mappings, from a gamecontrollerdb.txt next to the
+ * exe (https://github.com/gabomdq/SDL_GameControllerDB). Each line is
+ * "<GUID>,<name>,<mapping>,...,platform:<platform>,". The file is mapped
+ * and only the GUIDs and platforms are scanned; the lines for this
+ * platform go into a perfect hash (hash and displace), so a lookup hashes
+ * the GUID once and compares it with a single line. A GUID that appears
+ * more than once resolves to its last line, like in SDL. */
+
+#ifndef GAMEPADDB_HPP
+#define GAMEPADDB_HPP
+
+#include <string_view>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mapfile.hpp"
+
+#define GAMEPADDB_FILE          L"gamecontrollerdb.txt"
+#define GAMEPADDB_GUID_LENGTH   32  /* hex digits */
+#define GAMEPADDB_BUCKET_KEYS   4   /* average keys per bucket */
+#define GAMEPADDB_MAX_DISPLACE  (1 << 16)
+#define GAMEPADDB_SEEDS         8
+
+#ifdef _WIN32
+#define GAMEPADDB_PLATFORM  "Windows"
+#else
+#define GAMEPADDB_PLATFORM  "Linux"
+#endif
+
+
+class gamepadDb
+{
+private:
+	mappedFile _map;
+	const char *_data = NULL;
+	size_t _size = 0;
+	uint64_t _seed = 0;
+	std::vector<uint32_t> _displace;  /* per bucket */
+	std::vector<uint32_t> _slots;     /* line offset + 1, 0 if empty */
+
+	uint64_t hash(const char *guid) const;
+	size_t slot(uint64_t h, uint32_t d) const;
+	bool build(const std::vector<uint32_t> &lines);
+
+	/* drop the index, not the mapping */
+	void reset();
+
+public:
+	/* map and index a database file */
+	bool open(const wchar_t *path);
+
+	/* index data, which has to stay around */
+	bool load(const char *data, size_t size);
+
+	void close();
+
+	/* GUIDs in the index */
+	size_t count() const;
+
+	/* the line for a GUID of GAMEPADDB_GUID_LENGTH lower case hex digits,
+	 * without the line end; empty if there is none */
+	std::string_view find(const char *guid) const;
+
+	/* the name in a line returned by find() */
+	static std::string_view name(std::string_view line);
+
+	/* GUID as SDL makes it for a USB device, and as older SDL versions
+	 * made it from the DirectInput product GUID */
+	static void usb_guid(char *guid, unsigned int vendor, unsigned int product);
+	static void raw_guid(char *guid, const unsigned char *bytes);
+};
+
+#endif  /* GAMEPADDB_HPP */
@@ -0,0 +1,362 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef _WIN32
+#include <windows.h>
+#include <dbt.h>
+#include <hidsdi.h>
+#include <setupapi.h>
+#else
+#include <dirent.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <string.h>
+
+#include "hotplug.hpp"
+#include "trace.hpp"
+
+#ifdef _WIN32
+#define HOTPLUG_CLASS  L"SonicLauncherHotplug"
+#define WM_HOTPLUG_STOP  (WM_APP + 1)
+
+/* older hidusage.h don't have it */
+#ifndef HID_USAGE_GENERIC_MULTI_AXIS_CONTROLLER
+#define HID_USAGE_GENERIC_MULTI_AXIS_CONTROLLER  0x08
+#endif
+
+/* GUID_DEVINTERFACE_HID, keyboards, mice and game controllers */
+static const GUID hidInterface = { 0x4D1E55B2, 0xF16F, 0x11CF, { 0x88, 0xCB, 0x00, 0x11, 0x11, 0x00, 0x00, 0x30 } };
+#elif !defined(HOTPLUG_DIR)
+#define HOTPLUG_DIR  "/dev/input"
+#endif
+
+
+void hotplugMonitor::changed(const std::string &path, bool added)
+{
+	_lock.lock();
+
+	std::vector<std::string>::iterator it = std::find(_devices.begin(), _devices.end(), path);
+	bool change = added ? (it == _devices.end()) : (it != _devices.end());
+
+	if (change && added) {
+		_devices.push_back(path);
+	} else if (change) {
+		_devices.erase(it);
+	}
+
+	_lock.unlock();
+
+	if (change) {
+		Fl::awake(_cb, _data);
+	}
+}
+
+std::vector<std::string> hotplugMonitor::devices()
+{
+	_lock.lock();
+	std::vector<std::string> v = _devices;
+	_lock.unlock();
+
+	return v;
+}
+
+void hotplugMonitor::monitorThread(void *p)
+{
+	reinterpret_cast<hotplugMonitor *>(p)->run();
+}
+
+bool hotplugMonitor::start(Fl_Awake_Handler cb, void *data)
+{
+	TRACE_SCOPE("hotplugMonitor::start");
+
+	_cb = cb;
+	_data = data;
+
+	if (!_thread.start(monitorThread, this)) {
+		return false;
+	}
+
+	/* the thread lists the present devices first */
+	_started.wait();
+
+	if (!_ok) {
+		_thread.join();
+	}
+	return _ok;
+}
+
+#ifdef _WIN32
+
+/* SetupAPI and the notifications don't agree on the case of the paths */
+static std::string lower(const char *s)
+{
+	std::string path = s;
+
+	std::transform(path.begin(), path.end(), path.begin(), [](char c) {
+		return static_cast<char>((c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c);
+	});
+	return path;
+}
+
+/* only the top level collection is needed, opening the device without
+ * access rights works for devices other processes have open */
+static bool is_game_controller(const char *path)
+{
+	HANDLE h = CreateFileA(path, 0, FILE_SHARE_READ|FILE_SHARE_WRITE, NULL, OPEN_EXISTING, 0, NULL);
+	PHIDP_PREPARSED_DATA data;
+	HIDP_CAPS caps;
+	bool rv = false;
+
+	if (h == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	if (HidD_GetPreparsedData(h, &data)) {
+		if (HidP_GetCaps(data, &caps) == HIDP_STATUS_SUCCESS && caps.UsagePage == HID_USAGE_PAGE_GENERIC) {
+			/* what DirectInput lists as game controllers */
+			rv = (caps.Usage == HID_USAGE_GENERIC_JOYSTICK || caps.Usage == HID_USAGE_GENERIC_GAMEPAD ||
+				caps.Usage == HID_USAGE_GENERIC_MULTI_AXIS_CONTROLLER);
+		}
+		HidD_FreePreparsedData(data);
+	}
+
+	CloseHandle(h);
+	return rv;
+}
+
+/* present game controllers */
+void hotplugMonitor::scan()
+{
+	HDEVINFO info = SetupDiGetClassDevsW(&hidInterface, NULL, NULL, DIGCF_PRESENT|DIGCF_DEVICEINTERFACE);
+	SP_DEVICE_INTERFACE_DATA iface;
+	DWORD buf[256];
+	SP_DEVICE_INTERFACE_DETAIL_DATA_A *detail = reinterpret_cast<SP_DEVICE_INTERFACE_DETAIL_DATA_A *>(buf);
+
+	if (info == INVALID_HANDLE_VALUE) {
+		return;
+	}
+
+	iface.cbSize = sizeof(iface);
+
+	for (DWORD i = 0; SetupDiEnumDeviceInterfaces(info, NULL, &hidInterface, i, &iface); ++i) {
+		detail->cbSize = sizeof(*detail);
+
+		if (SetupDiGetDeviceInterfaceDetailA(info, &iface, detail, sizeof(buf), NULL, NULL) &&
+			is_game_controller(detail->DevicePath))
+		{
+			_devices.push_back(lower(detail->DevicePath));
+		}
+	}
+
+	SetupDiDestroyDeviceInfoList(info);
+}
+
+LRESULT CALLBACK hotplugMonitor::wndproc(HWND hwnd, UINT msg, WPARAM wp, LPARAM lp)
+{
+	hotplugMonitor *self = reinterpret_cast<hotplugMonitor *>(GetWindowLongPtrW(hwnd, GWLP_USERDATA));
+	DEV_BROADCAST_HDR *hdr = reinterpret_cast<DEV_BROADCAST_HDR *>(lp);
+
+	if (msg == WM_DEVICECHANGE && self && hdr && hdr->dbch_devicetype == DBT_DEVTYP_DEVICEINTERFACE &&
+		(wp == DBT_DEVICEARRIVAL || wp == DBT_DEVICEREMOVECOMPLETE))
+	{
+		DEV_BROADCAST_DEVICEINTERFACE_A *di = reinterpret_cast<DEV_BROADCAST_DEVICEINTERFACE_A *>(lp);
+
+		/* a removed device can't be asked, changed() ignores it unless it's listed */
+		if (wp == DBT_DEVICEREMOVECOMPLETE || is_game_controller(di->dbcc_name)) {
+			self->changed(lower(di->dbcc_name), wp == DBT_DEVICEARRIVAL);
+		}
+		return TRUE;
+	}
+
+	return DefWindowProcW(hwnd, msg, wp, lp);
+}
+
+void hotplugMonitor::run()
+{
+	WNDCLASSEXW wc;
+	DEV_BROADCAST_DEVICEINTERFACE_A filter;
+	HDEVNOTIFY notify = NULL;
+	MSG msg;
+
+	memset(&wc, 0, sizeof(wc));
+	wc.cbSize = sizeof(wc);
+	wc.lpfnWndProc = wndproc;
+	wc.hInstance = GetModuleHandleW(NULL);
+	wc.lpszClassName = HOTPLUG_CLASS;
+	RegisterClassExW(&wc);
+
+	_hwnd = CreateWindowExW(0, HOTPLUG_CLASS, NULL, 0, 0, 0, 0, 0, HWND_MESSAGE, NULL, wc.hInstance, NULL);
+
+	if (_hwnd) {
+		SetWindowLongPtrW(_hwnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(this));
+
+		memset(&filter, 0, sizeof(filter));
+		filter.dbcc_size = sizeof(filter);
+		filter.dbcc_devicetype = DBT_DEVTYP_DEVICEINTERFACE;
+		filter.dbcc_classguid = hidInterface;
+		notify = RegisterDeviceNotificationA(_hwnd, &filter, DEVICE_NOTIFY_WINDOW_HANDLE);
+	}
+
+	if (!notify) {
+		if (_hwnd) {
+			DestroyWindow(_hwnd);
+			_hwnd = NULL;
+		}
+		_started.set();
+		return;
+	}
+
+	/* after registering, so nothing gets lost in between */
+	_lock.lock();
+	scan();
+	_lock.unlock();
+
+	_ok = true;
+	_started.set();
+
+	while (GetMessageW(&msg, NULL, 0, 0) > 0 && msg.message != WM_HOTPLUG_STOP) {
+		DispatchMessageW(&msg);
+	}
+
+	UnregisterDeviceNotification(notify);
+	DestroyWindow(_hwnd);
+}
+
+void hotplugMonitor::stop()
+{
+	if (_ok) {
+		PostMessageW(_hwnd, WM_HOTPLUG_STOP, 0, 0);
+		_thread.join();
+		_hwnd = NULL;
+		_ok = false;
+	}
+}
+
+#else  /* _WIN32 */
+
+/* joydev only creates nodes for joysticks and gamepads */
+static bool is_game_controller(const char *name)
+{
+	return strncmp(name, "js", 2) == 0;
+}
+
+void hotplugMonitor::run()
+{
+	DIR *dir;
+	struct dirent *ent;
+	char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+	_inotify = inotify_init1(IN_CLOEXEC);
+
+	if (_inotify < 0 || pipe(_stop) != 0 ||
+		inotify_add_watch(_inotify, HOTPLUG_DIR, IN_CREATE|IN_DELETE|IN_ATTRIB|IN_MOVED_TO|IN_MOVED_FROM) < 0)
+	{
+		if (_inotify >= 0) {
+			close(_inotify);
+			_inotify = -1;
+		}
+		if (_stop[0] >= 0) {
+			close(_stop[0]);
+			close(_stop[1]);
+			_stop[0] = _stop[1] = -1;
+		}
+		_started.set();
+		return;
+	}
+
+	/* after adding the watch, so nothing gets lost in between */
+	if ((dir = opendir(HOTPLUG_DIR)) != NULL) {
+		_lock.lock();
+		while ((ent = readdir(dir)) != NULL) {
+			if (is_game_controller(ent->d_name)) {
+				_devices.push_back(std::string(HOTPLUG_DIR "/") + ent->d_name);
+			}
+		}
+		_lock.unlock();
+		closedir(dir);
+	}
+
+	_ok = true;
+	_started.set();
+
+	struct pollfd fds[2] = {
+		{ _inotify, POLLIN, 0 },
+		{ _stop[0], POLLIN, 0 }
+	};
+
+	/* blocks until something happens */
+	while (true) {
+		if (poll(fds, 2, -1) < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			break;
+		}
+		if (fds[1].revents & POLLIN) {
+			break;
+		}
+
+		ssize_t n = read(_inotify, buf, sizeof(buf));
+
+		for (ssize_t i = 0; i < n; ) {
+			const struct inotify_event *ev = reinterpret_cast<const struct inotify_event *>(buf + i);
+
+			if (ev->len > 0 && is_game_controller(ev->name)) {
+				/* udev creates the node first and makes it readable later */
+				bool added = (ev->mask & (IN_CREATE|IN_ATTRIB|IN_MOVED_TO)) != 0;
+				std::string path = std::string(HOTPLUG_DIR "/") + ev->name;
+
+				if (!added || access(path.c_str(), R_OK) == 0) {
+					changed(path, added);
+				}
+			}
+			i += sizeof(struct inotify_event) + ev->len;
+		}
+	}
+
+	close(_inotify);
+	_inotify = -1;
+}
+
+void hotplugMonitor::stop()
+{
+	if (_ok) {
+		char c = 0;
+
+		if (write(_stop[1], &c, 1) == 1) {
+			_thread.join();
+		}
+		close(_stop[0]);
+		close(_stop[1]);
+		_stop[0] = _stop[1] = -1;
+		_ok = false;
+	}
+}
+
+#endif  /* _WIN32 */
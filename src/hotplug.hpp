@@ -0,0 +1,80 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Notices game controllers being plugged in and out, without polling: a
+ * background thread waits for HID interface notifications on a
+ * message-only window (Windows) or for inotify events on /dev/input
+ * (Linux). It keeps the list of controller paths up to date and hands
+ * every change to it to the FLTK loop with Fl::awake(), which needs
+ * Fl::lock() to have been called. Keyboards, mice and other HID devices
+ * are left out, so they don't wake the UI. */
+
+#ifndef HOTPLUG_HPP
+#define HOTPLUG_HPP
+
+#include <FL/Fl.H>
+
+#include <string>
+#include <vector>
+
+#include "threads.hpp"
+
+
+class hotplugMonitor
+{
+private:
+	mutex _lock;
+	std::vector<std::string> _devices;
+	Fl_Awake_Handler _cb = NULL;
+	void *_data = NULL;
+	event _started;
+	bool _ok = false;
+	thread _thread;
+#ifdef _WIN32
+	HWND _hwnd = NULL;
+
+	static LRESULT CALLBACK wndproc(HWND hwnd, UINT msg, WPARAM wp, LPARAM lp);
+	void scan();
+#else
+	int _inotify = -1;
+	int _stop[2] = { -1, -1 };  /* pipe, written to by stop() */
+#endif
+
+	static void monitorThread(void *p);
+	void run();
+	void changed(const std::string &path, bool added);
+
+public:
+	~hotplugMonitor() { stop(); }
+
+	/* list the present devices and start watching; cb gets called on the
+	 * FLTK thread after each change */
+	bool start(Fl_Awake_Handler cb, void *data);
+	void stop();
+
+	/* game controller paths at the time of the call */
+	std::vector<std::string> devices();
+};
+
+#endif  /* HOTPLUG_HPP */
@@ -0,0 +1,99 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "input.hpp"
+#include "trace.hpp"
+
+// https://blogs.msdn.microsoft.com/oldnewthing/20041025-00/?p=37483
+// https://stackoverflow.com/a/557859
+EXTERN_C IMAGE_DOS_HEADER __ImageBase;
+#define HINST_THISCOMPONENT  reinterpret_cast<HINSTANCE>(&__ImageBase)
+
+bool DirectInput::init()
+{
+	TRACE_SCOPE("DirectInput::init");
+
+	if (DirectInput8Create(HINST_THISCOMPONENT, DIRECTINPUT_VERSION, IID_IDirectInput8, reinterpret_cast<LPVOID *>(&m_directInput), NULL) != DI_OK)	{
+		return false;
+	}
+
+	if (m_directInput->CreateDevice(GUID_SysKeyboard, &m_keyboard, NULL) != DI_OK) {
+		return false;
+	}
+
+	if (m_keyboard->SetDataFormat(&c_dfDIKeyboard) != DI_OK) {
+		return false;
+	}
+
+	if (m_keyboard->Acquire() != DI_OK) {
+		return false;
+	}
+
+	return true;
+}
+
+typedef struct {
+	GUID *products;
+	int max;
+	int n;
+} gamepadList_t;
+
+static BOOL CALLBACK add_gamepad(LPCDIDEVICEINSTANCE inst, LPVOID ctx)
+{
+	gamepadList_t *list = reinterpret_cast<gamepadList_t *>(ctx);
+
+	list->products[list->n++] = inst->guidProduct;
+	return (list->n < list->max) ? DIENUM_CONTINUE : DIENUM_STOP;
+}
+
+int DirectInput::Gamepads(GUID *products, int max)
+{
+	gamepadList_t list = { products, max, 0 };
+
+	if (!m_directInput || max < 1) {
+		return 0;
+	}
+	m_directInput->EnumDevices(DI8DEVCLASS_GAMECTRL, add_gamepad, &list, DIEDFL_ATTACHEDONLY);
+
+	return list.n;
+}
+
+bool DirectInput::ReadKeyboard()
+{
+	memset(m_keyboardState, 0, sizeof(m_keyboardState));
+
+	HRESULT res = m_keyboard->GetDeviceState(sizeof(m_keyboardState), reinterpret_cast<LPVOID>(m_keyboardState));
+
+	if (res != DI_OK) {
+		/* If the keyboard lost focus or was not acquired then try to get control back. */
+		if (res == DIERR_INPUTLOST || res == DIERR_NOTACQUIRED) {
+			m_keyboard->Acquire();
+		} else {
+			return false;
+		}
+	}
+	return true;
+}
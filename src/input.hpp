@@ -0,0 +1,62 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Keyboard access through DirectInput, which sees the same scan codes the
+ * game does. The launcher reads the whole keyboard state to rebind keys;
+ * -InputDiag opens buffered devices on the same interface, see
+ * inputdiag.hpp. */
+
+#ifndef INPUT_HPP
+#define INPUT_HPP
+
+#include <windows.h>
+
+#ifndef DIRECTINPUT_VERSION
+#define DIRECTINPUT_VERSION 0x0800
+#endif
+#include <dinput.h>
+
+
+class DirectInput
+{
+private:
+	IDirectInput8 *m_directInput = NULL;
+	IDirectInputDevice8 *m_keyboard = NULL;
+
+public:
+	unsigned char m_keyboardState[256] = { 0 };
+
+	DirectInput() {}
+
+	bool init();
+	bool ReadKeyboard();
+
+	/* product GUIDs of up to max attached game controllers */
+	int Gamepads(GUID *products, int max);
+
+	/* NULL until init() succeeded */
+	IDirectInput8 *Interface() { return m_directInput; }
+};
+
+#endif  /* INPUT_HPP */
@@ -0,0 +1,336 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <windows.h>
+#include <mmsystem.h>
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "clock.hpp"
+#include "inputdiag.hpp"
+#include "threads.hpp"
+
+
+typedef struct {
+	char name[16];
+	IDirectInputDevice8 *dev;
+	bool gamepad;
+	uint64_t lastPoll;
+	std::vector<uint32_t> intervals;  /* us */
+	std::vector<uint32_t> latencies;  /* ms */
+	unsigned long overflows;
+	unsigned long unpaired;
+	unsigned long lost;  /* times the device had to be acquired again */
+	unsigned char pressed[256];
+} diagDevice_t;
+
+typedef struct {
+	IDirectInput8 *dinput;
+	diagDevice_t *devices;
+	int ndevices;
+	int gamepads;
+	std::atomic<bool> stop;
+} diagState_t;
+
+
+static bool open_device(IDirectInput8 *dinput, REFGUID guid, bool gamepad, diagDevice_t *d)
+{
+	DIPROPDWORD prop;
+
+	memset(d->pressed, 0, sizeof(d->pressed));
+	d->dev = NULL;
+	d->gamepad = gamepad;
+	d->lastPoll = 0;
+	d->overflows = d->unpaired = d->lost = 0;
+
+	if (dinput->CreateDevice(guid, &d->dev, NULL) != DI_OK) {
+		d->dev = NULL;
+		return false;
+	}
+
+	prop.diph.dwSize = sizeof(DIPROPDWORD);
+	prop.diph.dwHeaderSize = sizeof(DIPROPHEADER);
+	prop.diph.dwObj = 0;
+	prop.diph.dwHow = DIPH_DEVICE;
+	prop.dwData = INPUTDIAG_BUFFER;
+
+	if (d->dev->SetDataFormat(gamepad ? &c_dfDIJoystick2 : &c_dfDIKeyboard) != DI_OK ||
+		d->dev->SetProperty(DIPROP_BUFFERSIZE, &prop.diph) != DI_OK)
+	{
+		d->dev->Release();
+		d->dev = NULL;
+		return false;
+	}
+
+	d->dev->Acquire();
+	return true;
+}
+
+static BOOL CALLBACK enum_gamepad(LPCDIDEVICEINSTANCE inst, LPVOID ctx)
+{
+	diagState_t *st = reinterpret_cast<diagState_t *>(ctx);
+	diagDevice_t *d = st->devices + st->ndevices;
+
+	if (open_device(st->dinput, inst->guidInstance, true, d)) {
+		snprintf(d->name, sizeof(d->name), "gamepad%d", st->gamepads++);
+		st->ndevices++;
+	}
+
+	return (st->gamepads < INPUTDIAG_MAX_GAMEPADS) ? DIENUM_CONTINUE : DIENUM_STOP;
+}
+
+/* keys and buttons go down and up in turns; anything else was lost */
+static void check_pairing(diagDevice_t *d, const DIDEVICEOBJECTDATA *ev)
+{
+	DWORD index = ev->dwOfs;
+
+	if (d->gamepad) {
+		if (ev->dwOfs < offsetof(DIJOYSTATE2, rgbButtons) ||
+			ev->dwOfs >= offsetof(DIJOYSTATE2, rgbButtons) + sizeof(d->pressed) / 2)
+		{
+			return;  /* axis or POV */
+		}
+		index = ev->dwOfs - offsetof(DIJOYSTATE2, rgbButtons);
+	}
+
+	if (index >= sizeof(d->pressed)) {
+		return;
+	}
+
+	unsigned char down = (ev->dwData & 0x80) ? 1 : 0;
+
+	if (d->pressed[index] == down) {
+		d->unpaired++;
+	}
+	d->pressed[index] = down;
+}
+
+static void poll_device(diagDevice_t *d)
+{
+	DIDEVICEOBJECTDATA buf[INPUTDIAG_BUFFER];
+	DWORD n;
+	HRESULT res;
+
+	if (d->gamepad) {
+		d->dev->Poll();
+	}
+
+	do {
+		n = INPUTDIAG_BUFFER;
+		res = d->dev->GetDeviceData(sizeof(DIDEVICEOBJECTDATA), buf, &n, 0);
+
+		if (res == DIERR_INPUTLOST || res == DIERR_NOTACQUIRED) {
+			d->dev->Acquire();
+			d->lost++;
+			return;
+		} else if (res == DI_BUFFEROVERFLOW) {
+			d->overflows++;
+		} else if (res != DI_OK) {
+			return;
+		}
+
+		DWORD observed = GetTickCount();
+
+		for (DWORD i = 0; i < n; ++i) {
+			/* unsigned, so a wrapped tick count still works */
+			d->latencies.push_back(observed - buf[i].dwTimeStamp);
+			check_pairing(d, buf + i);
+		}
+	} while (n == INPUTDIAG_BUFFER);
+
+	uint64_t now = clock_us();
+
+	if (d->lastPoll) {
+		d->intervals.push_back(static_cast<uint32_t>(now - d->lastPoll));
+	}
+	d->lastPoll = now;
+}
+
+static void poll_thread(void *p)
+{
+	diagState_t *st = reinterpret_cast<diagState_t *>(p);
+
+	while (!st->stop.load()) {
+		for (int i = 0; i < st->ndevices; ++i) {
+			poll_device(st->devices + i);
+		}
+		Sleep(INPUTDIAG_POLL_MS);
+	}
+}
+
+/* smallest step of GetTickCount() */
+static DWORD tick_resolution(void)
+{
+	DWORD t0 = GetTickCount(), t1, t2;
+
+	while ((t1 = GetTickCount()) == t0) {}
+	while ((t2 = GetTickCount()) == t1) {}
+
+	return t2 - t1;
+}
+
+/* v is sorted */
+static uint32_t percentile(const std::vector<uint32_t> &v, int p)
+{
+	return v.empty() ? 0 : v[(v.size() - 1) * p / 100];
+}
+
+static double stddev(const std::vector<uint32_t> &v)
+{
+	double sum = 0, sq = 0;
+
+	if (v.size() < 2) {
+		return 0;
+	}
+	for (size_t i = 0; i < v.size(); ++i) {
+		sum += v[i];
+	}
+
+	double mean = sum / v.size();
+
+	for (size_t i = 0; i < v.size(); ++i) {
+		sq += (v[i] - mean) * (v[i] - mean);
+	}
+	return sqrt(sq / (v.size() - 1));
+}
+
+static void write_histogram(FILE *fp, const char *device, const char *metric,
+	const std::vector<uint32_t> &v, uint32_t bucket, int buckets)
+{
+	std::vector<unsigned long> hist(buckets, 0);
+
+	for (size_t i = 0; i < v.size(); ++i) {
+		hist[std::min(v[i] / bucket, static_cast<uint32_t>(buckets - 1))]++;
+	}
+	for (int i = 0; i < buckets; ++i) {
+		fprintf(fp, "%s\t%s\t%lu\t%lu\n", device, metric, static_cast<unsigned long>(i * bucket), hist[i]);
+	}
+}
+
+bool input_diagnostics(DirectInput *di, const char *reportFile, const char *histFile)
+{
+	const char *title = "Input diagnostics";
+	diagDevice_t devices[INPUTDIAG_MAX_GAMEPADS + 1];
+	diagState_t st;
+	thread poller;
+	char msg[512];
+
+	st.dinput = di->Interface();
+	st.devices = devices;
+	st.ndevices = 0;
+	st.gamepads = 0;
+	st.stop.store(false);
+
+	if (!st.dinput) {
+		MessageBoxA(0, "DirectInput isn't available.", title, MB_ICONERROR|MB_OK);
+		return false;
+	}
+
+	if (open_device(st.dinput, GUID_SysKeyboard, false, devices)) {
+		strcpy(devices[0].name, "keyboard");
+		st.ndevices++;
+	}
+	st.dinput->EnumDevices(DI8DEVCLASS_GAMECTRL, enum_gamepad, &st, DIEDFL_ATTACHEDONLY);
+
+	if (st.ndevices == 0) {
+		MessageBoxA(0, "No input devices found.", title, MB_ICONERROR|MB_OK);
+		return false;
+	}
+
+	DWORD tick = tick_resolution();
+
+	/* Sleep(1) really sleeps about 1 ms only like this */
+	timeBeginPeriod(1);
+	poller.start(poll_thread, &st);
+
+	snprintf(msg, sizeof(msg), "Recording %d device(s). Press keys and gamepad buttons, "
+		"then click OK to stop.", st.ndevices);
+	MessageBoxA(0, msg, title, MB_ICONINFORMATION|MB_OK);
+
+	st.stop.store(true);
+	poller.join();
+	timeEndPeriod(1);
+
+	FILE *fp = fopen(reportFile, "w");
+	FILE *hp = fopen(histFile, "w");
+	bool ok = (fp && hp);
+
+	if (ok) {
+		fprintf(fp, "device\tpolls\tinterval_p50_us\tinterval_p99_us\tinterval_max_us\tjitter_us\t"
+			"events\tlatency_p50_ms\tlatency_p90_ms\tlatency_p99_ms\tlatency_max_ms\t"
+			"overflows\tunpaired\tlost\ttick_ms\n");
+		fprintf(hp, "device\tmetric\tbucket\tcount\n");
+
+		for (int i = 0; i < st.ndevices; ++i) {
+			diagDevice_t *d = devices + i;
+
+			std::sort(d->intervals.begin(), d->intervals.end());
+			std::sort(d->latencies.begin(), d->latencies.end());
+
+			fprintf(fp, "%s\t%lu\t%lu\t%lu\t%lu\t%.0f\t%lu\t%lu\t%lu\t%lu\t%lu\t%lu\t%lu\t%lu\t%lu\n",
+				d->name,
+				static_cast<unsigned long>(d->intervals.size()),
+				static_cast<unsigned long>(percentile(d->intervals, 50)),
+				static_cast<unsigned long>(percentile(d->intervals, 99)),
+				static_cast<unsigned long>(percentile(d->intervals, 100)),
+				stddev(d->intervals),
+				static_cast<unsigned long>(d->latencies.size()),
+				static_cast<unsigned long>(percentile(d->latencies, 50)),
+				static_cast<unsigned long>(percentile(d->latencies, 90)),
+				static_cast<unsigned long>(percentile(d->latencies, 99)),
+				static_cast<unsigned long>(percentile(d->latencies, 100)),
+				d->overflows, d->unpaired, d->lost,
+				static_cast<unsigned long>(tick));
+
+			write_histogram(hp, d->name, "latency_ms", d->latencies, 1, INPUTDIAG_HIST_LATENCY);
+			write_histogram(hp, d->name, "interval_us", d->intervals, INPUTDIAG_INTERVAL_BUCKET, INPUTDIAG_HIST_INTERVAL);
+		}
+	}
+
+	if (fp) {
+		fclose(fp);
+	}
+	if (hp) {
+		fclose(hp);
+	}
+
+	for (int i = 0; i < st.ndevices; ++i) {
+		devices[i].dev->Unacquire();
+		devices[i].dev->Release();
+	}
+
+	if (!ok) {
+		snprintf(msg, sizeof(msg), "Cannot write %s or %s", reportFile, histFile);
+		MessageBoxA(0, msg, title, MB_ICONERROR|MB_OK);
+	}
+
+	return ok;
+}
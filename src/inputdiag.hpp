@@ -0,0 +1,56 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* -InputDiag: records the keyboard and game controller events DirectInput
+ * delivers until the dialog is closed, to tell whether laggy controls come
+ * from the input stack (e.g. DirectInput under Wine compared to Windows on
+ * the same cabinet).
+ *
+ * Every device is opened in buffered mode and polled about once per
+ * INPUTDIAG_POLL_MS. DirectInput stamps each event with the tick count at
+ * which it was queued; the difference to the tick count when the poll
+ * returns it is the event-to-observe latency. It's only as precise as the
+ * tick count, so the report includes the measured tick resolution.
+ *
+ * Events count as dropped when DirectInput reports a buffer overflow, or
+ * when a key or button changes to the state it already was in. */
+
+#ifndef INPUTDIAG_HPP
+#define INPUTDIAG_HPP
+
+#include "input.hpp"
+
+#define INPUTDIAG_POLL_MS         1
+#define INPUTDIAG_BUFFER          256  /* buffered events per device */
+#define INPUTDIAG_MAX_GAMEPADS    8
+#define INPUTDIAG_HIST_LATENCY    64   /* 1 ms buckets, the last one takes the rest */
+#define INPUTDIAG_HIST_INTERVAL   64   /* INPUTDIAG_INTERVAL_BUCKET buckets, the same */
+#define INPUTDIAG_INTERVAL_BUCKET 250  /* us */
+
+
+/* poll until the user closes the dialog, then write the per device report
+ * and the latency and polling interval histograms as tab-separated values */
+bool input_diagnostics(DirectInput *di, const char *reportFile, const char *histFile);
+
+#endif  /* INPUTDIAG_HPP */
@@ -0,0 +1,381 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#endif
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <wchar.h>
+#include <wctype.h>
+
+#include "instance.hpp"
+
+#define MAX_REQUEST_LENGTH  4096
+
+
+/* FNV-1a over the lower-cased id, so every install directory
+ * gets its own channel */
+static uint32_t hash_id(const wchar_t *id)
+{
+	uint32_t h = 2166136261u;
+
+	for ( ; *id; ++id) {
+		uint32_t c = static_cast<uint32_t>(towlower(*id));
+		for (int i = 0; i < 4; ++i) {
+			h ^= (c >> (i * 8)) & 0xFF;
+			h *= 16777619u;
+		}
+	}
+	return h;
+}
+
+void instance::split(const std::string &line, std::vector<std::string> &out)
+{
+	size_t pos = 0, tab;
+
+	out.clear();
+
+	while ((tab = line.find('\t', pos)) != std::string::npos) {
+		out.push_back(line.substr(pos, tab - pos));
+		pos = tab + 1;
+	}
+	out.push_back(line.substr(pos));
+}
+
+void instance::listenThread(void *p)
+{
+	reinterpret_cast<instance *>(p)->serve();
+}
+
+bool instance::listen(instanceHandler_t handler)
+{
+	if (!_primary || !handler) {
+		return false;
+	}
+#ifdef _WIN32
+	if (_pipe == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+#else
+	if (_sock == -1) {
+		return false;
+	}
+#endif
+	_handler = handler;
+	return _thread.start(listenThread, this);
+}
+
+#ifdef _WIN32
+
+instance::instance(const wchar_t *id)
+{
+	_snwprintf_s(_name, _countof(_name), _TRUNCATE, L"\\\\.\\pipe\\SonicLauncher-%08x", hash_id(id));
+}
+
+instance::~instance()
+{
+	if (_pipe == INVALID_HANDLE_VALUE) {
+		return;
+	}
+
+	/* wake up ConnectNamedPipe() */
+	_quit = true;
+	HANDLE h = CreateFileW(_name, GENERIC_READ|GENERIC_WRITE, 0, NULL, OPEN_EXISTING, 0, NULL);
+	if (h != INVALID_HANDLE_VALUE) {
+		CloseHandle(h);
+	}
+	_thread.join();
+
+	CloseHandle(_pipe);
+}
+
+bool instance::acquire()
+{
+	DWORD mode = PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT;
+#ifdef PIPE_REJECT_REMOTE_CLIENTS
+	mode |= PIPE_REJECT_REMOTE_CLIENTS;
+#endif
+
+	_pipe = CreateNamedPipeW(_name, PIPE_ACCESS_DUPLEX | FILE_FLAG_FIRST_PIPE_INSTANCE, mode,
+		1, MAX_REQUEST_LENGTH, MAX_REQUEST_LENGTH, 0, NULL);
+
+	if (_pipe == INVALID_HANDLE_VALUE) {
+		/* the first pipe instance belongs to somebody else */
+		_primary = (GetLastError() != ERROR_ACCESS_DENIED && GetLastError() != ERROR_PIPE_BUSY);
+	}
+	return _primary;
+}
+
+void instance::serve()
+{
+	char buf[MAX_REQUEST_LENGTH];
+
+	while (!_quit) {
+		std::string req, resp;
+		DWORD n = 0;
+
+		if (!ConnectNamedPipe(_pipe, NULL) && GetLastError() != ERROR_PIPE_CONNECTED) {
+			if (GetLastError() != ERROR_NO_DATA) {
+				break;
+			}
+			/* client has already closed its end */
+			DisconnectNamedPipe(_pipe);
+			continue;
+		}
+
+		if (_quit) {
+			DisconnectNamedPipe(_pipe);
+			break;
+		}
+
+		while (req.find('\n') == std::string::npos && req.size() < MAX_REQUEST_LENGTH) {
+			if (!ReadFile(_pipe, buf, sizeof(buf), &n, NULL) || n == 0) {
+				break;
+			}
+			req.append(buf, n);
+		}
+
+		size_t nl = req.find('\n');
+		if (nl != std::string::npos) {
+			req.erase(nl);
+			if (!req.empty() && req.back() == '\r') {
+				req.pop_back();
+			}
+			resp = _handler(req) + "\n";
+			WriteFile(_pipe, resp.c_str(), static_cast<DWORD>(resp.size()), &n, NULL);
+			FlushFileBuffers(_pipe);
+		}
+
+		DisconnectNamedPipe(_pipe);
+	}
+}
+
+bool instance::request(const std::string &req, std::string &resp, int timeoutMs)
+{
+	std::string line = req + "\n";
+	char buf[MAX_REQUEST_LENGTH];
+	DWORD n = 0;
+	HANDLE h;
+
+	resp.clear();
+
+	while ((h = CreateFileW(_name, GENERIC_READ|GENERIC_WRITE, 0, NULL, OPEN_EXISTING, 0, NULL)) == INVALID_HANDLE_VALUE) {
+		/* primary is busy with another client */
+		if (GetLastError() != ERROR_PIPE_BUSY || !WaitNamedPipeW(_name, timeoutMs)) {
+			return false;
+		}
+	}
+
+	if (!WriteFile(h, line.c_str(), static_cast<DWORD>(line.size()), &n, NULL)) {
+		CloseHandle(h);
+		return false;
+	}
+
+	while (ReadFile(h, buf, sizeof(buf), &n, NULL) && n > 0) {
+		resp.append(buf, n);
+	}
+	CloseHandle(h);
+
+	return !resp.empty();
+}
+
+#else  /* !_WIN32 */
+
+instance::instance(const wchar_t *id)
+{
+	const char *dir = getenv("XDG_RUNTIME_DIR");
+
+	if (!dir || !*dir) {
+		dir = "/tmp";
+	}
+	/* open_socket() refuses the empty name */
+	if (snprintf(_name, sizeof(_name), "%s/SonicLauncher-%08x.sock", dir, hash_id(id)) >= static_cast<int>(sizeof(_name))) {
+		_name[0] = 0;
+	}
+}
+
+instance::~instance()
+{
+	if (_sock == -1) {
+		return;
+	}
+
+	/* makes accept() return */
+	_quit = true;
+	shutdown(_sock, SHUT_RDWR);
+	_thread.join();
+
+	close(_sock);
+	unlink(_name);
+}
+
+static int open_socket(const char *path, struct sockaddr_un *addr)
+{
+	size_t len = strlen(path);
+
+	/* a truncated path would be somebody else's socket, or one that
+	 * never gets unlinked */
+	if (len == 0 || len >= sizeof(addr->sun_path)) {
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+
+	memset(addr, 0, sizeof(*addr));
+	addr->sun_family = AF_UNIX;
+	memcpy(addr->sun_path, path, len + 1);
+
+	return socket(AF_UNIX, SOCK_STREAM, 0);
+}
+
+bool instance::acquire()
+{
+	struct sockaddr_un addr;
+
+	if ((_sock = open_socket(_name, &addr)) == -1) {
+		return true;
+	}
+
+	if (bind(_sock, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) == -1) {
+		if (errno != EADDRINUSE) {
+			close(_sock);
+			_sock = -1;
+			return true;
+		}
+
+		/* somebody is listening -> we're the second instance */
+		int fd = open_socket(_name, &addr);
+		if (fd != -1 && connect(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) == 0) {
+			close(fd);
+			close(_sock);
+			_sock = -1;
+			_primary = false;
+			return false;
+		}
+		if (fd != -1) {
+			close(fd);
+		}
+
+		/* stale socket file left behind by a crashed instance */
+		unlink(_name);
+		if (bind(_sock, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) == -1) {
+			close(_sock);
+			_sock = -1;
+			return true;
+		}
+	}
+
+	if (::listen(_sock, 4) == -1) {
+		close(_sock);
+		_sock = -1;
+		unlink(_name);
+	}
+	return true;
+}
+
+void instance::serve()
+{
+	char buf[MAX_REQUEST_LENGTH];
+
+	while (!_quit) {
+		std::string req, resp;
+		ssize_t n;
+		int fd = accept(_sock, NULL, NULL);
+
+		if (fd == -1) {
+			if (errno == EINTR) {
+				continue;
+			}
+			break;
+		}
+
+		while (req.find('\n') == std::string::npos && req.size() < MAX_REQUEST_LENGTH) {
+			if ((n = read(fd, buf, sizeof(buf))) <= 0) {
+				break;
+			}
+			req.append(buf, static_cast<size_t>(n));
+		}
+
+		size_t nl = req.find('\n');
+		if (nl != std::string::npos) {
+			req.erase(nl);
+			if (!req.empty() && req.back() == '\r') {
+				req.pop_back();
+			}
+			resp = _handler(req) + "\n";
+			if (write(fd, resp.c_str(), resp.size()) < 0) {
+				/* client went away */
+			}
+		}
+
+		close(fd);
+	}
+}
+
+bool instance::request(const std::string &req, std::string &resp, int timeoutMs)
+{
+	std::string line = req + "\n";
+	char buf[MAX_REQUEST_LENGTH];
+	struct sockaddr_un addr;
+	struct timeval tv;
+	ssize_t n;
+	int fd;
+
+	resp.clear();
+
+	if ((fd = open_socket(_name, &addr)) == -1) {
+		return false;
+	}
+
+	tv.tv_sec = timeoutMs / 1000;
+	tv.tv_usec = (timeoutMs % 1000) * 1000;
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+	if (connect(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) == -1 ||
+		write(fd, line.c_str(), line.size()) != static_cast<ssize_t>(line.size()))
+	{
+		close(fd);
+		return false;
+	}
+
+	while ((n = read(fd, buf, sizeof(buf))) > 0) {
+		resp.append(buf, static_cast<size_t>(n));
+	}
+	close(fd);
+
+	return !resp.empty();
+}
+
+#endif  /* !_WIN32 */
@@ -0,0 +1,82 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef INSTANCE_HPP
+#define INSTANCE_HPP
+
+#include <string>
+#include <vector>
+
+#include "threads.hpp"
+
+/* Single-instance lock and local control channel. The first launcher
+ * process owns a named pipe (Windows) or a Unix domain socket and answers
+ * line based requests on it; any later process forwards its request and exits.
+ *
+ * Wire format: one request line, tab separated fields, terminated by '\n'.
+ * The response starts with "OK" or "ERR", optionally followed by a tab and
+ * a message; more lines may follow. The server closes the connection after
+ * each response. */
+
+/* runs on the listener thread */
+typedef std::string (*instanceHandler_t)(const std::string &request);
+
+class instance
+{
+private:
+#ifdef _WIN32
+	wchar_t _name[128];
+	HANDLE _pipe = INVALID_HANDLE_VALUE;
+#else
+	char _name[256];
+	int _sock = -1;
+#endif
+	bool _primary = true;
+	volatile bool _quit = false;
+	instanceHandler_t _handler = NULL;
+	thread _thread;
+
+	static void listenThread(void *p);
+	void serve();
+
+public:
+	instance(const wchar_t *id);
+	~instance();
+
+	/* returns false if another instance already owns the channel;
+	 * if the channel cannot be created at all we keep running as primary */
+	bool acquire();
+	bool primary() { return _primary; }
+
+	/* start answering requests */
+	bool listen(instanceHandler_t handler);
+
+	/* send a request to the primary instance */
+	bool request(const std::string &req, std::string &resp, int timeoutMs = 5000);
+
+	/* split a request line into its tab separated fields */
+	static void split(const std::string &line, std::vector<std::string> &out);
+};
+
+#endif  /* INSTANCE_HPP */
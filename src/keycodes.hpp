@@ -0,0 +1,374 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Key codes in the code spaces the launcher deals with: DirectInput scan
+ * codes (what the configuration stores and the game reads), Linux evdev
+ * codes, X11 keysyms and FLTK key codes (Fl::event_key()). keyCodes has
+ * one row per DirectInput key; the indexes for every column are built
+ * from it at compile time, so each lookup is a single array access.
+ *
+ * Keysyms and FLTK codes are those of the US layout with Num Lock on,
+ * i.e. they name the key's position, not the character it types. 0 means
+ * the key has no code in that space.
+ *
+ * The static_asserts at the end check every row and every index entry
+ * in both directions. */
+
+#ifndef KEYCODES_HPP
+#define KEYCODES_HPP
+
+#include <FL/Enumerations.H>
+
+#include <stddef.h>
+
+#include "dikeys.h"
+
+#define XF86(x)     (0x1008FF00 | (x))  /* XF86 multimedia keysyms */
+#define FL_XF86(x)  (0xEF00 | (x))      /* ... as FLTK reports them */
+
+
+typedef struct {
+	unsigned char dik;
+	unsigned short evdev;
+	unsigned int keysym;
+	unsigned int fltk;
+	const char *name;  /* English, like GetKeyNameText() on a US layout */
+} keyCode_t;
+
+static constexpr keyCode_t keyCodes[] =
+{
+	/* DirectInput       evdev  keysym       FLTK             name */
+	{ DIK_ESCAPE,           1, 0xFF1B,      FL_Escape,       "Esc" },
+	{ DIK_1,                2, '1',         '1',             "1" },
+	{ DIK_2,                3, '2',         '2',             "2" },
+	{ DIK_3,                4, '3',         '3',             "3" },
+	{ DIK_4,                5, '4',         '4',             "4" },
+	{ DIK_5,                6, '5',         '5',             "5" },
+	{ DIK_6,                7, '6',         '6',             "6" },
+	{ DIK_7,                8, '7',         '7',             "7" },
+	{ DIK_8,                9, '8',         '8',             "8" },
+	{ DIK_9,               10, '9',         '9',             "9" },
+	{ DIK_0,               11, '0',         '0',             "0" },
+	{ DIK_MINUS,           12, '-',         '-',             "-" },
+	{ DIK_EQUALS,          13, '=',         '=',             "=" },
+	{ DIK_BACK,            14, 0xFF08,      FL_BackSpace,    "Back" },
+	{ DIK_TAB,             15, 0xFF09,      FL_Tab,          "Tab" },
+	{ DIK_Q,               16, 'q',         'q',             "Q" },
+	{ DIK_W,               17, 'w',         'w',             "W" },
+	{ DIK_E,               18, 'e',         'e',             "E" },
+	{ DIK_R,               19, 'r',         'r',             "R" },
+	{ DIK_T,               20, 't',         't',             "T" },
+	{ DIK_Y,               21, 'y',         'y',             "Y" },
+	{ DIK_U,               22, 'u',         'u',             "U" },
+	{ DIK_I,               23, 'i',         'i',             "I" },
+	{ DIK_O,               24, 'o',         'o',             "O" },
+	{ DIK_P,               25, 'p',         'p',             "P" },
+	{ DIK_LBRACKET,        26, '[',         '[',             "[" },
+	{ DIK_RBRACKET,        27, ']',         ']',             "]" },
+	{ DIK_RETURN,          28, 0xFF0D,      FL_Enter,        "Enter" },
+	{ DIK_LCONTROL,        29, 0xFFE3,      FL_Control_L,    "CTRL" },
+	{ DIK_A,               30, 'a',         'a',             "A" },
+	{ DIK_S,               31, 's',         's',             "S" },
+	{ DIK_D,               32, 'd',         'd',             "D" },
+	{ DIK_F,               33, 'f',         'f',             "F" },
+	{ DIK_G,               34, 'g',         'g',             "G" },
+	{ DIK_H,               35, 'h',         'h',             "H" },
+	{ DIK_J,               36, 'j',         'j',             "J" },
+	{ DIK_K,               37, 'k',         'k',             "K" },
+	{ DIK_L,               38, 'l',         'l',             "L" },
+	{ DIK_SEMICOLON,       39, ';',         ';',             ";" },
+	{ DIK_APOSTROPHE,      40, '\'',        '\'',            "'" },
+	{ DIK_GRAVE,           41, '`',         '`',             "`" },
+	{ DIK_LSHIFT,          42, 0xFFE1,      FL_Shift_L,      "Shift" },
+	{ DIK_BACKSLASH,       43, '\\',        '\\',            "\\" },
+	{ DIK_Z,               44, 'z',         'z',             "Z" },
+	{ DIK_X,               45, 'x',         'x',             "X" },
+	{ DIK_C,               46, 'c',         'c',             "C" },
+	{ DIK_V,               47, 'v',         'v',             "V" },
+	{ DIK_B,               48, 'b',         'b',             "B" },
+	{ DIK_N,               49, 'n',         'n',             "N" },
+	{ DIK_M,               50, 'm',         'm',             "M" },
+	{ DIK_COMMA,           51, ',',         ',',             "," },
+	{ DIK_PERIOD,          52, '.',         '.',             "." },
+	{ DIK_SLASH,           53, '/',         '/',             "/" },
+	{ DIK_RSHIFT,          54, 0xFFE2,      FL_Shift_R,      "Right Shift" },
+	{ DIK_MULTIPLY,        55, 0xFFAA,      FL_KP + '*',     "Num *" },
+	{ DIK_LMENU,           56, 0xFFE9,      FL_Alt_L,        "Alt" },
+	{ DIK_SPACE,           57, ' ',         ' ',             "Space" },
+	{ DIK_CAPITAL,         58, 0xFFE5,      FL_Caps_Lock,    "Caps Lock" },
+	{ DIK_F1,              59, 0xFFBE,      FL_F + 1,        "F1" },
+	{ DIK_F2,              60, 0xFFBF,      FL_F + 2,        "F2" },
+	{ DIK_F3,              61, 0xFFC0,      FL_F + 3,        "F3" },
+	{ DIK_F4,              62, 0xFFC1,      FL_F + 4,        "F4" },
+	{ DIK_F5,              63, 0xFFC2,      FL_F + 5,        "F5" },
+	{ DIK_F6,              64, 0xFFC3,      FL_F + 6,        "F6" },
+	{ DIK_F7,              65, 0xFFC4,      FL_F + 7,        "F7" },
+	{ DIK_F8,              66, 0xFFC5,      FL_F + 8,        "F8" },
+	{ DIK_F9,              67, 0xFFC6,      FL_F + 9,        "F9" },
+	{ DIK_F10,             68, 0xFFC7,      FL_F + 10,       "F10" },
+	{ DIK_NUMLOCK,         69, 0xFF7F,      FL_Num_Lock,     "Num Lock" },
+	{ DIK_SCROLL,          70, 0xFF14,      FL_Scroll_Lock,  "Scroll Lock" },
+	{ DIK_NUMPAD7,         71, 0xFFB7,      FL_KP + '7',     "Num 7" },
+	{ DIK_NUMPAD8,         72, 0xFFB8,      FL_KP + '8',     "Num 8" },
+	{ DIK_NUMPAD9,         73, 0xFFB9,      FL_KP + '9',     "Num 9" },
+	{ DIK_SUBTRACT,        74, 0xFFAD,      FL_KP + '-',     "Num -" },
+	{ DIK_NUMPAD4,         75, 0xFFB4,      FL_KP + '4',     "Num 4" },
+	{ DIK_NUMPAD5,         76, 0xFFB5,      FL_KP + '5',     "Num 5" },
+	{ DIK_NUMPAD6,         77, 0xFFB6,      FL_KP + '6',     "Num 6" },
+	{ DIK_ADD,             78, 0xFFAB,      FL_KP + '+',     "Num +" },
+	{ DIK_NUMPAD1,         79, 0xFFB1,      FL_KP + '1',     "Num 1" },
+	{ DIK_NUMPAD2,         80, 0xFFB2,      FL_KP + '2',     "Num 2" },
+	{ DIK_NUMPAD3,         81, 0xFFB3,      FL_KP + '3',     "Num 3" },
+	{ DIK_NUMPAD0,         82, 0xFFB0,      FL_KP + '0',     "Num 0" },
+	{ DIK_DECIMAL,         83, 0xFFAE,      FL_KP + '.',     "Num ." },
+	{ DIK_OEM_102,         86, '<',         '<',             "OEM 102" },
+	{ DIK_F11,             87, 0xFFC8,      FL_F + 11,       "F11" },
+	{ DIK_F12,             88, 0xFFC9,      FL_F + 12,       "F12" },
+	{ DIK_F13,            183, 0xFFCA,      FL_F + 13,       "F13" },
+	{ DIK_F14,            184, 0xFFCB,      FL_F + 14,       "F14" },
+	{ DIK_F15,            185, 0xFFCC,      FL_F + 15,       "F15" },
+	{ DIK_KANA,            93, 0xFF27,      0xFF27,          "Kana" },
+	{ DIK_ABNT_C1,         89, 0,           0,               "ABNT C1" },
+	{ DIK_CONVERT,         92, 0xFF23,      0xFF23,          "Convert" },
+	{ DIK_NOCONVERT,       94, 0xFF22,      0xFF22,          "No Convert" },
+	{ DIK_YEN,            124, 0xA5,        0xA5,            "Yen" },
+	{ DIK_ABNT_C2,          0, 0,           0,               "ABNT C2" },
+	{ DIK_NUMPADEQUALS,   117, 0xFFBD,      FL_KP + '=',     "Num =" },
+	{ DIK_PREVTRACK,      165, XF86(0x16),  FL_Media_Prev,   "Previous Track" },
+	{ DIK_AT,               0, '@',         '@',             "@" },
+	{ DIK_COLON,            0, ':',         ':',             ":" },
+	{ DIK_UNDERLINE,        0, '_',         '_',             "_" },
+	{ DIK_KANJI,            0, 0xFF21,      0xFF21,          "Kanji" },
+	{ DIK_STOP,             0, 0,           0,               "Stop" },
+	{ DIK_AX,               0, 0,           0,               "AX" },
+	{ DIK_UNLABELED,        0, 0,           0,               "UNLABELED" },
+	{ DIK_NEXTTRACK,      163, XF86(0x17),  FL_Media_Next,   "Next Track" },
+	{ DIK_NUMPADENTER,     96, 0xFF8D,      FL_KP_Enter,     "Num Enter" },
+	{ DIK_RCONTROL,        97, 0xFFE4,      FL_Control_R,    "Right CTRL" },
+	{ DIK_MUTE,           113, XF86(0x12),  FL_Volume_Mute,  "Mute" },
+	{ DIK_CALCULATOR,     140, XF86(0x1D),  FL_XF86(0x1D),   "Calculator" },
+	{ DIK_PLAYPAUSE,      164, XF86(0x14),  FL_Media_Play,   "Play/Pause" },
+	{ DIK_MEDIASTOP,      166, XF86(0x15),  FL_Media_Stop,   "Media Stop" },
+	{ DIK_VOLUMEDOWN,     114, XF86(0x11),  FL_Volume_Down,  "Volume Down" },
+	{ DIK_VOLUMEUP,       115, XF86(0x13),  FL_Volume_Up,    "Volume Up" },
+	{ DIK_WEBHOME,        172, XF86(0x18),  FL_Home_Page,    "Web Home" },
+	{ DIK_NUMPADCOMMA,    121, 0xFFAC,      FL_KP + ',',     "Num ," },
+	{ DIK_DIVIDE,          98, 0xFFAF,      FL_KP + '/',     "Num /" },
+	{ DIK_SYSRQ,           99, 0xFF61,      FL_Print,        "SYSRQ" },
+	{ DIK_RMENU,          100, 0xFFEA,      FL_Alt_R,        "Right Alt" },
+	{ DIK_PAUSE,          119, 0xFF13,      FL_Pause,        "Pause" },
+	{ DIK_HOME,           102, 0xFF50,      FL_Home,         "Home" },
+	{ DIK_UP,             103, 0xFF52,      FL_Up,           "Up" },
+	{ DIK_PRIOR,          104, 0xFF55,      FL_Page_Up,      "Page Up" },
+	{ DIK_LEFT,           105, 0xFF51,      FL_Left,         "Left" },
+	{ DIK_RIGHT,          106, 0xFF53,      FL_Right,        "Right" },
+	{ DIK_END,            107, 0xFF57,      FL_End,          "End" },
+	{ DIK_DOWN,           108, 0xFF54,      FL_Down,         "Down" },
+	{ DIK_NEXT,           109, 0xFF56,      FL_Page_Down,    "Page Down" },
+	{ DIK_INSERT,         110, 0xFF63,      FL_Insert,       "Insert" },
+	{ DIK_DELETE,         111, 0xFFFF,      FL_Delete,       "Delete" },
+	{ DIK_LWIN,           125, 0xFFEB,      FL_Meta_L,       "Left Windows" },
+	{ DIK_RWIN,           126, 0xFFEC,      FL_Meta_R,       "Right Windows" },
+	{ DIK_APPS,           127, 0xFF67,      FL_Menu,         "Application" },
+	{ DIK_POWER,          116, XF86(0x2A),  FL_XF86(0x2A),   "Power" },
+	{ DIK_SLEEP,          142, XF86(0x2F),  FL_Sleep,        "Sleep" },
+	{ DIK_WAKE,           143, XF86(0x2B),  FL_XF86(0x2B),   "Wake" },
+	{ DIK_WEBSEARCH,      217, XF86(0x1B),  FL_Search,       "Web Search" },
+	{ DIK_WEBFAVORITES,   156, XF86(0x30),  FL_Favorites,    "Web Favorites" },
+	{ DIK_WEBREFRESH,     173, XF86(0x29),  FL_Refresh,      "Web Refresh" },
+	{ DIK_WEBSTOP,        128, XF86(0x28),  FL_Stop,         "Web Stop" },
+	{ DIK_WEBFORWARD,     159, XF86(0x27),  FL_Forward,      "Web Forward" },
+	{ DIK_WEBBACK,        158, XF86(0x26),  FL_Back,         "Web Back" },
+	{ DIK_MYCOMPUTER,     157, XF86(0x33),  FL_XF86(0x33),   "My Computer" },
+	{ DIK_MAIL,           155, XF86(0x19),  FL_Mail,         "Mail" },
+	{ DIK_MEDIASELECT,    226, XF86(0x32),  FL_XF86(0x32),   "Media Select" },
+};
+
+#define KEYCODES      (sizeof(keyCodes) / sizeof(*keyCodes))
+#define KEYCODE_NONE  0xFF
+
+static_assert(KEYCODES < KEYCODE_NONE, "keyCodes rows don't fit the indexes");
+
+/* the codes of each space are indexed in pages of 256 */
+static constexpr unsigned int dikPages[] = { 0x0000 };
+static constexpr unsigned int evdevPages[] = { 0x0000 };
+static constexpr unsigned int keysymPages[] = { 0x0000, 0xFF00, XF86(0) };
+static constexpr unsigned int fltkPages[] = { 0x0000, 0xFF00, FL_XF86(0) };
+
+enum {
+	KEYCOL_DIK,
+	KEYCOL_EVDEV,
+	KEYCOL_KEYSYM,
+	KEYCOL_FLTK
+};
+
+template<size_t PAGES>
+struct keyIndex_t {
+	unsigned char row[PAGES][256];
+};
+
+static constexpr unsigned int keycode_column(const keyCode_t &k, int col)
+{
+	return (col == KEYCOL_DIK) ? k.dik :
+		(col == KEYCOL_EVDEV) ? k.evdev :
+		(col == KEYCOL_KEYSYM) ? k.keysym : k.fltk;
+}
+
+/* page of code, or -1 if it isn't indexed */
+template<size_t PAGES>
+static constexpr int keycode_page(unsigned int code, const unsigned int (&pages)[PAGES])
+{
+	for (size_t i = 0; i < PAGES; ++i) {
+		if ((code & ~0xFFu) == pages[i]) {
+			return static_cast<int>(i);
+		}
+	}
+	return -1;
+}
+
+template<size_t PAGES>
+static constexpr keyIndex_t<PAGES> keycode_index(int col, const unsigned int (&pages)[PAGES])
+{
+	keyIndex_t<PAGES> idx = {};
+
+	for (size_t p = 0; p < PAGES; ++p) {
+		for (size_t i = 0; i < 256; ++i) {
+			idx.row[p][i] = KEYCODE_NONE;
+		}
+	}
+
+	for (size_t r = 0; r < KEYCODES; ++r) {
+		unsigned int code = keycode_column(keyCodes[r], col);
+		int p = keycode_page(code, pages);
+
+		if (code != 0 && p >= 0) {
+			idx.row[p][code & 0xFF] = static_cast<unsigned char>(r);
+		}
+	}
+
+	return idx;
+}
+
+static constexpr keyIndex_t<1> dikIndex = keycode_index(KEYCOL_DIK, dikPages);
+static constexpr keyIndex_t<1> evdevIndex = keycode_index(KEYCOL_EVDEV, evdevPages);
+static constexpr keyIndex_t<3> keysymIndex = keycode_index(KEYCOL_KEYSYM, keysymPages);
+static constexpr keyIndex_t<3> fltkIndex = keycode_index(KEYCOL_FLTK, fltkPages);
+
+template<size_t PAGES>
+static constexpr const keyCode_t *keycode_lookup(const keyIndex_t<PAGES> &idx,
+	const unsigned int (&pages)[PAGES], unsigned int code)
+{
+	int p = keycode_page(code, pages);
+
+	if (code == 0 || p < 0 || idx.row[p][code & 0xFF] == KEYCODE_NONE) {
+		return NULL;
+	}
+	return &keyCodes[idx.row[p][code & 0xFF]];
+}
+
+/* NULL for unknown codes */
+static constexpr const keyCode_t *keycode_from_dik(unsigned int dik) {
+	return keycode_lookup(dikIndex, dikPages, dik);
+}
+
+static constexpr const keyCode_t *keycode_from_evdev(unsigned int evdev) {
+	return keycode_lookup(evdevIndex, evdevPages, evdev);
+}
+
+static constexpr const keyCode_t *keycode_from_keysym(unsigned int keysym) {
+	return keycode_lookup(keysymIndex, keysymPages, keysym);
+}
+
+/* FLTK reports letters in lower case */
+static constexpr const keyCode_t *keycode_from_fltk(unsigned int key) {
+	return keycode_lookup(fltkIndex, fltkPages, key);
+}
+
+
+/* every code of every row is indexed and leads back to its row, so no
+ * two rows share a code */
+template<size_t PAGES>
+static constexpr bool keycode_rows_indexed(const keyIndex_t<PAGES> &idx,
+	const unsigned int (&pages)[PAGES], int col)
+{
+	for (size_t r = 0; r < KEYCODES; ++r) {
+		unsigned int code = keycode_column(keyCodes[r], col);
+
+		if (code != 0 && keycode_lookup(idx, pages, code) != &keyCodes[r]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/* every index entry names a row with that code; together with the check
+ * above this covers all codes of the indexed pages */
+template<size_t PAGES>
+static constexpr bool keycode_index_exact(const keyIndex_t<PAGES> &idx,
+	const unsigned int (&pages)[PAGES], int col)
+{
+	for (size_t p = 0; p < PAGES; ++p) {
+		for (unsigned int i = 0; i < 256; ++i) {
+			const keyCode_t *k = keycode_lookup(idx, pages, pages[p] | i);
+
+			if (k && keycode_column(*k, col) != (pages[p] | i)) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+/* dik -> x -> dik for every DirectInput key with a code in x */
+static constexpr bool keycode_round_trips(void)
+{
+	for (unsigned int dik = 0; dik < 256; ++dik) {
+		const keyCode_t *k = keycode_from_dik(dik);
+
+		if (!k) {
+			continue;
+		}
+		if ((k->evdev && keycode_from_evdev(k->evdev)->dik != dik) ||
+			(k->keysym && keycode_from_keysym(k->keysym)->dik != dik) ||
+			(k->fltk && keycode_from_fltk(k->fltk)->dik != dik) ||
+			!k->name || !k->name[0])
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+static_assert(keycode_rows_indexed(dikIndex, dikPages, KEYCOL_DIK), "DirectInput code missing or used twice");
+static_assert(keycode_rows_indexed(evdevIndex, evdevPages, KEYCOL_EVDEV), "evdev code out of range or used twice");
+static_assert(keycode_rows_indexed(keysymIndex, keysymPages, KEYCOL_KEYSYM), "keysym not in a page or used twice");
+static_assert(keycode_rows_indexed(fltkIndex, fltkPages, KEYCOL_FLTK), "FLTK code not in a page or used twice");
+static_assert(keycode_index_exact(dikIndex, dikPages, KEYCOL_DIK), "wrong DirectInput index entry");
+static_assert(keycode_index_exact(evdevIndex, evdevPages, KEYCOL_EVDEV), "wrong evdev index entry");
+static_assert(keycode_index_exact(keysymIndex, keysymPages, KEYCOL_KEYSYM), "wrong keysym index entry");
+static_assert(keycode_index_exact(fltkIndex, fltkPages, KEYCOL_FLTK), "wrong FLTK index entry");
+static_assert(keycode_round_trips(), "key codes don't round-trip");
+static_assert(keycode_from_dik(0) == NULL && keycode_from_fltk('A') == NULL, "not a key");
+
+#endif  /* KEYCODES_HPP */
@@ -1,35 +1,228 @@
-const char *ui_Settings[] = { "Settings", "Einstellungen", "Ajustes", "Param" "\xC3\xA8" "tres", "Impostazioni", "\xE8\xA8\xAD\xE5\xAE\x9A" };
-//const char *ui_GraphicsSettings[] = { "Graphics settings", "Grafik-Einstellungen", "Configuraci" "\xC3\xB3" "n gr" "\xC3\xA1" "fica", "Param" "\xC3\xA8" "tres graphiques", "Impostazioni grafiche", "\xE3\x82\xB0\xE3\x83\xA9\xE3\x83\x95\xE3\x82\xA3\xE3\x83\x83\xE3\x82\xAF\xE3\x81\xAE\xE8\xA8\xAD\xE5\xAE\x9A" };
-const char *ui_GraphicsDevice[] = { "Graphics device", "Grafikkarte", "Dispositivo grafico", "P" "\xC3\xA9" "riph" "\xC3\xA9" "rique graphique", "Dispositivo grafico", "\xE3\x82\xB0\xE3\x83\xA9\xE3\x83\x95\xE3\x82\xA3\xE3\x83\x83\xE3\x82\xAF\xE3\x82\xB9\xE3\x83\x87\xE3\x83\x90\xE3\x82\xA4\xE3\x82\xB9" };
-const char *ui_Resolution[] = { "Resolution", "Aufl" "\xC3\xB6" "sung", "Resoluci" "\xC3\xB3" "n", "R" "\xC3\xA9" "solution", "Risoluzione", "\xE8\xA7\xA3\xE5\x83\x8F\xE5\xBA\xA6" };
-const char *ui_Fullscreen[] = { "Fullscreen", "Vollbild", "Pantalla completa", "Plein " "\xC3\xA9" "cran", "Schermo intero", "\xE3\x83\x95\xE3\x83\xAB\xE3\x82\xB9\xE3\x82\xAF\xE3\x83\xAA\xE3\x83\xBC\xE3\x83\xB3" };
-//const char *ui_AudioSettings[] = { "Audio settings", "Audio-Einstellungen", "Ajustes de audio", "Param" "\xC3\xA8" "tres audio", "Impostazioni audio", "\xE3\x82\xAA\xE3\x83\xBC\xE3\x83\x87\xE3\x82\xA3\xE3\x82\xAA\xE8\xA8\xAD\xE5\xAE\x9A" };
-//const char *ui_OutputDevice[] = { "Output device", "Ausgabeger" "\xC3\xA4" "t", "Dispositivo de salida", "P" "\xC3\xA9" "riph" "\xC3\xA9" "rique de sortie", "Dispositivo di uscita", "\xE5\x87\xBA\xE5\x8A\x9B\xE3\x83\x87\xE3\x83\x90\xE3\x82\xA4\xE3\x82\xB9" };
-const char *ui_Language[] = { "Language", "Sprache", "Idioma", "Langue", "Lingua", "\xE8\xA8\x80\xE8\xAA\x9E" };
-const char *ui_ControllerSelection[] = { "Controller selection", "Wahl der Steuerung", "Selecci" "\xC3\xB3" "n de controlador", "Choix de la manette", "Selezione controller", "\xE3\x82\xB3\xE3\x83\xB3\xE3\x83\x88\xE3\x83\xAD\xE3\x83\xBC\xE3\x83\xA9\xE3\x81\xAE\xE9\x81\xB8\xE6\x8A\x9E" };
-//const char *ui_AdditionalController[] = { "Additional controller", "Zus" "\xC3\xA4" "tzliche Controller", "Controlador adicional", "Manette suppl" "\xC3\xA9" "mentaire", "Controller aggiuntivo", "\xE8\xBF\xBD\xE5\x8A\xA0\xE3\x81\xAE\xE3\x82\xB3\xE3\x83\xB3\xE3\x83\x88\xE3\x83\xAD\xE3\x83\xBC\xE3\x83\xA9" };
-//const char *ui_ControllerNumber[] = { "Controller number", "Controller-Nummer", "Controlador n" "\xC3\xBA" "mero", "Num" "\xC3\xA9" "ro de manette", "Numero di controller", "\xE3\x82\xB3\xE3\x83\xB3\xE3\x83\x88\xE3\x83\xAD\xE3\x83\xBC\xE3\x83\xA9\xE7\x95\xAA\xE5\x8F\xB7" };
-//const char *ui_Layout[] = { "Layout", "Layout", "Interfaz", "Interface", "Disposizione", "\xE3\x81\xAE\xE3\x83\xAC\xE3\x82\xA4\xE3\x82\xA2\xE3\x82\xA6\xE3\x83\x88" };
-//const char *ui_ConfigurationLayout[] = { "Configuration Layout", "Steuerungskonfiguration", "Configuraci" "\xC3\xB3" "n de botones", "Configuration", "Configurazione", "\xE3\x83\xAC\xE3\x82\xA4\xE3\x82\xA2\xE3\x82\xA6\xE3\x83\x88\xE3\x81\xAE\xE8\xA8\xAD\xE5\xAE\x9A" };
-const char *ui_Movement[] = { "Movement", "Bewegung", "Movimiento", "D" "\xC3\xA9" "placement", "Movimento", "\xE7\xA7\xBB\xE5\x8B\x95" };
-const char *ui_Action[] = { "Action", "Aktion", "Acci" "\xC3\xB3" "n", "Action", "Azione", "\xE3\x82\xA2\xE3\x82\xAF\xE3\x82\xB7\xE3\x83\xA7\xE3\x83\xB3" };
-const char *ui_Up[] = { "Up", "Nach oben", "Arriba", "Haut", "Su", "\xE4\xB8\x8A" };
-const char *ui_Down[] = { "Down", "Nach unten", "Abajo", "Bas", "Gi" "\xC3\xB9", "\xE4\xB8\x8B" };
-const char *ui_Left[] = { "Left", "Links", "Izquierda", "Gauche", "Sinistra", "\xE5\xB7\xA6" };
-const char *ui_Right[] = { "Right", "Rechts", "Derecha", "Droite", "Destra", "\xE5\x8F\xB3" };
-const char *ui_Jump[] = { "Jump", "Sprung", "Saltar", "Sauter", "Saltare", "\xE3\x82\xB8\xE3\x83\xA3\xE3\x83\xB3\xE3\x83\x97" };
-const char *ui_Start[] = { "Start", "Start", "Iniciar", "D" "\xC3\xA9" "marrer", "Inizio", "\xE3\x82\xB9\xE3\x82\xBF\xE3\x83\xBC\xE3\x83\x88" };
-const char *ui_SaveSettings[] = { "Save settings and launch Sonic 4", "Einstellungen speichern und Sonic 4 starten", "Guardar la configuraci" "\xC3\xB3" "n e iniciar Sonic 4", "Sauvegarder les r" "\xC3\xA9" "glages et d" "\xC3\xA9" "marrer Sonic 4", "Salva le impostazioni e avvia Sonic 4", "\xE8\xA8\xAD\xE5\xAE\x9A\xE3\x82\x92\xE4\xBF\x9D\xE5\xAD\x98\xE3\x81\x97\xE3\x81\xA6\xE3\x82\xB2\xE3\x83\xBC\xE3\x83\xA0\xE3\x82\x92\xE3\x83\x97\xE3\x83\xAC\xE3\x82\xA4" };
-const char *ui_Player[] = { "Player", "Spieler", "Jugador", "Joueur", "Giocatore", "\xE3\x83\x97\xE3\x83\xAC\xE3\x82\xA4\xE3\x83\xA4\xE3\x83\xBC" };
-const char *ui_Select[] = { "Select", "W" "\xC3\xA4" "hlen", "Seleccionar", "S" "\xC3\xA9" "lectionnez", "Selezionare", "\xE6\xB1\xBA\xE5\xAE\x9A" };
-const char *ui_Back[] = { "Back", "Zur" "\xC3\xBC" "ck", "Volver", "Retour", "Indietro", "\xE6\x88\xBB\xE3\x82\x8B" };
-const char *ui_Keyboard[] = { "Keyboard", "Tastatur", "Teclado", "Clavier", "Tastiera", "\xE3\x82\xAD\xE3\x83\xBC\xE3\x83\x9C\xE3\x83\xBC\xE3\x83\x89" };
-const char *ui_Gamepad[] = { "Gamepad", "Gamepad", "Gamepad", "Gamepad", "Gamepad", "\xE3\x82\xB2\xE3\x83\xBC\xE3\x83\xA0\xE3\x83\x91\xE3\x83\x83\xE3\x83\x89" };
-const char *ui_ScoreAttack[] = { "Score Attack / Time Attack", "Punktangriff / Zeitangriff", "Por puntos / Contrarreloj", "Chasse aux points / Contre la montre", "Attacco al tempo / Attacco al punteggio", "\xE3\x82\xB9\xE3\x82\xB3\xE3\x82\xA2\xE3\x82\xA2\xE3\x82\xBF\xE3\x83\x83\xE3\x82\xAF" " / " "\xE3\x82\xBF\xE3\x82\xA4\xE3\x83\xA0\xE3\x82\xA2\xE3\x82\xBF\xE3\x83\x83\xE3\x82\xAF" };
-const char *ui_Press[] = { "Press!", "Dr" "\xC3\xBC" "cken!", "\xC2\xA1" "Pulsa!", "Presse!", "Premi!", "\xE3\x82\x92\xE6\x8A\xBC\xE3\x81\x97" "!" };
-const char *ui_ResetToDefault[] = { "Reset to Default Settings", "Auf Standard zur" "\xC3\xBC" "cksetzen", "Volver a configuraci" "\xC3\xB3" "n inicial", "R" "\xC3\xA9" "initialiser", "Ripristina predefinito", "\xE3\x83\x87\xE3\x83\x95\xE3\x82\xA9\xE3\x83\xAB\xE3\x83\x88\xE3\x81\xAB\xE3\x83\xAA\xE3\x82\xBB\xE3\x83\x83\xE3\x83\x88" };
-//const char *ui_Configuration[] = { "Configuration", "Konfiguration", "Configuraci" "\xC3\xB3" "n", "Configuration", "Configurazione", "\xE3\x82\xB3\xE3\x83\xB3\xE3\x83\x95\xE3\x82\xA3\xE3\x82\xAE\xE3\x83\xA5\xE3\x83\xAC\xE3\x83\xBC\xE3\x82\xB7\xE3\x83\xA7\xE3\x83\xB3" };
-//const char *ui_ConfigurationSaved[] = { "Configuration saved.", "Einstellungen gespeichert.", "Configuraci" "\xC3\xB3" "n guardada.", "Configuration sauvegard" "\xC3\xA9" "e.", "Configurazione salvata.", "\xE8\xA8\xAD\xE5\xAE\x9A\xE3\x82\x92\xE4\xBF\x9D\xE5\xAD\x98\xE3\x81\x97\xE3\x81\xBE\xE3\x81\x97\xE3\x81\x9F" "." };
-const char *ui_SuperSonic[] = { "Super Sonic", "Super Sonic", "Super Sonic", "Super Sonic", "Super Sonic", "\xE3\x82\xB9\xE3\x83\xBC\xE3\x83\x91\xE3\x83\xBC\xE3\x82\xBD\xE3\x83\x8B\xE3\x83\x83\xE3\x82\xAF" };
-const char *ui_Vibrate[] = { "Vibrate", "Vibration", "Vibraci" "\xC3\xB3" "n", "Vibration", "Vibrazione", "\xE3\x83\x90\xE3\x82\xA4\xE3\x83\x96" };
-//const char *ui_Leaderboards[] = { "Leaderboards", "Bestenlisten", "Marcadores", "Classements", "Classifiche", "\xE3\x83\xAA\xE3\x83\xBC\xE3\x83\x80\xE3\x83\xBC\xE3\x83\x9C\xE3\x83\xBC\xE3\x83\x89" };
+/* generated from lang.txt by format_lang.c, don't edit */
+
+#ifndef LANG_H
+#define LANG_H
+
+#define UI_LANGUAGES  6
+#define UI_ROWS       35  /* rows in lang.txt, including unused ones */
+
+enum {
+  UI_SETTINGS,
+  UI_GRAPHICS_DEVICE,
+  UI_RESOLUTION,
+  UI_FULLSCREEN,
+  UI_LANGUAGE,
+  UI_CONTROLLER_SELECTION,
+  UI_MOVEMENT,
+  UI_ACTION,
+  UI_UP,
+  UI_DOWN,
+  UI_LEFT,
+  UI_RIGHT,
+  UI_JUMP,
+  UI_START,
+  UI_SAVE_SETTINGS,
+  UI_PLAYER,
+  UI_SELECT,
+  UI_BACK,
+  UI_KEYBOARD,
+  UI_GAMEPAD,
+  UI_SCORE_ATTACK,
+  UI_PRESS,
+  UI_RESET_TO_DEFAULT,
+  UI_SUPER_SONIC,
+  UI_VIBRATE,
+  UI_STRINGS
+};
+
+/* all strings, NUL separated */
+static const char ui_pool[] =
+  "Settings\0"
+  "Einstellungen\0"
+  "Ajustes\0"
+  "Param\xC3\xA8" "tres\0"
+  "Impostazioni\0"
+  "\xE8\xA8\xAD\xE5\xAE\x9A\0"
+  "Graphics device\0"
+  "Grafikkarte\0"
+  "Dispositivo grafico\0"
+  "P\xC3\xA9" "riph\xC3\xA9" "rique graphique\0"
+  "Dispositivo grafico\0"
+  "\xE3\x82\xB0\xE3\x83\xA9\xE3\x83\x95\xE3\x82\xA3\xE3\x83\x83\xE3\x82\xAF\xE3\x82\xB9\xE3\x83\x87\xE3\x83\x90\xE3\x82\xA4\xE3\x82\xB9\0"
+  "Resolution\0"
+  "Aufl\xC3\xB6" "sung\0"
+  "Resoluci\xC3\xB3" "n\0"
+  "R\xC3\xA9" "solution\0"
+  "Risoluzione\0"
+  "\xE8\xA7\xA3\xE5\x83\x8F\xE5\xBA\xA6\0"
+  "Fullscreen\0"
+  "Vollbild\0"
+  "Pantalla completa\0"
+  "Plein \xC3\xA9" "cran\0"
+  "Schermo intero\0"
+  "\xE3\x83\x95\xE3\x83\xAB\xE3\x82\xB9\xE3\x82\xAF\xE3\x83\xAA\xE3\x83\xBC\xE3\x83\xB3\0"
+  "Language\0"
+  "Sprache\0"
+  "Idioma\0"
+  "Langue\0"
+  "Lingua\0"
+  "\xE8\xA8\x80\xE8\xAA\x9E\0"
+  "Controller selection\0"
+  "Wahl der Steuerung\0"
+  "Selecci\xC3\xB3" "n de controlador\0"
+  "Choix de la manette\0"
+  "Selezione controller\0"
+  "\xE3\x82\xB3\xE3\x83\xB3\xE3\x83\x88\xE3\x83\xAD\xE3\x83\xBC\xE3\x83\xA9\xE3\x81\xAE\xE9\x81\xB8\xE6\x8A\x9E\0"
+  "Movement\0"
+  "Bewegung\0"
+  "Movimiento\0"
+  "D\xC3\xA9" "placement\0"
+  "Movimento\0"
+  "\xE7\xA7\xBB\xE5\x8B\x95\0"
+  "Action\0"
+  "Aktion\0"
+  "Acci\xC3\xB3" "n\0"
+  "Action\0"
+  "Azione\0"
+  "\xE3\x82\xA2\xE3\x82\xAF\xE3\x82\xB7\xE3\x83\xA7\xE3\x83\xB3\0"
+  "Up\0"
+  "Nach oben\0"
+  "Arriba\0"
+  "Haut\0"
+  "Su\0"
+  "\xE4\xB8\x8A\0"
+  "Down\0"
+  "Nach unten\0"
+  "Abajo\0"
+  "Bas\0"
+  "Gi\xC3\xB9\0"
+  "\xE4\xB8\x8B\0"
+  "Left\0"
+  "Links\0"
+  "Izquierda\0"
+  "Gauche\0"
+  "Sinistra\0"
+  "\xE5\xB7\xA6\0"
+  "Right\0"
+  "Rechts\0"
+  "Derecha\0"
+  "Droite\0"
+  "Destra\0"
+  "\xE5\x8F\xB3\0"
+  "Jump\0"
+  "Sprung\0"
+  "Saltar\0"
+  "Sauter\0"
+  "Saltare\0"
+  "\xE3\x82\xB8\xE3\x83\xA3\xE3\x83\xB3\xE3\x83\x97\0"
+  "Start\0"
+  "Start\0"
+  "Iniciar\0"
+  "D\xC3\xA9" "marrer\0"
+  "Inizio\0"
+  "\xE3\x82\xB9\xE3\x82\xBF\xE3\x83\xBC\xE3\x83\x88\0"
+  "Save settings and launch Sonic 4\0"
+  "Einstellungen speichern und Sonic 4 starten\0"
+  "Guardar la configuraci\xC3\xB3" "n e iniciar Sonic 4\0"
+  "Sauvegarder les r\xC3\xA9" "glages et d\xC3\xA9" "marrer Sonic 4\0"
+  "Salva le impostazioni e avvia Sonic 4\0"
+  "\xE8\xA8\xAD\xE5\xAE\x9A\xE3\x82\x92\xE4\xBF\x9D\xE5\xAD\x98\xE3\x81\x97\xE3\x81\xA6\xE3\x82\xB2\xE3\x83\xBC\xE3\x83\xA0\xE3\x82\x92\xE3\x83\x97\xE3\x83\xAC\xE3\x82\xA4\0"
+  "Player\0"
+  "Spieler\0"
+  "Jugador\0"
+  "Joueur\0"
+  "Giocatore\0"
+  "\xE3\x83\x97\xE3\x83\xAC\xE3\x82\xA4\xE3\x83\xA4\xE3\x83\xBC\0"
+  "Select\0"
+  "W\xC3\xA4" "hlen\0"
+  "Seleccionar\0"
+  "S\xC3\xA9" "lectionnez\0"
+  "Selezionare\0"
+  "\xE6\xB1\xBA\xE5\xAE\x9A\0"
+  "Back\0"
+  "Zur\xC3\xBC" "ck\0"
+  "Volver\0"
+  "Retour\0"
+  "Indietro\0"
+  "\xE6\x88\xBB\xE3\x82\x8B\0"
+  "Keyboard\0"
+  "Tastatur\0"
+  "Teclado\0"
+  "Clavier\0"
+  "Tastiera\0"
+  "\xE3\x82\xAD\xE3\x83\xBC\xE3\x83\x9C\xE3\x83\xBC\xE3\x83\x89\0"
+  "Gamepad\0"
+  "Gamepad\0"
+  "Gamepad\0"
+  "Gamepad\0"
+  "Gamepad\0"
+  "\xE3\x82\xB2\xE3\x83\xBC\xE3\x83\xA0\xE3\x83\x91\xE3\x83\x83\xE3\x83\x89\0"
+  "Score Attack / Time Attack\0"
+  "Punktangriff / Zeitangriff\0"
+  "Por puntos / Contrarreloj\0"
+  "Chasse aux points / Contre la montre\0"
+  "Attacco al tempo / Attacco al punteggio\0"
+  "\xE3\x82\xB9\xE3\x82\xB3\xE3\x82\xA2\xE3\x82\xA2\xE3\x82\xBF\xE3\x83\x83\xE3\x82\xAF" " / \xE3\x82\xBF\xE3\x82\xA4\xE3\x83\xA0\xE3\x82\xA2\xE3\x82\xBF\xE3\x83\x83\xE3\x82\xAF\0"
+  "Press!\0"
+  "Dr\xC3\xBC" "cken!\0"
+  "\xC2\xA1" "Pulsa!\0"
+  "Presse!\0"
+  "Premi!\0"
+  "\xE3\x82\x92\xE6\x8A\xBC\xE3\x81\x97" "!\0"
+  "Reset to Default Settings\0"
+  "Auf Standard zur\xC3\xBC" "cksetzen\0"
+  "Volver a configuraci\xC3\xB3" "n inicial\0"
+  "R\xC3\xA9" "initialiser\0"
+  "Ripristina predefinito\0"
+  "\xE3\x83\x87\xE3\x83\x95\xE3\x82\xA9\xE3\x83\xAB\xE3\x83\x88\xE3\x81\xAB\xE3\x83\xAA\xE3\x82\xBB\xE3\x83\x83\xE3\x83\x88\0"
+  "Super Sonic\0"
+  "Super Sonic\0"
+  "Super Sonic\0"
+  "Super Sonic\0"
+  "Super Sonic\0"
+  "\xE3\x82\xB9\xE3\x83\xBC\xE3\x83\x91\xE3\x83\xBC\xE3\x82\xBD\xE3\x83\x8B\xE3\x83\x83\xE3\x82\xAF\0"
+  "Vibrate\0"
+  "Vibration\0"
+  "Vibraci\xC3\xB3" "n\0"
+  "Vibration\0"
+  "Vibrazione\0"
+  "\xE3\x83\x90\xE3\x82\xA4\xE3\x83\x96\0";
+
+/* offsets into ui_pool by string ID and language */
+static constexpr unsigned short ui_offsets[UI_STRINGS][UI_LANGUAGES] = {
+  { 0, 9, 23, 31, 43, 56 },  /* UI_SETTINGS */
+  { 63, 79, 91, 111, 136, 156 },  /* UI_GRAPHICS_DEVICE */
+  { 190, 201, 212, 224, 236, 248 },  /* UI_RESOLUTION */
+  { 258, 269, 278, 296, 309, 324 },  /* UI_FULLSCREEN */
+  { 346, 355, 363, 370, 377, 384 },  /* UI_LANGUAGE */
+  { 391, 412, 431, 457, 477, 498 },  /* UI_CONTROLLER_SELECTION */
+  { 526, 535, 544, 555, 568, 578 },  /* UI_MOVEMENT */
+  { 585, 592, 599, 607, 614, 621 },  /* UI_ACTION */
+  { 637, 640, 650, 657, 662, 665 },  /* UI_UP */
+  { 669, 674, 685, 691, 695, 700 },  /* UI_DOWN */
+  { 704, 709, 715, 725, 732, 741 },  /* UI_LEFT */
+  { 745, 751, 758, 766, 773, 780 },  /* UI_RIGHT */
+  { 784, 789, 796, 803, 810, 818 },  /* UI_JUMP */
+  { 831, 837, 843, 851, 861, 868 },  /* UI_START */
+  { 881, 914, 958, 1002, 1049, 1087 },  /* UI_SAVE_SETTINGS */
+  { 1130, 1137, 1145, 1153, 1160, 1170 },  /* UI_PLAYER */
+  { 1186, 1193, 1201, 1213, 1227, 1239 },  /* UI_SELECT */
+  { 1246, 1251, 1259, 1266, 1273, 1282 },  /* UI_BACK */
+  { 1289, 1298, 1307, 1315, 1323, 1332 },  /* UI_KEYBOARD */
+  { 1348, 1356, 1364, 1372, 1380, 1388 },  /* UI_GAMEPAD */
+  { 1407, 1434, 1461, 1487, 1524, 1564 },  /* UI_SCORE_ATTACK */
+  { 1610, 1617, 1627, 1636, 1644, 1651 },  /* UI_PRESS */
+  { 1662, 1688, 1715, 1747, 1762, 1785 },  /* UI_RESET_TO_DEFAULT */
+  { 1816, 1828, 1840, 1852, 1864, 1876 },  /* UI_SUPER_SONIC */
+  { 1901, 1909, 1919, 1930, 1940, 1951 },  /* UI_VIBRATE */
+};
+
+/* row in lang.txt by string ID */
+static constexpr unsigned char ui_rows[UI_STRINGS] = { 0, 2, 3, 4, 7, 8, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 32, 33 };
+
+static inline const char *ui_str(int id, unsigned int lang)
+{
+  return ui_pool + ui_offsets[id][lang];
+}
+
+#endif  /* LANG_H */
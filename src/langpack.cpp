@@ -0,0 +1,262 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <errno.h>
+#include <limits.h>
+#endif
+
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "langpack.hpp"
+#include "trace.hpp"
+
+#define PACK_PREFIX  "lang-"
+#define PACK_SUFFIX  ".txt"
+
+
+static FILE *open_file(const wchar_t *path, bool write)
+{
+	FILE *fp = NULL;
+#ifdef _WIN32
+	if (_wfopen_s(&fp, path, write ? L"wb" : L"rb") != 0) {
+		return NULL;
+	}
+#else
+	char mbs[PATH_MAX];
+
+	if (wcstombs(mbs, path, sizeof(mbs)) == static_cast<size_t>(-1)) {
+		return NULL;
+	}
+	fp = fopen(mbs, write ? "wb" : "rb");
+#endif
+	return fp;
+}
+
+size_t langPacks::discover(const wchar_t *dir)
+{
+	TRACE_SCOPE("langPacks::discover");
+
+	const size_t prefix = sizeof(PACK_PREFIX) - 1;
+	const size_t suffix = sizeof(PACK_SUFFIX) - 1;
+
+	select(-1, 0);
+	_packs.clear();
+
+#ifdef _WIN32
+	std::wstring path = dir;
+	WIN32_FIND_DATAW fd;
+	HANDLE h;
+	char name[MAX_PATH * 3];
+
+	h = FindFirstFileExW((path + L"\\" PACK_PREFIX "*" PACK_SUFFIX).c_str(), FindExInfoBasic, &fd,
+		FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH);
+	if (h == INVALID_HANDLE_VALUE) {
+		return 0;
+	}
+
+	do {
+		size_t len = wcslen(fd.cFileName);
+
+		if ((fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) || len <= prefix + suffix) {
+			continue;
+		}
+
+		/* "lang-<name>.txt" */
+		int n = WideCharToMultiByte(CP_UTF8, 0, fd.cFileName + prefix, static_cast<int>(len - prefix - suffix),
+			name, sizeof(name) - 1, NULL, NULL);
+		if (n <= 0) {
+			continue;
+		}
+		name[n] = 0;
+
+		_packs.push_back({ path + L"\\" + fd.cFileName, name });
+	} while (FindNextFileW(h, &fd));
+
+	FindClose(h);
+#else
+	char mbs[PATH_MAX];
+	wchar_t wcs[PATH_MAX];
+	struct dirent *e;
+	DIR *d;
+
+	if (wcstombs(mbs, dir, sizeof(mbs)) == static_cast<size_t>(-1) || (d = opendir(mbs)) == NULL) {
+		return 0;
+	}
+
+	while ((e = readdir(d)) != NULL) {
+		size_t len = strlen(e->d_name);
+		std::string file = std::string(mbs) + "/" + e->d_name;
+
+		if (len <= prefix + suffix || strncmp(e->d_name, PACK_PREFIX, prefix) != 0 ||
+			strcmp(e->d_name + len - suffix, PACK_SUFFIX) != 0 ||
+			mbstowcs(wcs, file.c_str(), PATH_MAX) == static_cast<size_t>(-1))
+		{
+			continue;
+		}
+
+		_packs.push_back({ wcs, std::string(e->d_name + prefix, len - prefix - suffix) });
+	}
+
+	closedir(d);
+#endif
+
+	/* stable menu order */
+	std::sort(_packs.begin(), _packs.end(), [] (const pack_t &a, const pack_t &b) {
+		return a.name < b.name;
+	});
+
+	return _packs.size();
+}
+
+int langPacks::find(const char *name) const
+{
+	for (size_t i = 0; i < _packs.size(); ++i) {
+		if (_packs[i].name == name) {
+			return static_cast<int>(i);
+		}
+	}
+	return -1;
+}
+
+/* split the mapping into rows, NUL-terminating them in place */
+bool langPacks::index(size_t rows)
+{
+	char *p = _map.data();
+	char *end = p + _map.size();
+
+	/* UTF-8 BOM */
+	if (end - p >= 3 && memcmp(p, "\xEF\xBB\xBF", 3) == 0) {
+		p += 3;
+	}
+
+	while (p < end && _rows.size() < rows) {
+		char *eol = static_cast<char *>(memchr(p, '\n', end - p));
+
+		if (!eol) {
+			/* no room for a terminator in the mapping */
+			_tail.assign(p, end - p);
+			if (!_tail.empty() && _tail.back() == '\r') {
+				_tail.pop_back();
+			}
+			_rows.push_back(std::string_view(_tail.c_str(), _tail.size()));
+			break;
+		}
+
+		*eol = 0;
+		if (eol > p && eol[-1] == '\r') {
+			eol[-1] = 0;
+		}
+
+		if (memchr(p, '|', strlen(p))) {
+			/* more than one column */
+			return false;
+		}
+
+		_rows.push_back(std::string_view(p, strlen(p)));
+		p = eol + 1;
+	}
+
+	return _rows.size() == rows;
+}
+
+bool langPacks::select(int i, size_t rows)
+{
+	TRACE_SCOPE("langPacks::select");
+
+	if (i == _selected) {
+		return true;
+	}
+
+	_map.close();
+	_rows.clear();
+	_tail.clear();
+	_selected = -1;
+
+	if (i < 0) {
+		return true;
+	}
+
+	if (static_cast<size_t>(i) >= _packs.size() || !_map.open(_packs[i].file.c_str(), true)) {
+		return false;
+	}
+
+	if (!index(rows)) {
+		_map.close();
+		_rows.clear();
+		_tail.clear();
+		return false;
+	}
+
+	_selected = i;
+	return true;
+}
+
+bool langPacks::saveSelection(const wchar_t *file) const
+{
+	FILE *fp;
+
+	if (_selected < 0) {
+#ifdef _WIN32
+		return DeleteFileW(file) || GetLastError() == ERROR_FILE_NOT_FOUND;
+#else
+		char mbs[PATH_MAX];
+		return wcstombs(mbs, file, sizeof(mbs)) != static_cast<size_t>(-1) && (remove(mbs) == 0 || errno == ENOENT);
+#endif
+	}
+
+	if ((fp = open_file(file, true)) == NULL) {
+		return false;
+	}
+
+	fprintf(fp, "%s\n", _packs[_selected].name.c_str());
+	return fclose(fp) == 0;
+}
+
+bool langPacks::restoreSelection(const wchar_t *file, size_t rows)
+{
+	char name[512];
+	FILE *fp;
+	int i;
+
+	if ((fp = open_file(file, false)) == NULL) {
+		return false;
+	}
+
+	if (!fgets(name, sizeof(name), fp)) {
+		fclose(fp);
+		return false;
+	}
+	fclose(fp);
+
+	name[strcspn(name, "\r\n")] = 0;
+
+	return (i = find(name)) >= 0 && select(i, rows);
+}
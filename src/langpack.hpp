@@ -0,0 +1,81 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Extra UI languages from lang-<name>.txt files next to the exe. A pack
+ * has the rows of lang.txt in the same order, each with a single column:
+ * the translation into the pack's language. Packs are only listed at
+ * startup. A pack is mapped and indexed when it is selected: the mapping
+ * is copy-on-write and the line ends are overwritten with NULs in place,
+ * so the labels point right into it. */
+
+#ifndef LANGPACK_HPP
+#define LANGPACK_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "mapfile.hpp"
+
+
+class langPacks
+{
+private:
+	typedef struct {
+		std::wstring file;
+		std::string name;  /* UTF-8, from the file name */
+	} pack_t;
+
+	std::vector<pack_t> _packs;
+	int _selected = -1;
+	mappedFile _map;
+	std::vector<std::string_view> _rows;
+	std::string _tail;  /* last row if the file doesn't end with a newline */
+
+	bool index(size_t rows);
+
+public:
+	/* list the packs in dir without opening them */
+	size_t discover(const wchar_t *dir);
+
+	size_t count() const { return _packs.size(); }
+	const char *name(size_t i) const { return _packs[i].name.c_str(); }
+	int find(const char *name) const;
+
+	/* map and index pack i, which must have the given number of rows;
+	 * -1 selects none */
+	bool select(int i, size_t rows);
+	int selected() const { return _selected; }
+
+	/* NUL-terminated string of the selected pack, NULL if none is selected */
+	const char *str(size_t row) const {
+		return (_selected >= 0 && row < _rows.size()) ? _rows[row].data() : NULL;
+	}
+
+	/* remember the selected pack in file, or restore it from there */
+	bool saveSelection(const wchar_t *file) const;
+	bool restoreSelection(const wchar_t *file, size_t rows);
+};
+
+#endif  /* LANGPACK_HPP */
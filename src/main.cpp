@@ -25,11 +25,6 @@
 #include <windows.h>
 #include <shellapi.h>
 
-#ifndef DIRECTINPUT_VERSION
-#define DIRECTINPUT_VERSION 0x0800
-#endif
-#include <dinput.h>
-
 #include <FL/Fl.H>
 #include <FL/Fl_Box.H>
 #include <FL/Fl_Button.H>
@@ -37,16 +32,19 @@
 #include <FL/Fl_Choice.H>
 #include <FL/Fl_Group.H>
 #include <FL/Fl_Tabs.H>
-#include <FL/Fl_PNG_Image.H>
 #include <FL/Fl_Double_Window.H>
 #include <FL/fl_draw.H>
+#include <FL/names.h>
+#include <FL/x.H>
 
 #include <algorithm>
 #include <string>
 #include <vector>
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <time.h>
 #include <wchar.h>
 
 #ifdef __GNUC__
@@ -56,12 +54,28 @@
 #endif
 
 #include "lang.h"
+#include "allocprof.hpp"
+#include "arena.hpp"
+#include "benchmark.hpp"
+#include "clock.hpp"
 #include "configuration.hpp"
-
-// https://blogs.msdn.microsoft.com/oldnewthing/20041025-00/?p=37483
-// https://stackoverflow.com/a/557859
-EXTERN_C IMAGE_DOS_HEADER __ImageBase;
-#define HINST_THISCOMPONENT  reinterpret_cast<HINSTANCE>(&__ImageBase)
+#include "eventlog.hpp"
+#include "futureimage.hpp"
+#include "gamepaddb.hpp"
+#include "hotplug.hpp"
+#include "game.hpp"
+#include "input.hpp"
+#include "inputdiag.hpp"
+#include "instance.hpp"
+#include "keycodes.hpp"
+#include "langpack.hpp"
+#include "metrics.hpp"
+#include "padtest.hpp"
+#include "pixelcache.hpp"
+#include "scaledimage.hpp"
+#include "staticlayer.hpp"
+#include "trace.hpp"
+#include "utf8.hpp"
 
 #define MAX_PATH_LENGTH      4096
 #define STRINGIFY(x)         #x
@@ -70,28 +84,21 @@ EXTERN_C IMAGE_DOS_HEADER __ImageBase;
 #define LS                   12  /* default labelsize */
 #define MENUITEM(x)          { x, 0,0,0,0, FL_NORMAL_LABEL, FL_HELVETICA, LS, 0 }
 #define ARRLEN(x)            (sizeof(x) / sizeof(*x))
+#define GAMEPADS_SHOWN       4
+#define PADTEST_FRAME        (1.0 / 60)  /* s, how often the test view drains the ring */
+#define PADTEST_STATS_US     1000000     /* rate and depth are averaged over this */
 
+/* launcher states reported over the control channel */
+#define STATE_STARTING       0
+#define STATE_UI             1
+#define STATE_GAME           2
 
-typedef struct {
-	uchar dxkey;
-	const char *name;
-} keyList_t;
-
-
-class DirectInput
-{
-private:
-	IDirectInput8 *m_directInput = NULL;
-	IDirectInputDevice8 *m_keyboard = NULL;
-
-public:
-	unsigned char m_keyboardState[256] = { 0 };
-
-	DirectInput() {}
+/* supervisor restart policy: restart at once after a healthy run,
+ * otherwise back off exponentially */
+#define BACKOFF_MIN_MS       500
+#define BACKOFF_MAX_MS       30000
+#define HEALTHY_RUN_MS       60000
 
-	bool init();
-	bool ReadKeyboard();
-};
 
 class MyChoice : public Fl_Choice
 {
@@ -158,10 +165,40 @@ public:
 	PadBox(int X, int Y, int H, const char *L = NULL, Fl_Align align = FL_ALIGN_LEFT);
 };
 
+/* highlights what is pressed on the first controller over the
+ * pad_controls_v02 artwork, with the input rate and queue depth below */
+class PadTestView : public Fl_Widget
+{
+private:
+	padSample_t _s;
+	bool _valid = false;
+	char _stats[96] = "";
+
+	/* the widget has no box, so the window has to repaint the artwork */
+	void damage_area() {
+		if (visible_r()) {
+			window()->damage(FL_DAMAGE_ALL, x(), y(), w(), h());
+		}
+	}
+
+public:
+	PadTestView(int X, int Y, int W, int H)
+		: Fl_Widget(X, Y, W, H)
+	{}
+
+	void sample(const padSample_t &s);
+	void stats(const char *s);
+	void clear();
+	void draw();
+};
+
 class MyWindow : public Fl_Double_Window
 {
 private:
 	kbButton *_but = NULL;
+	int _lastEvent = 0;
+
+	long damaged_pixels();
 
 public:
 	MyWindow(int W, int H, const char *L = NULL)
@@ -174,18 +211,43 @@ public:
 	kbButton *but() { return _but; }
 
 	int handle(int event);
-};
 
+	/* copies the damaged areas to the screen; also records
+	 * the paint statistics */
+	void flush();
+
+	/* draw everything into the current drawable, for -BenchRender */
+	void render() {
+		clear_damage(FL_DAMAGE_ALL);
+		draw();
+		clear_damage();
+	}
+
+	/* also called when the window was moved */
+	void resize(int X, int Y, int W, int H);
+};
 
-static void startWindow(bool restart, int setX, int setY);
 
 static configuration *config = NULL;
 static DirectInput *directinput = NULL;
+static instance *inst = NULL;
 static MyWindow *win = NULL;
-static Fl_Group *g2_keyboard, *g2_gamepad;
+static Fl_Tabs *tabs;
+static Fl_Group *g1, *g2, *g2_keyboard, *g2_gamepad;
+
+/* everything in the window; released when the window is rebuilt or
+ * before the game is launched */
+static arena uiArena;
 static kbButton *btUp, *btDown, *btLeft, *btRight, *btA, *btB, *btX, *btY, *btStart;
 
-#define IMAGE(x)  static Fl_PNG_Image x(NULL, x##_png, sizeof(x##_png))
+/* the parts of the settings tab and the two controller views that
+ * never change, see staticlayer.hpp */
+enum { LAYER_SETTINGS, LAYER_KEYBOARD, LAYER_GAMEPAD, LAYERS };
+static staticLayer *layers[LAYERS];
+
+/* decoded in the background, see main() */
+TRACE_STATIC_BEGIN(images)
+#define IMAGE(x)  static futureImage x(x##_png, sizeof(x##_png))
 IMAGE(arrow_01);
 IMAGE(arrow_02);
 IMAGE(arrow_03);
@@ -200,12 +262,93 @@ IMAGE(button_04);
 IMAGE(button_05);
 IMAGE(pad_controls_v02);
 #undef IMAGE
+TRACE_STATIC_END(images, "static image construction")
+
+static futureImage *images[] = {
+	&arrow_01, &arrow_02, &arrow_03, &arrow_04, &back1, &back2, &back3,
+	&button_01, &button_02, &button_03, &button_04, &button_05, &pad_controls_v02
+};
+
+/* "event pixels us" for every repaint, if $SONICLAUNCHER_PAINT_STATS
+ * names a file */
+static FILE *paintStats = NULL;
+
+/* display scale in percent; the window is built for 762x656 and scaled
+ * up, the artwork is resampled once per scale */
+static int uiScale = 100;
+static scaledImages scaledImgs;
+
+#ifdef SL_PIXELCACHE
+/* decoded and scaled artwork from the last launch */
+static pixelCache pixels;
+#endif
 
 static int rv = 0;
 static unsigned int lang = 0;
+static bool rebuildWindow = false;
+static bool launchRequested = false;
+
+/* -PreSpawn: the game is created suspended once the window is idle and
+ * resumed by the launch button, after main.conf was written */
+static bool preSpawn = false;
+static gameProcess uiGame;
+static uint64_t launchClicked = 0;  /* clock_us() */
+
+static int winX = 0, winY = 0;
+static volatile int state = STATE_STARTING;
+
+static const char *stateNames[] = { "starting", "ui", "game" };
+
+/* reported over the control channel and in the metrics file */
+static void set_state(int s)
+{
+	state = s;
+	metrics::stateStarting.set(s == STATE_STARTING);
+	metrics::stateUi.set(s == STATE_UI);
+	metrics::stateGame.set(s == STATE_GAME);
+	metrics::write();
+}
+
+static volatile bool supervisorStop = false;
+static event supervisorWake;
+
+/* a request handed over from the control channel's thread to the UI thread */
+static struct {
+	mutex lock;
+	event done;
+	bool pending = false;
+	bool abandoned = false;
+	std::string req;
+	std::string resp;
+} uiRequest;
 
 static wchar_t moduleRootDir[MAX_PATH_LENGTH];
 static wchar_t confFile[MAX_PATH_LENGTH];
+static wchar_t langFile[MAX_PATH_LENGTH];
+static wchar_t padDbFile[MAX_PATH_LENGTH];
+
+/* lang-*.txt files next to the exe */
+static langPacks packs;
+
+/* gamecontrollerdb.txt next to the exe, opened with the gamepad view */
+static gamepadDb padDb;
+static bool padDbOpened = false;
+static Fl_Box *padBox = NULL;
+
+/* refreshes padBox when controllers are plugged in or out */
+static hotplugMonitor hotplug;
+static bool hotplugOn = false;
+
+/* live controller test on the gamepad view */
+static padPoller padTester;
+static PadTestView *padView = NULL;
+static bool padTestOn = false;
+
+static struct {
+	uint64_t since;
+	unsigned long samples;
+	size_t maxDepth;
+} padRate;
 
 static const Fl_Menu_Item langItems[] =
 {
@@ -218,61 +361,18 @@ static const Fl_Menu_Item langItems[] =
 	{0}
 };
 
+static_assert(ARRLEN(langItems) - 1 == UI_LANGUAGES, "langItems doesn't match lang.txt");
 
-// https://www.daemonology.net/blog/2008-06-05-faster-utf8-strlen.html
-static void strip_last_utf8_char(char *s)
-{
-	int i = 0;
-	int last_char = 0;
-
-	/* bytes 0xC0 through 0xFF are the first byte
-	 * of a UTF-8 multi-byte character */
-	while (s[i]) {
-		if ((s[i] & 0xC0) != 0x80) {
-			last_char = i;
-		}
-		i++;
-	}
-
-	s[last_char] = 0;
-}
-
-bool DirectInput::init()
-{
-	if (DirectInput8Create(HINST_THISCOMPONENT, DIRECTINPUT_VERSION, IID_IDirectInput8, reinterpret_cast<LPVOID *>(&m_directInput), NULL) != DI_OK)	{
-		return false;
-	}
-
-	if (m_directInput->CreateDevice(GUID_SysKeyboard, &m_keyboard, NULL) != DI_OK) {
-		return false;
-	}
-
-	if (m_keyboard->SetDataFormat(&c_dfDIKeyboard) != DI_OK) {
-		return false;
-	}
-
-	if (m_keyboard->Acquire() != DI_OK) {
-		return false;
-	}
+/* for benchmark results */
+static const char *langCodes[] = { "en", "de", "es", "fr", "it", "ja" };
 
-	return true;
-}
+static_assert(ARRLEN(langCodes) == UI_LANGUAGES, "langCodes doesn't match lang.txt");
 
-bool DirectInput::ReadKeyboard()
+/* translated UI string, from the selected language pack if there is one */
+static const char *tr(int id)
 {
-	memset(m_keyboardState, 0, sizeof(m_keyboardState));
-
-	HRESULT res = m_keyboard->GetDeviceState(sizeof(m_keyboardState), reinterpret_cast<LPVOID>(m_keyboardState));
-
-	if (res != DI_OK) {
-		/* If the keyboard lost focus or was not acquired then try to get control back. */
-		if (res == DIERR_INPUTLOST || res == DIERR_NOTACQUIRED) {
-			m_keyboard->Acquire();
-		} else {
-			return false;
-		}
-	}
-	return true;
+	const char *s = packs.str(ui_rows[id]);
+	return s ? s : ui_str(id, lang);
 }
 
 int MyWindow::handle(int event)
@@ -281,6 +381,8 @@ int MyWindow::handle(int event)
 	uchar dxNew, dxOld;
 	kbButton *bt = but();
 
+	_lastEvent = event;
+
 	if (bt) {
 		/* a key button was already pressed -> ignore mouse events */
 		switch (event) {
@@ -296,7 +398,7 @@ int MyWindow::handle(int event)
 				bt->dxkey(bt->dxkey());
 				bt->value(0);
 				but(NULL);
-				redraw();
+				bt->redraw();
 				return 0;
 			}
 		case FL_DRAG:
@@ -307,9 +409,11 @@ int MyWindow::handle(int event)
 		}
 
 		if (bt->config() && event == FL_KEYDOWN) {
+			ALLOCPROF_SCOPE("key_rebind");
 			dxNew = dxOld = bt->dxkey();
 
-			if (directinput->init()) {
+			/* a replay has no keyboard to read */
+			if (!eventlog_replaying() && directinput->init()) {
 				while (true) {
 					if (!directinput->ReadKeyboard()) {
 						continue;
@@ -330,85 +434,130 @@ int MyWindow::handle(int event)
 
 					break;
 				}
+			} else if (keycode_from_fltk(Fl::event_key())) {
+				/* no DirectInput, take the key FLTK reports */
+				dxNew = keycode_from_fltk(Fl::event_key())->dik;
+
+				if (configuration::isIgnoredKey(dxNew)) {
+					dxNew = dxOld;
+				}
 			}
 
 			if (dxNew == dxOld) {
 				/* just restore the previous button label */
 				bt->dxkey(dxOld);
+				metrics::keyCaptureUnchanged.inc();
 			} else {
 				configuration *cfg = bt->config();
 				int kt = bt->keytype();
-				std::vector<uchar> v;
+				uchar keys[KEYSTART];
 
 				for (int i = KEYUP; i <= KEYSTART; ++i) {
-					if (kt == i) {
-						v.push_back(dxNew);
-					} else {
-						v.push_back(cfg->key(i));
-					}
+					keys[i - KEYUP] = (kt == i) ? dxNew : cfg->key(i);
 				}
 
-				std::sort(v.begin(), v.end());
-
-				if (std::unique(v.begin(), v.end()) != v.end()) {
+				if (configuration::hasDuplicateKeys(keys, KEYSTART)) {
 					/* duplicate keys */
 					bt->dxkey(dxOld);
+					metrics::keyCaptureDuplicate.inc();
 				} else {
 					bt->dxkey(dxNew);
+					metrics::keyCaptureChanged.inc();
 				}
 			}
 
 			bt->value(0);
 			but(NULL);
-			redraw();
+			bt->redraw();
 		}
 	}
 
 	return Fl_Double_Window::handle(event);
 }
 
+/* sum of the damaged children's areas; overlapping areas are counted twice */
+static long damaged_children(Fl_Group *g)
+{
+	long n = 0;
+
+	for (int i = 0; i < g->children(); ++i) {
+		Fl_Widget *o = g->child(i);
+
+		if (!o->visible() || !o->damage()) {
+			continue;
+		}
+
+		if (o->as_group() && o->damage() == FL_DAMAGE_CHILD) {
+			n += damaged_children(o->as_group());
+		} else {
+			n += static_cast<long>(o->w()) * o->h();
+		}
+	}
+
+	return n;
+}
+
+long MyWindow::damaged_pixels()
+{
+	Fl_X *i = Fl_X::i(this);
+	RECT r;
+
+	if ((damage() & ~FL_DAMAGE_CHILD) == 0) {
+		return damaged_children(this);
+	}
+
+	/* expose events and damage(c, x, y, w, h) leave a clip region */
+	if (i && i->region && GetRgnBox(i->region, &r) != 0) {
+		return static_cast<long>(r.right - r.left) * (r.bottom - r.top) +
+			((damage() & FL_DAMAGE_CHILD) ? damaged_children(this) : 0);
+	}
+
+	return static_cast<long>(w()) * h();
+}
+
+void MyWindow::flush()
+{
+	TRACE_SCOPE("MyWindow::flush");
+	static bool firstPaint = true;
+	long pixels = paintStats ? damaged_pixels() : 0;
+	uint64_t start = clock_us();
+
+	Fl_Double_Window::flush();
+
+	if (paintStats) {
+		const char *ev = (_lastEvent >= 0 && _lastEvent < static_cast<int>(ARRLEN(fl_eventnames)))
+			? fl_eventnames[_lastEvent] : "?";
+		fprintf(paintStats, "%s\t%ld\t%llu\n", ev, pixels,
+			static_cast<unsigned long long>(clock_us() - start));
+		fflush(paintStats);
+	}
+
+	if (firstPaint) {
+		/* the back buffer has been copied to the screen */
+		TRACE_END("first show and paint");
+		startup_mark("first_paint");
+		metrics::phaseFirstPaint.set(static_cast<int64_t>(metrics::uptime_us()));
+		firstPaint = false;
+	}
+}
+
+static void rescale_cb(void *);
+static void padtest_enable(bool on);
+
+void MyWindow::resize(int X, int Y, int W, int H)
+{
+	Fl_Double_Window::resize(X, Y, W, H);
+
+	if (shown()) {
+		/* check the scale once the window has stopped moving */
+		Fl::remove_timeout(rescale_cb);
+		Fl::add_timeout(0.3, rescale_cb);
+	}
+}
+
 void kbButton::dxkey(uchar n)
 {
 	// https://docs.microsoft.com/en-us/previous-versions/windows/desktop/ee418641(v%3Dvs.85)
-	const keyList_t keyNames[] =
-	{
-		{DIK_ABNT_C1, "ABNT C1"},
-		{DIK_ABNT_C2, "ABNT C2"},
-		{DIK_APOSTROPHE, "'"},
-		{DIK_AT, "@"},
-		{DIK_AX, "AX"},
-		{DIK_BACK, "Back"},
-		{DIK_COLON, ":"},
-		{DIK_DELETE, "Delete"},
-		{DIK_DOWN, "Down"},
-		{DIK_END, "End"},
-		{DIK_F13, "F13"},
-		{DIK_F14, "F14"},
-		{DIK_F15, "F15"},
-		{DIK_GRAVE, "`"},
-		{DIK_HOME, "Home"},
-		{DIK_INSERT, "Insert"},
-		{DIK_LCONTROL, "CTRL"},
-		{DIK_LEFT, "Left"},
-		{DIK_LMENU, "Alt"},
-		{DIK_LSHIFT, "Shift"},
-		{DIK_NEXT, "Page Down"},
-		{DIK_OEM_102, "OEM 102"},
-		{DIK_PAUSE, "Pause"},
-		{DIK_PRIOR, "Page Up"},
-		{DIK_RCONTROL, "Right CTRL"},
-		{DIK_RETURN, "Enter"},
-		{DIK_RIGHT, "Right"},
-		{DIK_RMENU, "Right Alt"},
-		{DIK_RSHIFT, "Right Shift"},
-		{DIK_SYSRQ, "SYSRQ"},
-		{DIK_TAB, "Tab"},
-		{DIK_UNDERLINE, "_"},
-		{DIK_UNLABELED, "UNLABELED"},
-		{DIK_UP, "Up"},
-		{DIK_YEN, "Yen"}
-	};
-
 	char buf[128] = { 0 };
 	uchar dxOld = dxkey();
 	uchar dx = n;
@@ -493,7 +642,7 @@ void kbButton::dxkey(uchar n)
 	}
 
 	if (GetKeyNameTextA(dx << 16, buf, sizeof(buf) - 1) > 0) {
-		fl_font(labelfont(), LS);
+		fl_font(labelfont(), labelsize());
 
 		/* test multibyte utf8 character stripping */
 		/*
@@ -511,27 +660,13 @@ void kbButton::dxkey(uchar n)
 		);
 		*/
 
-		int limit = w() - 2;
-
 		/* shrink label until it fits the widget */
-		if (static_cast<int>(fl_width(buf)) > limit) {
-			while (buf[0] != 0) {
-				strip_last_utf8_char(buf);
-				if (static_cast<int>(fl_width(buf)) <= limit) {
-					break;
-				}
-			}
-		}
+		fit_utf8_label(buf, w() - 2, static_cast<double (*)(const char *)>(fl_width));
 
 		copy_label(buf);
+	} else if (keycode_from_dik(dx)) {
+		label(keycode_from_dik(dx)->name);
 	} else {
-		for (unsigned int i = 0; i < ARRLEN(keyNames); ++i) {
-			if (dx == keyNames[i].dxkey) {
-				label(keyNames[i].name);
-				return;
-			}
-		}
-
 		_snprintf_s(buf, sizeof(buf) - 1, "0x%X", dx);
 		copy_label(buf);
 	}
@@ -567,6 +702,114 @@ PadBox::PadBox(int X, int Y, int H, const char *L, Fl_Align align)
 	labelsize(LS);
 }
 
+/* centres and radii on pad_controls_v02, in the order DirectInput reports
+ * the buttons of an Xbox controller */
+static const struct {
+	short x, y, r;
+} padButtons[] = {
+	{ 257, 150, 10 },  /* A */
+	{ 281, 127, 10 },  /* B */
+	{ 235, 127, 10 },  /* X */
+	{ 258, 107, 10 },  /* Y */
+	{  90,  74, 11 },  /* left bumper */
+	{ 260,  74, 11 },  /* right bumper */
+	{ 143, 130,  6 },  /* back */
+	{ 205, 130,  6 },  /* start */
+	{  88, 137, 23 },  /* left stick */
+	{ 211, 177, 22 }   /* right stick */
+};
+
+#define PAD_IMAGE_W  351
+#define PAD_IMAGE_H  253
+#define PAD_DPAD_X   133
+#define PAD_DPAD_Y   172
+#define PAD_DPAD_R   25
+#define PAD_STICK    8
+#define PAD_DEADZONE (PADTEST_AXIS_RANGE / 8)
+
+void PadTestView::sample(const padSample_t &s)
+{
+	bool changed = !_valid || s.buttons != _s.buttons || s.pov != _s.pov ||
+		s.lx != _s.lx || s.ly != _s.ly || s.rx != _s.rx || s.ry != _s.ry;
+
+	_s = s;
+	_valid = true;
+
+	if (changed) {
+		damage_area();
+	}
+}
+
+void PadTestView::stats(const char *s)
+{
+	snprintf(_stats, sizeof(_stats), "%s", s);
+	damage_area();
+}
+
+void PadTestView::clear()
+{
+	_valid = false;
+	_stats[0] = 0;
+	damage_area();
+}
+
+void PadTestView::draw()
+{
+	/* the window scales the geometry, so do the same to the artwork's */
+	auto sx = [this](int v) { return x() + v * w() / PAD_IMAGE_W; };
+	auto sy = [this](int v) { return y() + v * w() / PAD_IMAGE_W; };
+	auto sr = [this](int v) { return v * w() / PAD_IMAGE_W; };
+
+	fl_font(labelfont(), labelsize());
+	fl_color(FL_FOREGROUND_COLOR);
+	fl_draw(_stats, x(), sy(PAD_IMAGE_H), w(), y() + h() - sy(PAD_IMAGE_H), FL_ALIGN_CENTER);
+
+	if (!_valid) {
+		return;
+	}
+
+	fl_color(FL_YELLOW);
+	fl_line_style(FL_SOLID, std::max(sr(3), 1));
+
+	for (size_t i = 0; i < ARRLEN(padButtons); ++i) {
+		if (_s.buttons & (1u << i)) {
+			int r = sr(padButtons[i].r + 2);
+			fl_arc(sx(padButtons[i].x) - r, sy(padButtons[i].y) - r, 2 * r, 2 * r, 0, 360);
+		}
+	}
+
+	/* up is 0, then clockwise in hundredths of a degree */
+	if (_s.pov != 0xFFFF) {
+		double a = 90.0 - _s.pov / 100.0;
+		int r = sr(PAD_DPAD_R);
+		fl_arc(sx(PAD_DPAD_X) - r, sy(PAD_DPAD_Y) - r, 2 * r, 2 * r, a - 30, a + 30);
+	}
+
+	fl_line_style(0);
+
+	/* a dot where a pushed stick points */
+	const int32_t axes[2][2] = { { _s.lx, _s.ly }, { _s.rx, _s.ry } };
+
+	for (int i = 0; i < 2; ++i) {
+		int32_t ax = axes[i][0], ay = axes[i][1];
+
+		if (abs(ax) < PAD_DEADZONE && abs(ay) < PAD_DEADZONE) {
+			continue;
+		}
+
+		/* the sticks are the last two entries */
+		int n = ARRLEN(padButtons) - 2 + i;
+		int d = std::max(sr(PAD_STICK), 4);
+		int X = sx(padButtons[n].x + ax * (padButtons[n].r - PAD_STICK / 2) / PADTEST_AXIS_RANGE) - d / 2;
+		int Y = sy(padButtons[n].y + ay * (padButtons[n].r - PAD_STICK / 2) / PADTEST_AXIS_RANGE) - d / 2;
+
+		fl_color(FL_YELLOW);
+		fl_pie(X, Y, d, d, 0, 360);
+		fl_color(FL_BLACK);
+		fl_arc(X, Y, d, d, 0, 360);
+	}
+}
+
 int PadBox::measure_width(void)
 {
 	int w = 0;
@@ -590,13 +833,16 @@ int PadBox::measure_width(void)
 void MyChoice::menu(const Fl_Menu_Item *m)
 {
 	/* make sure we have a local copy of the menu with write access */
-	Fl_Choice::copy(m);
-	_menu = const_cast<Fl_Menu_Item *>(Fl_Choice::menu());
+	int n = m->size();
+	_menu = uiArena.array<Fl_Menu_Item>(n);
+	memcpy(_menu, m, n * sizeof(Fl_Menu_Item));
+	Fl_Choice::menu(_menu);
 }
 
 int MyChoice::handle(int event)
 {
 	const Fl_Menu_Item *m;
+	int item;
 
 	if (!menu() || !menu()->text) {
 		return 0;
@@ -614,7 +860,10 @@ int MyChoice::handle(int event)
 			Fl::focus(this);
 		}
 
-		if (Fl::scheme() || fl_contrast(textcolor(), FL_BACKGROUND2_COLOR) != textcolor()) {
+		if (eventlog_replay_pick(&item)) {
+			/* what was picked when the events were recorded */
+			m = (item >= 0 && item < size() - 1) ? menu() + item : NULL;
+		} else if (Fl::scheme() || fl_contrast(textcolor(), FL_BACKGROUND2_COLOR) != textcolor()) {
 			m = menu()->pulldown(x(), y(), w(), h(), NULL, this);
 		} else {
 			Fl_Color c = color();
@@ -622,6 +871,7 @@ int MyChoice::handle(int event)
 			m = menu()->pulldown(x(), y(), w(), h(), NULL, this);
 			color(c);
 		}
+		eventlog_pick(m ? static_cast<int>(m - menu()) : -1);
 
 		if (!m) {
 			return 1;
@@ -640,6 +890,8 @@ int MyChoice::handle(int event)
 
 static bool getModuleRootDir(void)
 {
+	TRACE_SCOPE("getModuleRootDir");
+
 	wchar_t mod[MAX_PATH_LENGTH];
 	wchar_t *wcp = NULL;
 
@@ -654,36 +906,98 @@ static bool getModuleRootDir(void)
 
 	SecureZeroMemory(&moduleRootDir, MAX_PATH_LENGTH * sizeof(wchar_t));
 	SecureZeroMemory(&confFile, MAX_PATH_LENGTH * sizeof(wchar_t));
+	SecureZeroMemory(&langFile, MAX_PATH_LENGTH * sizeof(wchar_t));
+	SecureZeroMemory(&padDbFile, MAX_PATH_LENGTH * sizeof(wchar_t));
 
 	wcscpy_s(moduleRootDir, MAX_PATH_LENGTH - 1, mod);
 	wcscpy_s(confFile, MAX_PATH_LENGTH - 1, mod);
 	wcscat_s(confFile, MAX_PATH_LENGTH - 1, L"\\main.conf");
+	wcscpy_s(langFile, MAX_PATH_LENGTH - 1, mod);
+	wcscat_s(langFile, MAX_PATH_LENGTH - 1, L"\\SonicLauncher.lang");
+	wcscpy_s(padDbFile, MAX_PATH_LENGTH - 1, mod);
+	wcscat_s(padDbFile, MAX_PATH_LENGTH - 1, L"\\" GAMEPADDB_FILE);
 
 	return true;
 }
 
+/* append a line to SonicLauncher.log */
+static void logLine(const char *fmt, ...)
+{
+	wchar_t path[MAX_PATH_LENGTH];
+	char stamp[32];
+	FILE *fp = NULL;
+	time_t t = time(NULL);
+	va_list args;
+
+	wcscpy_s(path, MAX_PATH_LENGTH - 1, moduleRootDir);
+	wcscat_s(path, MAX_PATH_LENGTH - 1, L"\\SonicLauncher.log");
+
+	if (_wfopen_s(&fp, path, L"a") != 0) {
+		return;
+	}
+
+	strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", localtime(&t));
+	fprintf(fp, "%s ", stamp);
+
+	va_start(args, fmt);
+	vfprintf(fp, fmt, args);
+	va_end(args);
+
+	putc('\n', fp);
+	fclose(fp);
+}
+
+/* exit code and run time of a game that exited */
+static void count_exit(DWORD exitCode, uint64_t runUs)
+{
+	if (exitCode == 0) {
+		metrics::exitClean.inc();
+	} else if (exitCode >= 0xC0000000) {
+		metrics::exitCrash.inc();
+	} else {
+		metrics::exitError.inc();
+	}
+	metrics::lastExitCode.set(exitCode);
+	metrics::session.observe(runUs);
+	metrics::write();
+}
+
 static int launchGame(void)
 {
 	const char *title = "Error: Sonic_vis.exe";
-	wchar_t command[MAX_PATH_LENGTH];
-	STARTUPINFOW si;
-	PROCESS_INFORMATION pi;
+	gameProcess &game = uiGame;
+	DWORD exitCode = 0;
 
-	wcscpy_s(command, MAX_PATH_LENGTH - 1, moduleRootDir);
-	wcscat_s(command, MAX_PATH_LENGTH - 1, L"\\Sonic_vis.exe");
+	set_state(STATE_GAME);
 
-	SecureZeroMemory(&si, sizeof(si));
-	si.cb = sizeof(si);
-	SecureZeroMemory(&pi, sizeof(pi));
+	/* already running if it was pre-spawned */
+	bool prespawned = game.running();
 
-	if (CreateProcessW(NULL, command, NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi) == FALSE) {
+	if (!prespawned && !game.spawn(moduleRootDir, false)) {
+		metrics::launchError.inc();
+		metrics::write();
 		MessageBoxA(0, "Failed calling CreateProcess()", title, MB_ICONERROR|MB_OK);
 		return 1;
 	}
+	metrics::launchOk.inc();
+
+	if (launchClicked != 0) {
+		uint64_t latency = game.resumed() - launchClicked;
+
+		(prespawned ? metrics::launchPrespawn : metrics::launchSpawn).observe(latency);
+		logLine("launch: click_to_first_instruction_ms=%.3f prespawned=%d", latency / 1000.0, prespawned ? 1 : 0);
+	}
 
-	DWORD wait = WaitForSingleObject(pi.hProcess, INFINITE);
-	CloseHandle(pi.hProcess);
-	CloseHandle(pi.hThread);
+	/* the startup is over, write the trace now rather than after the game quits */
+	TRACE_DUMP();
+
+	DWORD wait = game.wait(&exitCode);
+	uint64_t runUs = clock_us() - game.resumed();
+	game.close();
+
+	if (wait == WAIT_OBJECT_0) {
+		count_exit(exitCode, runUs);
+	}
 
 	if (wait == WAIT_ABANDONED) {
 		MessageBoxA(0, "Process abandoned.", title, MB_ICONERROR|MB_OK);
@@ -696,6 +1010,76 @@ static int launchGame(void)
 	return wait;
 }
 
+/* kiosk mode: keep the game running without any UI */
+static int superviseGame(void)
+{
+	gamePrefetch prefetch;
+	uint64_t exited = 0;
+	DWORD backoff = 0;
+
+	set_state(STATE_GAME);
+
+	logLine("supervisor: started, prefetched %u KiB", static_cast<unsigned int>(prefetch.load(moduleRootDir) / 1024));
+
+	while (!supervisorStop) {
+		gameProcess game;
+		DWORD exitCode = 0;
+
+		/* spawn suspended so the timestamp is taken right before the
+		 * child's first instruction */
+		bool spawned = game.spawn(moduleRootDir, true);
+
+		if (!spawned || !game.resume()) {
+			if (!spawned) {
+				logLine("supervisor: CreateProcess() failed (error %lu)", GetLastError());
+			} else {
+				/* waiting for a process that never runs would hang for good */
+				logLine("supervisor: ResumeThread() failed (error %lu)", GetLastError());
+				game.discard();
+			}
+			metrics::launchError.inc();
+			metrics::write();
+			exited = 0;
+			backoff = (backoff == 0) ? BACKOFF_MIN_MS : std::min<DWORD>(backoff * 2, BACKOFF_MAX_MS);
+		} else {
+			metrics::launchOk.inc();
+
+			if (exited != 0) {
+				logLine("supervisor: restart_latency_ms=%.3f backoff_ms=%lu",
+					(game.resumed() - exited) / 1000.0, backoff);
+			}
+
+			DWORD wait = game.wait(&exitCode);
+			exited = clock_us();
+			uint64_t runMs = (exited - game.resumed()) / 1000;
+			game.close();
+
+			if (wait != WAIT_OBJECT_0) {
+				logLine("supervisor: waiting for the game failed (%lu)", wait);
+				exited = 0;
+			} else {
+				logLine("supervisor: game exited with code %lu after %.1f s", exitCode, runMs / 1000.0);
+				count_exit(exitCode, exited - game.resumed());
+			}
+
+			if (runMs >= HEALTHY_RUN_MS) {
+				backoff = 0;
+			} else {
+				backoff = (backoff == 0) ? BACKOFF_MIN_MS : std::min<DWORD>(backoff * 2, BACKOFF_MAX_MS);
+			}
+		}
+
+		if (backoff > 0 && !supervisorStop) {
+			/* use the pause to bring the game files back into memory */
+			prefetch.touch();
+			supervisorWake.wait(backoff);
+		}
+	}
+
+	logLine("supervisor: stopped");
+	return 0;
+}
+
 static void setResolution_cb(Fl_Widget *o, void *)
 {
 	MyChoice *b = dynamic_cast<MyChoice *>(o);
@@ -708,15 +1092,136 @@ static void setDisplay_cb(Fl_Widget *o, void *)
 	config->display(static_cast<uchar>(b->value()));
 }
 
+/* rebuild the window at its current position once Fl::run() returns */
+static void restartWindow(void)
+{
+	winX = win->x();
+	winY = win->y();
+	rebuildWindow = true;
+	win->hide();
+}
+
+/* opt out of the bitmap stretching Windows applies to DPI-unaware programs;
+ * per monitor on Windows 8.1 and later, for the primary screen before */
+static void set_dpi_aware(void)
+{
+	typedef HRESULT (WINAPI *SetProcessDpiAwareness_t)(int);
+	typedef BOOL (WINAPI *SetProcessDPIAware_t)(void);
+	HMODULE shcore = LoadLibraryA("shcore.dll");
+
+	if (shcore) {
+		SetProcessDpiAwareness_t setAwareness = reinterpret_cast<SetProcessDpiAwareness_t>(
+			GetProcAddress(shcore, "SetProcessDpiAwareness"));
+
+		/* PROCESS_PER_MONITOR_DPI_AWARE */
+		if (setAwareness && setAwareness(2) == S_OK) {
+			return;
+		}
+	}
+
+	SetProcessDPIAware_t setAware = reinterpret_cast<SetProcessDPIAware_t>(
+		GetProcAddress(GetModuleHandleA("user32.dll"), "SetProcessDPIAware"));
+
+	if (setAware) {
+		setAware();
+	}
+}
+
+/* scale in percent of the screen at X/Y, in the steps Windows offers */
+static int screen_scale(int X, int Y)
+{
+	typedef HRESULT (WINAPI *GetDpiForMonitor_t)(HMONITOR, int, UINT *, UINT *);
+	static GetDpiForMonitor_t getDpiForMonitor = NULL;
+	static bool loaded = false;
+	UINT dpiX = 0, dpiY = 0;
+	int scale;
+
+	if (!loaded) {
+		HMODULE shcore = LoadLibraryA("shcore.dll");
+
+		if (shcore) {
+			getDpiForMonitor = reinterpret_cast<GetDpiForMonitor_t>(GetProcAddress(shcore, "GetDpiForMonitor"));
+		}
+		loaded = true;
+	}
+
+	if (getDpiForMonitor) {
+		POINT pt = { X, Y };
+
+		/* MDT_EFFECTIVE_DPI */
+		if (getDpiForMonitor(MonitorFromPoint(pt, MONITOR_DEFAULTTONEAREST), 0, &dpiX, &dpiY) != S_OK) {
+			dpiX = 0;
+		}
+	}
+
+	if (dpiX == 0) {
+		HDC dc = GetDC(NULL);
+		dpiX = GetDeviceCaps(dc, LOGPIXELSX);
+		ReleaseDC(NULL, dc);
+	}
+
+	scale = (static_cast<int>(dpiX) * 100 / 96 + 12) / 25 * 25;
+
+	return std::min(std::max(scale, 100), 400);
+}
+
+/* the window was moved to a screen with another scale: build it again */
+static void rescale_cb(void *)
+{
+	if (win && screen_scale(win->x() + win->w() / 2, win->y() + win->h() / 2) != uiScale) {
+		restartWindow();
+	}
+}
+
+/* scale the fonts and images of o and its children; the window
+ * scales the geometry */
+static void scale_widget(Fl_Widget *o, int scale)
+{
+	Fl_Group *g = o->as_group();
+	MyChoice *c = dynamic_cast<MyChoice *>(o);
+
+	o->labelsize(o->labelsize() * scale / 100);
+
+	if (o->image()) {
+		futureImage *fi = dynamic_cast<futureImage *>(o->image());
+		o->image(scaledImgs.get(o->image(), scale, fi ? fi->hash() : 0));
+	}
+
+	if (c && c->menu()) {
+		/* our own copy, see MyChoice::menu() */
+		for (Fl_Menu_Item *m = c->menu(); m->text; ++m) {
+			m->labelsize_ = m->labelsize_ * scale / 100;
+		}
+	}
+
+	for (int i = 0; g && i < g->children(); ++i) {
+		scale_widget(g->child(i), scale);
+	}
+}
+
 static void setLang_cb(Fl_Widget *o, void *)
 {
 	MyChoice *b = dynamic_cast<MyChoice *>(o);
-	int setX = win->x();
-	int setY = win->y();
-	lang = b->value();
-	config->language(static_cast<uchar>(lang));
-	win->hide();
-	startWindow(true, setX, setY);
+	int n = b->value();
+
+	/* a replay keeps its window, and the saved selection */
+	if (eventlog_replaying()) {
+		return;
+	}
+
+	if (n < UI_LANGUAGES) {
+		lang = n;
+		config->language(static_cast<uchar>(lang));
+		packs.select(-1, 0);
+	} else if (!packs.select(n - UI_LANGUAGES, UI_ROWS)) {
+		/* the game's language is left unchanged for packs */
+		MessageBoxA(0, "Invalid language pack.", "Error", MB_ICONERROR|MB_OK);
+	}
+	packs.saveSelection(langFile);
+
+	/* ends when the new window is idle */
+	ALLOCPROF_BEGIN("language_switch");
+	restartWindow();
 }
 
 static void fullscreen_cb(Fl_Widget *, void *)
@@ -729,24 +1234,24 @@ static void vibrate_cb(Fl_Widget *, void *)
 	config->vibra(config->vibra() == 0 ? 1 : 0);
 }
 
-static void setController_cb(Fl_Widget *o, void *v)
+static void setController_cb(Fl_Widget *o, void *)
 {
+	ALLOCPROF_SCOPE("controller_toggle");
 	MyChoice *p = dynamic_cast<MyChoice *>(o);
-	Fl_Box *b = reinterpret_cast<Fl_Box *>(v);
 	int n = p->value();
 
 	if (n == GAMEPAD_CTRLS) {
 		config->controls(n);
-		b->image(&back2);
 		g2_keyboard->hide();
 		g2_gamepad->show();
 	} else {
 		config->controls(KEYBOARD_CTRLS);
-		b->image(&back3);
 		g2_keyboard->show();
 		g2_gamepad->hide();
 	}
+	padtest_enable(n == GAMEPAD_CTRLS);
 
+	/* each view has its own background, which covers the whole window */
 	win->redraw();
 }
 
@@ -754,36 +1259,201 @@ static void setDefaultKeys_cb(Fl_Widget *, void *)
 {
 	config->setDefaultKeys();
 
-	/* "refresh" buttons */
-	btUp->dxkey(config->key(KEYUP));
-	btDown->dxkey(config->key(KEYDOWN));
-	btLeft->dxkey(config->key(KEYLEFT));
-	btRight->dxkey(config->key(KEYRIGHT));
-	btA->dxkey(config->key(KEYA));
-	btB->dxkey(config->key(KEYB));
-	btX->dxkey(config->key(KEYX));
-	btY->dxkey(config->key(KEYY));
-	btStart->dxkey(config->key(KEYSTART));
+	kbButton *buttons[] = { btUp, btDown, btLeft, btRight, btA, btB, btX, btY, btStart };
 
-	win->redraw();
+	/* "refresh" buttons; only they need to be repainted */
+	for (unsigned int i = 0; i < ARRLEN(buttons); ++i) {
+		buttons[i]->dxkey(config->key(buttons[i]->keytype()));
+		buttons[i]->redraw();
+	}
 }
 
 static void setKey_cb(Fl_Widget *o, void *)
 {
 	kbButton *b = dynamic_cast<kbButton *>(o);
-	b->label(ui_Press[lang]);  /* "Press!" */
+	b->label(tr(UI_PRESS));  /* "Press!" */
 	b->value(1);
 	win->but(b);
-	win->redraw();
+	b->redraw();
 }
 
 static void bigButton_cb(Fl_Widget *, void *)
 {
+	if (eventlog_replaying()) {
+		return;
+	}
+
+	launchClicked = clock_us();
+
 	if (!config->saveConfig()) {
 		MessageBoxA(0, "Couldn't save configuration.", "Error", MB_ICONERROR|MB_OK);
 	}
+
+	/* main.conf is written and closed, so a pre-spawned game may run now;
+	 * it hasn't executed anything yet that could have read the old one */
+	if (uiGame.suspended() && !uiGame.resume()) {
+		uiGame.discard();
+	}
+
+	/* the game is launched (or waited for) after the window was torn down */
+	launchRequested = true;
 	win->hide();
-	rv = launchGame();
+}
+
+/* runs a control request on the UI thread */
+static void control_ui_cb(void *)
+{
+	std::vector<std::string> v;
+	std::string resp = "ERR\tunknown request";
+	bool restart = false;
+	bool launch = false;
+
+	instance::split(uiRequest.req, v);
+
+	if (v[0] == "get" && v.size() <= 2) {
+		std::string s = config->dump();
+
+		if (v.size() == 1) {
+			resp = "OK\n" + s;
+		} else {
+			/* single field */
+			size_t pos = ("\n" + s).find("\n" + v[1] + "=");
+			if (pos == std::string::npos) {
+				resp = "ERR\tunknown field";
+			} else {
+				pos += v[1].size() + 1;
+				resp = "OK\t" + s.substr(pos, s.find('\n', pos) - pos);
+			}
+		}
+	} else if (v[0] == "set" && v.size() == 3) {
+		if (config->set(v[1].c_str(), v[2].c_str())) {
+			resp = "OK";
+			restart = true;
+		} else {
+			resp = "ERR\tinvalid field or value";
+		}
+	} else if (v[0] == "launch" && v.size() == 1) {
+		resp = "OK";
+		launch = true;
+	} else if (v[0] == "args") {
+		/* forwarded by a second instance */
+		for (size_t i = 1; i < v.size(); ++i) {
+			if (stricmp(v[i].c_str(), "-QuickBoot") == 0) {
+				launch = true;
+			}
+		}
+		resp = "OK";
+	}
+
+	uiRequest.lock.lock();
+	uiRequest.resp = resp;
+	uiRequest.pending = false;
+	if (!uiRequest.abandoned) {
+		uiRequest.done.set();
+	}
+	uiRequest.abandoned = false;
+	uiRequest.lock.unlock();
+
+	if (launch) {
+		bigButton_cb(NULL, NULL);
+	} else if (restart) {
+		restartWindow();
+	} else if (v[0] == "args") {
+		/* bring the window to front */
+		win->show();
+	}
+}
+
+/* runs on the control channel's thread */
+static std::string control_handler(const std::string &req)
+{
+	std::string resp;
+	bool done;
+
+	if (req == "status") {
+		return std::string("OK\t") + stateNames[state];
+	}
+
+	/* answered from any state, for monitoring */
+	if (req == "metrics") {
+		resp = "OK\n";
+		metrics::text(resp);
+		resp.pop_back();  /* the channel ends the response */
+		return resp;
+	}
+
+	if (req == "stop") {
+		/* don't restart the game in supervisor mode */
+		supervisorStop = true;
+		supervisorWake.set();
+		return "OK";
+	}
+
+	if (state != STATE_UI) {
+		return "ERR\tbusy";
+	}
+
+	uiRequest.lock.lock();
+	if (uiRequest.pending) {
+		uiRequest.lock.unlock();
+		return "ERR\tbusy";
+	}
+	uiRequest.pending = true;
+	uiRequest.abandoned = false;
+	uiRequest.req = req;
+	uiRequest.lock.unlock();
+
+	Fl::awake(control_ui_cb, NULL);
+	done = uiRequest.done.wait(5000);
+
+	uiRequest.lock.lock();
+	if (!done) {
+		if (uiRequest.pending) {
+			/* the UI thread will pick it up later, but nobody waits for it */
+			uiRequest.abandoned = true;
+			uiRequest.lock.unlock();
+			return "ERR\ttimeout";
+		}
+		/* finished right after the time-out */
+		uiRequest.done.wait(0);
+	}
+	resp = uiRequest.resp;
+	uiRequest.lock.unlock();
+
+	return resp;
+}
+
+/* the event loop went idle: the new window is interactive */
+static void ready_cb(void *)
+{
+	static bool firstReady = true;
+
+	Fl::remove_idle(ready_cb);
+	ALLOCPROF_END("startup");
+	ALLOCPROF_END("language_switch");
+
+	if (firstReady) {
+		startup_mark("ready");
+		metrics::phaseReady.set(static_cast<int64_t>(metrics::uptime_us()));
+		metrics::startupFaults.set(static_cast<int64_t>(metrics::page_faults()));
+		metrics::write();
+
+		/* if it fails, the launch button tries again and reports it */
+		if (preSpawn && !uiGame.running()) {
+			TRACE_SCOPE("pre-spawn game");
+			uiGame.spawn(moduleRootDir, true);
+		}
+	}
+
+#ifdef SL_PIXELCACHE
+	/* everything the window needed is decoded and scaled by now */
+	pixels.save();
+
+	if (firstReady) {
+		startup_mark("pixels_saved");
+	}
+#endif
+	firstReady = false;
 }
 
 static int esc_handler(int event)
@@ -794,18 +1464,193 @@ static int esc_handler(int event)
 	return 0;
 }
 
-static void startWindow(bool restart, int setX, int setY)
+/* resolution, color depth or DPI changed: the cached layers
+ * may no longer match the screen */
+static int screen_handler(int event)
+{
+	if (event != FL_SCREEN_CONFIGURATION_CHANGED || !win) {
+		return 0;
+	}
+
+	for (int i = 0; i < LAYERS; ++i) {
+		layers[i]->invalidate();
+	}
+	win->redraw();
+
+	return 0;
+}
+
+/* mapping line for a DirectInput product GUID; unknown controllers are
+ * named by their USB vendor and product ID */
+static std::string_view gamepad_mapping(const GUID &product, std::string &name)
+{
+	char guid[GAMEPADDB_GUID_LENGTH + 1];
+	std::string_view line;
+
+	/* DirectInput product GUIDs are "<vid><pid>-0000-0000-0000-PIDVID" */
+	unsigned int vendor = LOWORD(product.Data1);
+	unsigned int productId = HIWORD(product.Data1);
+	bool usb = (memcmp(product.Data4 + 2, "PIDVID", 6) == 0);
+
+	if (usb) {
+		gamepadDb::usb_guid(guid, vendor, productId);
+		line = padDb.find(guid);
+	}
+	if (line.empty()) {
+		gamepadDb::raw_guid(guid, reinterpret_cast<const unsigned char *>(&product));
+		line = padDb.find(guid);
+	}
+
+	if (line.empty()) {
+		char buf[64];
+
+		snprintf(buf, sizeof(buf), usb ? "%04x:%04x ?" : "?", vendor, productId);
+		name = buf;
+	} else {
+		name = gamepadDb::name(line);
+	}
+	return line;
+}
+
+/* names of the attached controllers and the mapping of the first one;
+ * red if it isn't in the database. Also called when devices come and go. */
+static void show_gamepad_mapping(void)
+{
+	GUID products[GAMEPADS_SHOWN];
+	std::string label, name;
+	std::string_view first;
+
+	if (!padBox) {
+		return;
+	}
+
+	/* the monitor already knows, DirectInput would enumerate every device */
+	if (hotplugOn && hotplug.devices().empty()) {
+		padBox->hide();
+		return;
+	}
+
+	if (!padDbOpened) {
+		padDb.open(padDbFile);
+		padDbOpened = true;
+	}
+
+	int n = directinput->Gamepads(products, GAMEPADS_SHOWN);
+
+	if (n < 1) {
+		padBox->hide();
+		return;
+	}
+
+	for (int i = 0; i < n; ++i) {
+		std::string_view line = gamepad_mapping(products[i], name);
+
+		if (i == 0) {
+			first = line;
+		} else {
+			label += " / ";
+		}
+		label += name;
+	}
+
+	if (first.empty()) {
+		padBox->labelcolor(FL_RED);
+	} else {
+		/* the mapping without GUID, name and platform, "<guid>,Name" has none */
+		size_t offset = GAMEPADDB_GUID_LENGTH + 1 + gamepadDb::name(first).size() + 1;
+		std::string_view mapping = offset < first.size() ? first.substr(offset) : std::string_view();
+		size_t start = label.size() + 1;
+
+		label += "\n";
+		label += mapping.substr(0, mapping.find("platform:"));
+		std::replace(label.begin() + start, label.end(), ',', ' ');
+		padBox->labelcolor(FL_FOREGROUND_COLOR);
+	}
+
+	padBox->copy_label(label.c_str());
+	padBox->show();
+	padBox->redraw_label();
+}
+
+/* drains whatever the input thread queued since the last frame; never
+ * waits for it */
+static void padtest_cb(void *)
+{
+	padSample_t s;
+	size_t depth = padTester.depth();
+	bool got = false;
+
+	for (size_t i = 0; i < padPoller::capacity() && padTester.pop(s); ++i) {
+		padRate.samples++;
+		got = true;
+	}
+
+	if (got) {
+		padView->sample(s);
+	}
+	padRate.maxDepth = std::max(padRate.maxDepth, depth);
+
+	uint64_t now = clock_us();
+
+	if (now - padRate.since >= PADTEST_STATS_US) {
+		char buf[96];
+
+		snprintf(buf, sizeof(buf), "%lu Hz    queue %lu / %lu    dropped %lu",
+			static_cast<unsigned long>(padRate.samples * 1000000 / (now - padRate.since)),
+			static_cast<unsigned long>(padRate.maxDepth),
+			static_cast<unsigned long>(padPoller::capacity()),
+			padTester.dropped());
+		padView->stats(buf);
+
+		padRate.since = now;
+		padRate.samples = 0;
+		padRate.maxDepth = 0;
+	}
+
+	Fl::repeat_timeout(PADTEST_FRAME, padtest_cb);
+}
+
+/* (re)open the first controller for the test view, or stop reading it */
+static void padtest_enable(bool on)
+{
+	Fl::remove_timeout(padtest_cb);
+	padTester.stop();
+	padTestOn = on;
+
+	if (!padView) {
+		return;
+	}
+	padView->clear();
+
+	if (!on || eventlog_replaying() || !padTester.start(directinput->Interface())) {
+		return;
+	}
+
+	padRate.since = clock_us();
+	padRate.samples = 0;
+	padRate.maxDepth = 0;
+	Fl::add_timeout(PADTEST_FRAME, padtest_cb);
+}
+
+static void hotplug_cb(void *)
+{
+	show_gamepad_mapping();
+
+	/* the first controller may be a different one now */
+	if (padTestOn) {
+		padtest_enable(true);
+	}
+}
+
+static void buildWindow(bool restart)
 {
-	Fl_Tabs *tabs;
-	Fl_Group *g1, *g2;
 	Fl_Button *bigButton;
-	std::string *devLabels;
 	Fl_Menu_Item *devItems;
-	char buf[128], bufJB[128], bufJS[128];
+	const char *player, *labelJB, *labelJS;
+	char buf[128];
 
 	int sc = config->screenCount();
-	devLabels = new std::string[sc];
-	devItems = new Fl_Menu_Item[sc + 1];
+	devItems = uiArena.array<Fl_Menu_Item>(sc + 1);
 
 	if (!restart && !config->loadConfig()) {
 		config->loadDefaultConfig();
@@ -816,25 +1661,28 @@ static void startWindow(bool restart, int setX, int setY)
 		lang = 0;  /* English */
 	}
 
-	Fl::add_handler(esc_handler);
 	Fl::get_system_colors();
 
 	/* use exe's icon resource to set window default icons */
-	wchar_t mod[MAX_PATH_LENGTH];
-	HICON hIconL[1] = { 0 };
-	HICON hIconS[1] = { 0 };
-	HICON *phIconL = hIconL;
-	HICON *phIconS = hIconS;
-	GetModuleFileNameW(NULL, mod, MAX_PATH_LENGTH);
-	ExtractIconExW(mod, 0, phIconL, phIconS, 1);
-	Fl_Window::default_icons(hIconL[0], hIconS[0]);
-
-	win = new MyWindow(762, 656, "SONIC THE HEDGEHOG 4 Episode I");
 	{
-		tabs = new Fl_Tabs(32, 16, 698, 532);
+		TRACE_SCOPE("ExtractIconExW");
+		wchar_t mod[MAX_PATH_LENGTH];
+		HICON hIconL[1] = { 0 };
+		HICON hIconS[1] = { 0 };
+		HICON *phIconL = hIconL;
+		HICON *phIconS = hIconS;
+		GetModuleFileNameW(NULL, mod, MAX_PATH_LENGTH);
+		ExtractIconExW(mod, 0, phIconL, phIconS, 1);
+		Fl_Window::default_icons(hIconL[0], hIconS[0]);
+	}
+
+	TRACE_BEGIN("buildWindow widgets");
+	win = uiArena.make<MyWindow>(762, 656, "SONIC THE HEDGEHOG 4 Episode I");
+	{
+		tabs = uiArena.make<Fl_Tabs>(32, 16, 698, 532);
 		{
 			/* "Settings" */
-			g1 = new Fl_Group(32, 36, 698, 512, ui_Settings[lang]);
+			g1 = uiArena.make<Fl_Group>(32, 36, 698, 512, tr(UI_SETTINGS));
 			{
 				/* Resolution list */
 				Fl_Menu_Item resItems[SZRESLIST + 1];
@@ -847,213 +1695,267 @@ static void startWindow(bool restart, int setX, int setY)
 				/* Display list */
 				for (int i = 0; i < sc; ++i) {
 					_snprintf_s(buf, sizeof(buf) - 1, "Display %d", i);
-					devLabels[i] = buf;
-					devItems[i] = MENUITEM(devLabels[i].c_str());
+					devItems[i] = MENUITEM(uiArena.strdup(buf));
 				}
 				devItems[sc] = {0};
 
 				/* Background image */
-				{ Fl_Box *o = new Fl_Box(-1, 9, 1, 1);
+				layers[LAYER_SETTINGS] = uiArena.make<staticLayer>(0, 0, 762, 656);
+				{ Fl_Box *o = uiArena.make<Fl_Box>(-1, 9, 1, 1);
 				o->align(FL_ALIGN_BOTTOM_LEFT);
 				o->image(&back1); }
+				layers[LAYER_SETTINGS]->end();
 
 				/* Display selection */
-				{ MyChoice *o = new MyChoice(42, 64, 328, 24, ui_GraphicsDevice[lang]);
+				{ MyChoice *o = uiArena.make<MyChoice>(42, 64, 328, 24, tr(UI_GRAPHICS_DEVICE));
 				o->menu(devItems);
 				o->callback(setDisplay_cb); }
 
 				/* Resolution */
-				{ MyChoice *o = new MyChoice(42, 112, 328, 24, ui_Resolution[lang]);
+				{ MyChoice *o = uiArena.make<MyChoice>(42, 112, 328, 24, tr(UI_RESOLUTION));
 				o->menu(resItems);
 				o->value(config->resN());
 				o->callback(setResolution_cb); }
 				
 				/* Fullscreen */
-				{ Fl_Check_Button *o = new Fl_Check_Button(42, 150, 328, 24, ui_Fullscreen[lang]);
+				{ Fl_Check_Button *o = uiArena.make<Fl_Check_Button>(42, 150, 328, 24, tr(UI_FULLSCREEN));
 				o->labelsize(LS);
 				o->value(config->fullscreen() == 0 ? 0 : 1);
 				o->clear_visible_focus();
 				o->callback(fullscreen_cb); }
 
-				/* Language */
-				{ MyChoice *o = new MyChoice(42, 228, 328, 24, ui_Language[lang]);
-				o->menu(langItems);
-				o->value(lang);
+				/* Language, followed by the language packs */
+				Fl_Menu_Item *langPackItems = uiArena.array<Fl_Menu_Item>(UI_LANGUAGES + packs.count() + 1);
+				memcpy(langPackItems, langItems, UI_LANGUAGES * sizeof(Fl_Menu_Item));
+
+				for (size_t i = 0; i < packs.count(); ++i) {
+					langPackItems[UI_LANGUAGES + i] = MENUITEM(packs.name(i));
+				}
+
+				{ MyChoice *o = uiArena.make<MyChoice>(42, 228, 328, 24, tr(UI_LANGUAGE));
+				o->menu(langPackItems);
+				o->value(packs.selected() >= 0 ? UI_LANGUAGES + packs.selected() : lang);
 				o->callback(setLang_cb); }
 			}
 			g1->end();
 			g1->labelsize(LS);
 
-			_snprintf_s(buf, sizeof(buf) - 1, "%s %d", ui_Player[lang], 1);
-			_snprintf_s(bufJB, sizeof(bufJB) - 1, "%s / %s", ui_Jump[lang], ui_Back[lang]);
-			_snprintf_s(bufJS, sizeof(bufJS) - 1, "%s / %s", ui_Jump[lang], ui_Select[lang]);
+			/* labels must outlive this function */
+			_snprintf_s(buf, sizeof(buf) - 1, "%s %d", tr(UI_PLAYER), 1);
+			player = uiArena.strdup(buf);
+			_snprintf_s(buf, sizeof(buf) - 1, "%s / %s", tr(UI_JUMP), tr(UI_BACK));
+			labelJB = uiArena.strdup(buf);
+			_snprintf_s(buf, sizeof(buf) - 1, "%s / %s", tr(UI_JUMP), tr(UI_SELECT));
+			labelJS = uiArena.strdup(buf);
 
 			/* "Player 1" */
-			g2 = new Fl_Group(32, 36, 698, 512);
-			g2->label(buf);
+			g2 = uiArena.make<Fl_Group>(32, 36, 698, 512);
+			g2->label(player);
 			{
 				const Fl_Menu_Item conItems[] = {
-					MENUITEM(ui_Keyboard[lang]),
-					MENUITEM(ui_Gamepad[lang]),
+					MENUITEM(tr(UI_KEYBOARD)),
+					MENUITEM(tr(UI_GAMEPAD)),
 					{0}
 				};
 
-				/* Background image */
-				Fl_Box *bg = new Fl_Box(-1, 2, 1, 1);
-				bg->align(FL_ALIGN_BOTTOM_LEFT);
-
 				/* Keyboard bindings */
-				g2_keyboard = new Fl_Group(32, 36, 698, 512);
+				g2_keyboard = uiArena.make<Fl_Group>(32, 36, 698, 512);
 				{
+					layers[LAYER_KEYBOARD] = uiArena.make<staticLayer>(0, 0, 762, 656);
+					{
+						/* Background image */
+						{ Fl_Box *o = uiArena.make<Fl_Box>(-1, 2, 1, 1);
+						o->align(FL_ALIGN_BOTTOM_LEFT);
+						o->image(&back3); }
+
+						/* "Movement" frame */
+						{ Fl_Box *o = uiArena.make<Fl_Box>(59, 192, 312, 277, tr(UI_MOVEMENT));
+						o->labelsize(LS);
+						o->align(FL_ALIGN_TOP_LEFT);
+						o->box(FL_ENGRAVED_FRAME); }
+
+						/* Up */
+						{ Fl_Box *o = uiArena.make<Fl_Box>(174, 203, 89, 38, tr(UI_UP));
+						o->labelsize(LS); }
+						{ Fl_Box *o = uiArena.make<Fl_Box>(216, 299, 1, 1);
+						o->image(&arrow_04); }
+
+						/* Left */
+						{ Fl_Box *o = uiArena.make<Fl_Box>(70, 273, 89, 38, tr(UI_LEFT));
+						o->labelsize(LS); }
+						{ Fl_Box *o = uiArena.make<Fl_Box>(179, 330, 1, 1);
+						o->image(&arrow_01); }
+
+						/* Right */
+						{ Fl_Box *o = uiArena.make<Fl_Box>(274, 273, 89, 38, tr(UI_RIGHT));
+						o->labelsize(LS); }
+						{ Fl_Box *o = uiArena.make<Fl_Box>(254, 330, 1, 1);
+						o->image(&arrow_02); }
+
+						/* Down */
+						{ Fl_Box *o = uiArena.make<Fl_Box>(174, 423, 89, 38, tr(UI_DOWN));
+						o->labelsize(LS); }
+						{ Fl_Box *o = uiArena.make<Fl_Box>(216, 365, 1, 1);
+						o->image(&arrow_03); }
+
+						/* "Action" frame */
+						{ Fl_Box *o = uiArena.make<Fl_Box>(407, 192, 294, 277, tr(UI_ACTION));
+						o->labelsize(LS);
+						o->align(FL_ALIGN_TOP_LEFT);
+						o->box(FL_ENGRAVED_FRAME); }
+
+						/* Score Attack / Time Attack */
+						{ Fl_Box *o = uiArena.make<Fl_Box>(452, 223, 1, 1, tr(UI_SCORE_ATTACK));
+						o->labelsize(LS);
+						o->align(FL_ALIGN_RIGHT); }
+						{ Fl_Box *o = uiArena.make<Fl_Box>(432, 223, 1, 1);
+						o->image(&button_04); }
+
+						/* Super Sonic */
+						{ Fl_Box *o = uiArena.make<Fl_Box>(452, 305, 1, 1, tr(UI_SUPER_SONIC));
+						o->labelsize(LS);
+						o->align(FL_ALIGN_RIGHT); }
+						{ Fl_Box *o = uiArena.make<Fl_Box>(432, 305, 1, 1);
+						o->image(&button_01); }
+
+						/* Jump / Back */
+						{ Fl_Box *o = uiArena.make<Fl_Box>(452, 387, 1, 1, labelJB);
+						o->labelsize(LS);
+						o->align(FL_ALIGN_RIGHT); }
+						{ Fl_Box *o = uiArena.make<Fl_Box>(432, 387, 1, 1);
+						o->image(&button_02); }
+
+						/* Start */
+						{ Fl_Box *o = uiArena.make<Fl_Box>(590, 305, 1, 1, tr(UI_START));
+						o->labelsize(LS);
+						o->align(FL_ALIGN_RIGHT); }
+						{ Fl_Box *o = uiArena.make<Fl_Box>(570, 305, 1, 1);
+						o->image(&button_05); }
+
+						/* Jump / Select */
+						{ Fl_Box *o = uiArena.make<Fl_Box>(590, 387, 1, 1, labelJS);
+						o->labelsize(LS);
+						o->align(FL_ALIGN_RIGHT); }
+						{ Fl_Box *o = uiArena.make<Fl_Box>(570, 387, 1, 1);
+						o->image(&button_03); }
+					}
+					layers[LAYER_KEYBOARD]->end();
+
 					/* Reset settings */
-					{ Fl_Button *o = new Fl_Button(42, 102, 328, 24, ui_ResetToDefault[lang]);
+					{ Fl_Button *o = uiArena.make<Fl_Button>(42, 102, 328, 24, tr(UI_RESET_TO_DEFAULT));
 					o->labelsize(LS);
 					o->clear_visible_focus();
 					o->callback(setDefaultKeys_cb); }
 
-					/* "Movement" frame */
-					{ Fl_Box *o = new Fl_Box(59, 192, 312, 277, ui_Movement[lang]);
-					o->labelsize(LS);
-					o->align(FL_ALIGN_TOP_LEFT);
-					o->box(FL_ENGRAVED_FRAME); }
-					
 					/* Up */
-					btUp = new kbButton(174, 241, 89, 38);
+					btUp = uiArena.make<kbButton>(174, 241, 89, 38);
 					btUp->config(config);
 					btUp->keytype(KEYUP);
 					btUp->callback(setKey_cb);
-					{ Fl_Box *o = new Fl_Box(174, 203, 89, 38, ui_Up[lang]);
-					o->labelsize(LS); }
-					{ Fl_Box *o = new Fl_Box(216, 299, 1, 1);
-					o->image(&arrow_04); }
 
 					/* Left */
-					btLeft = new kbButton(70, 311, 89, 38);
+					btLeft = uiArena.make<kbButton>(70, 311, 89, 38);
 					btLeft->config(config);
 					btLeft->keytype(KEYLEFT);
 					btLeft->callback(setKey_cb);
-					{ Fl_Box *o = new Fl_Box(70, 273, 89, 38, ui_Left[lang]);
-					o->labelsize(LS); }
-					{ Fl_Box *o = new Fl_Box(179, 330, 1, 1);
-					o->image(&arrow_01); }
 
 					/* Right */
-					btRight = new kbButton(274, 311, 89, 38);
+					btRight = uiArena.make<kbButton>(274, 311, 89, 38);
 					btRight->config(config);
 					btRight->keytype(KEYRIGHT);
 					btRight->callback(setKey_cb);
-					{ Fl_Box *o = new Fl_Box(274, 273, 89, 38, ui_Right[lang]);
-					o->labelsize(LS); }
-					{ Fl_Box *o = new Fl_Box(254, 330, 1, 1);
-					o->image(&arrow_02); }
 
 					/* Down */
-					btDown = new kbButton(174, 381, 89, 38);
+					btDown = uiArena.make<kbButton>(174, 381, 89, 38);
 					btDown->config(config);
 					btDown->keytype(KEYDOWN);
 					btDown->callback(setKey_cb);
-					{ Fl_Box *o = new Fl_Box(174, 423, 89, 38, ui_Down[lang]);
-					o->labelsize(LS); }
-					{ Fl_Box *o = new Fl_Box(216, 365, 1, 1);
-					o->image(&arrow_03); }
-
-					/* "Action" frame */
-					{ Fl_Box *o = new Fl_Box(407, 192, 294, 277, ui_Action[lang]);
-					o->labelsize(LS);
-					o->align(FL_ALIGN_TOP_LEFT);
-					o->box(FL_ENGRAVED_FRAME); }
 
 					/* Score Attack / Time Attack */
-					btX = new kbButton(432, 243, 89, 38);
+					btX = uiArena.make<kbButton>(432, 243, 89, 38);
 					btX->config(config);
 					btX->keytype(KEYX);
 					btX->callback(setKey_cb);
-					{ Fl_Box *o = new Fl_Box(452, 223, 1, 1, ui_ScoreAttack[lang]);
-					o->labelsize(LS);
-					o->align(FL_ALIGN_RIGHT); }
-					{ Fl_Box *o = new Fl_Box(432, 223, 1, 1);
-					o->image(&button_04); }
-					
+
 					/* Super Sonic */
-					btY = new kbButton(432, 329, 89, 38);
+					btY = uiArena.make<kbButton>(432, 329, 89, 38);
 					btY->config(config);
 					btY->keytype(KEYY);
 					btY->callback(setKey_cb);
-					{ Fl_Box *o = new Fl_Box(452, 305, 1, 1, ui_SuperSonic[lang]);
-					o->labelsize(LS);
-					o->align(FL_ALIGN_RIGHT); }
-					{ Fl_Box *o = new Fl_Box(432, 305, 1, 1);
-					o->image(&button_01); }
 
 					/* Jump / Back */
-					btB = new kbButton(432, 411, 89, 38);
+					btB = uiArena.make<kbButton>(432, 411, 89, 38);
 					btB->config(config);
 					btB->keytype(KEYB);
 					btB->callback(setKey_cb);
-					{ Fl_Box *o = new Fl_Box(452, 387, 1, 1, bufJB);
-					o->labelsize(LS);
-					o->align(FL_ALIGN_RIGHT); }
-					{ Fl_Box *o = new Fl_Box(432, 387, 1, 1);
-					o->image(&button_02); }
 
 					/* Start */
-					btStart = new kbButton(590, 329, 89, 38);
+					btStart = uiArena.make<kbButton>(590, 329, 89, 38);
 					btStart->config(config);
 					btStart->keytype(KEYSTART);
 					btStart->callback(setKey_cb);
-					{ Fl_Box *o = new Fl_Box(590, 305, 1, 1, ui_Start[lang]);
-					o->labelsize(LS);
-					o->align(FL_ALIGN_RIGHT); }
-					{ Fl_Box *o = new Fl_Box(570, 305, 1, 1);
-					o->image(&button_05); }
 
 					/* Jump / Select */
-					btA = new kbButton(590, 411, 89, 38);
+					btA = uiArena.make<kbButton>(590, 411, 89, 38);
 					btA->config(config);
 					btA->keytype(KEYA);
 					btA->callback(setKey_cb);
-					{ Fl_Box *o = new Fl_Box(590, 387, 1, 1, bufJS);
-					o->labelsize(LS);
-					o->align(FL_ALIGN_RIGHT); }
-					{ Fl_Box *o = new Fl_Box(570, 387, 1, 1);
-					o->image(&button_03); }
 				}
 				g2_keyboard->end();
 
 				/* Gamepad bindings */
-				g2_gamepad = new Fl_Group(32, 36, 698, 512);
+				g2_gamepad = uiArena.make<Fl_Group>(32, 36, 698, 512);
 				{
+					layers[LAYER_GAMEPAD] = uiArena.make<staticLayer>(0, 0, 762, 656);
+					{
+						/* Background image */
+						{ Fl_Box *o = uiArena.make<Fl_Box>(-1, 2, 1, 1);
+						o->align(FL_ALIGN_BOTTOM_LEFT);
+						o->image(&back2); }
+
+						/* Gamepad overlay image */
+						{ Fl_Box *o = uiArena.make<Fl_Box>(368, 298, 1, 1);
+						o->image(&pad_controls_v02); }
+
+						uiArena.make<PadBox>(144, 207, 18, tr(UI_BACK), FL_ALIGN_RIGHT);
+						uiArena.make<PadBox>(144, 240, 18, tr(UI_UP), FL_ALIGN_RIGHT);
+						uiArena.make<PadBox>(144, 268, 18, tr(UI_RIGHT), FL_ALIGN_RIGHT);
+						uiArena.make<PadBox>(144, 295, 18, tr(UI_LEFT), FL_ALIGN_RIGHT);
+						uiArena.make<PadBox>(144, 322, 18, tr(UI_DOWN), FL_ALIGN_RIGHT);
+						uiArena.make<PadBox>(542, 207, 18, tr(UI_START));
+						uiArena.make<PadBox>(542, 234, 18, tr(UI_SUPER_SONIC));
+						uiArena.make<PadBox>(542, 258, 18, tr(UI_SCORE_ATTACK));
+						uiArena.make<PadBox>(542, 302, 18, labelJB);
+						uiArena.make<PadBox>(542, 328, 18, labelJS);
+					}
+					layers[LAYER_GAMEPAD]->end();
+
 					/* Vibrate */
-					{ Fl_Check_Button *o = new Fl_Check_Button(42, 102, 328, 24, ui_Vibrate[lang]);
+					{ Fl_Check_Button *o = uiArena.make<Fl_Check_Button>(42, 102, 328, 24, tr(UI_VIBRATE));
 					o->labelsize(LS);
 					o->value(config->vibra() == 0 ? 0 : 1);
 					o->clear_visible_focus();
 					o->callback(vibrate_cb); }
 
-					/* Gamepad overlay image */
-					{ Fl_Box *o = new Fl_Box(368, 298, 1, 1);
-					o->image(&pad_controls_v02); }
-
-					new PadBox(144, 207, 18, ui_Back[lang], FL_ALIGN_RIGHT);
-					new PadBox(144, 240, 18, ui_Up[lang], FL_ALIGN_RIGHT);
-					new PadBox(144, 268, 18, ui_Right[lang], FL_ALIGN_RIGHT);
-					new PadBox(144, 295, 18, ui_Left[lang], FL_ALIGN_RIGHT);
-					new PadBox(144, 322, 18, ui_Down[lang], FL_ALIGN_RIGHT);
-					new PadBox(542, 207, 18, ui_Start[lang]);
-					new PadBox(542, 234, 18, ui_SuperSonic[lang]);
-					new PadBox(542, 258, 18, ui_ScoreAttack[lang]);
-					new PadBox(542, 302, 18, bufJB);
-					new PadBox(542, 328, 18, bufJS);
+					/* detected controller */
+					padBox = uiArena.make<Fl_Box>(42, 500, 678, 40);
+					padBox->align(FL_ALIGN_INSIDE|FL_ALIGN_TOP_LEFT|FL_ALIGN_WRAP);
+					padBox->labelsize(LS - 2);
+					show_gamepad_mapping();
+
+					/* live test, over the overlay image */
+					padView = uiArena.make<PadTestView>(193, 172, PAD_IMAGE_W, PAD_IMAGE_H + 24);
+					padView->labelsize(LS - 2);
 				}
 				g2_gamepad->end();
 
 				/* Select keyboard/controller */
-				{ MyChoice *o = new MyChoice(42, 64, 328, 24, ui_ControllerSelection[lang]);
+				{ MyChoice *o = uiArena.make<MyChoice>(42, 64, 328, 24, tr(UI_CONTROLLER_SELECTION));
 				o->menu(conItems);
 				o->value(config->controls());
-				o->callback(setController_cb, reinterpret_cast<void *>(bg));
+				o->callback(setController_cb);
 				/* Run callback once */
-				setController_cb(o, reinterpret_cast<void *>(bg)); }
+				setController_cb(o, NULL); }
 			}
 			g2->end();
 			g2->labelsize(LS);
@@ -1062,51 +1964,228 @@ static void startWindow(bool restart, int setX, int setY)
 		tabs->clear_visible_focus();
 
 		/* launch button */
-		bigButton = new Fl_Button(62, 564, 642, 68, ui_SaveSettings[lang]);
+		bigButton = uiArena.make<Fl_Button>(62, 564, 642, 68, tr(UI_SAVE_SETTINGS));
 		bigButton->labelsize(16);
 		bigButton->clear_visible_focus();
 		bigButton->callback(bigButton_cb);
 
-		{ Fl_Box *o = new Fl_Box(762, 641, 1, 1, "using FLTK " FLTK_VERSION_STRING);
+		{ Fl_Box *o = uiArena.make<Fl_Box>(762, 641, 1, 1, "using FLTK " FLTK_VERSION_STRING);
 		o->align(FL_ALIGN_LEFT_TOP);
 		o->labelsize(10);
 		o->deactivate(); }
 	}
 	win->end();
+	TRACE_END("buildWindow widgets");
+}
+
+/* scale the window for its screen and show it */
+static void showWindow(bool restart)
+{
+	/* the images must be complete before they are scaled or drawn */
+	futureImage::wait_all();
+
+	if (!restart) {
+		metrics::phaseImages.set(static_cast<int64_t>(metrics::uptime_us()));
+	}
+
+	/* scale of the screen the window is going to appear on */
+	if (restart) {
+		uiScale = screen_scale(winX + 762 * uiScale / 200, winY + 656 * uiScale / 200);
+	} else {
+		uiScale = screen_scale(Fl::x() + Fl::w() / 2, Fl::y() + Fl::h() / 2);
+	}
+	scaledImgs.retain(uiScale);
+
+	if (uiScale != 100) {
+		TRACE_SCOPE("scale window");
+		scale_widget(win, uiScale);
+
+		/* the window scales all of its children proportionally
+		 * while it is its own resizable */
+		win->resizable(win);
+		win->size(762 * uiScale / 100, 656 * uiScale / 100);
+		win->resizable(NULL);
+	}
+	TRACE_COUNTER("scaled image bytes", scaledImgs.bytes());
 
 	if (restart) {
 		/* window restarted, restore old positions */
-		win->position(setX, setY);
+		win->position(winX, winY);
 	} else {
 		/* new window, position in center */
-		win->position((Fl::w() - 762) / 2, (Fl::h() - 656) / 2);
+		win->position((Fl::w() - win->w()) / 2, (Fl::h() - win->h()) / 2);
+		TRACE_BEGIN("first show and paint");
 	}
 	win->show();
+	set_state(STATE_UI);
+	Fl::add_idle(ready_cb);
+}
 
-	Fl::run();
+/* views for -BenchExpose; they don't touch the configuration */
+static void view_settings(void)
+{
+	tabs->value(g1);
+}
 
-	delete[] devItems;
-	delete[] devLabels;
+static void view_keyboard(void)
+{
+	tabs->value(g2);
+	g2_keyboard->show();
+	g2_gamepad->hide();
+}
+
+static void view_gamepad(void)
+{
+	tabs->value(g2);
+	g2_keyboard->hide();
+	g2_gamepad->show();
+}
+
+static size_t cache_layers(bool on)
+{
+	size_t bytes = 0;
+
+	for (int i = 0; i < LAYERS; ++i) {
+		layers[i]->cache(on);
+		bytes += layers[i]->bytes();
+	}
+
+	return bytes;
+}
+
+/* -BenchRender hooks, see benchmark.hpp */
+static Fl_Window *bench_build(int n)
+{
+	/* the built-in languages only */
+	packs.select(-1, 0);
+	config->language(static_cast<uchar>(n));
+	buildWindow(true);
+	return win;
+}
+
+static void bench_draw(Fl_Window *)
+{
+	win->render();
+}
+
+/* -ReplayEvents hooks; every replay starts from the saved configuration */
+static Fl_Window *replay_build(int n)
+{
+	if (!config->loadConfig()) {
+		config->loadDefaultConfig();
+	}
+	return bench_build(n);
+}
+
+static const char *handler_name(Fl_Widget *o)
+{
+	if (dynamic_cast<kbButton *>(o)) {
+		return "kbButton";
+	} else if (dynamic_cast<MyChoice *>(o)) {
+		return "MyChoice";
+	} else if (dynamic_cast<PadBox *>(o)) {
+		return "PadBox";
+	} else if (dynamic_cast<MyWindow *>(o)) {
+		return "MyWindow";
+	}
+	return NULL;
+}
+
+/* destroy the window and all of its widgets at once */
+static void teardownWindow(void)
+{
+	win->hide();
+	win = NULL;
+	Fl::remove_timeout(rescale_cb);
+	tabs = NULL;
+	padtest_enable(false);
+	g1 = g2 = g2_keyboard = g2_gamepad = NULL;
+	padBox = NULL;
+	padView = NULL;
+	layers[LAYER_SETTINGS] = layers[LAYER_KEYBOARD] = layers[LAYER_GAMEPAD] = NULL;
+	btUp = btDown = btLeft = btRight = btA = btB = btX = btY = btStart = NULL;
+	uiArena.release();
 }
 
 int main(int argc, char *argv[])
 {
+	const char *exposeFile = NULL;
+	const char *renderFile = NULL;
+	const char *inputFile = NULL;
+	const char *inputHistFile = NULL;
+	const char *recordFile = NULL;
+	const char *replayFile = NULL;
+	const char *replayReport = NULL;
+
+	ALLOCPROF_BEGIN("startup");
+
+	/* before any window is created */
+	set_dpi_aware();
+
 	if (!getModuleRootDir()) {
 		MessageBoxA(0, "Failed calling GetModuleFileName()", "Error", MB_ICONERROR|MB_OK);
 		return 1;
 	}
 
+	/* only one launcher per installation */
+	inst = new instance(moduleRootDir);
+
+	if (!inst->acquire()) {
+		/* hand our arguments over to the running instance and quit */
+		std::string req = "args", resp;
+
+		for (int i = 1; i < argc; ++i) {
+			req += "\t";
+			req += argv[i];
+		}
+
+		bool forwarded = inst->request(req, resp);
+		delete inst;
+		return (forwarded && resp.compare(0, 2, "OK") == 0) ? 0 : 1;
+	}
+
+	/* decode the artwork while we start up, unless the game is launched
+	 * right away; a second launcher never gets here */
+	bool noUi = false;
+
+	for (int i = 1; i < argc; ++i) {
+		if (stricmp(argv[i], "-QuickBoot") == 0 || stricmp(argv[i], "-Supervisor") == 0) {
+			noUi = true;
+		}
+	}
+
+	if (!noUi) {
+#ifdef SL_PIXELCACHE
+		pixels.open();
+		futureImage::cache(&pixels);
+		scaledImgs.cache(&pixels);
+#endif
+		futureImage::decode_all(images, ARRLEN(images));
+	}
+
+	/* enables Fl::awake() for the control channel */
+	Fl::lock();
+	inst->listen(control_handler);
+	set_state(STATE_STARTING);
+
 	config = new configuration(confFile);
 
 	if (argc > 0) {
 		for (int i = 0; i < argc; ++i) {
-			if (stricmp(argv[i], "-QuickBoot") == 0) {
+			bool quickBoot = (stricmp(argv[i], "-QuickBoot") == 0);
+			bool supervisor = (stricmp(argv[i], "-Supervisor") == 0);
+
+			if (quickBoot || supervisor) {
 				if (!config->loadConfig()) {
 					config->loadDefaultConfig();
 					config->saveConfig();
 				}
 				delete config;
-				return launchGame();
+				ALLOCPROF_END("startup");
+				rv = supervisor ? superviseGame() : launchGame();
+				futureImage::wait_all();
+				delete inst;
+				return ALLOCPROF_EXIT(rv);
 			}
 		}
 	}
@@ -1115,10 +2194,124 @@ int main(int argc, char *argv[])
 
 	/* needs to be initialized before we launch our window */
 	directinput->init();
+	hotplugOn = hotplug.start(hotplug_cb, NULL);
+
+	Fl::add_handler(esc_handler);
+	Fl::add_handler(screen_handler);
+
+	if (getenv("SONICLAUNCHER_PAINT_STATS")) {
+		bool header = false;
+		FILE *fp = fopen(getenv("SONICLAUNCHER_PAINT_STATS"), "r");
+
+		if (fp) {
+			fclose(fp);
+		} else {
+			header = true;
+		}
+
+		if ((paintStats = fopen(getenv("SONICLAUNCHER_PAINT_STATS"), "a")) != NULL && header) {
+			fprintf(paintStats, "event\tpixels\tus\n");
+		}
+	}
 
-	startWindow(false, 0, 0);
+	/* lists the packs without opening them; only the saved selection is
+	 * mapped and indexed, the window needs its labels right away */
+	packs.discover(moduleRootDir);
+	packs.restoreSelection(langFile, UI_ROWS);
+
+	for (int i = 1; i < argc; ++i) {
+		if (stricmp(argv[i], "-BenchExpose") == 0) {
+			exposeFile = (i + 1 < argc) ? argv[i + 1] : "SonicLauncher.expose.tsv";
+		} else if (stricmp(argv[i], "-BenchRender") == 0) {
+			renderFile = (i + 1 < argc) ? argv[i + 1] : "SonicLauncher.render.tsv";
+		} else if (stricmp(argv[i], "-InputDiag") == 0) {
+			inputFile = (i + 1 < argc) ? argv[i + 1] : "SonicLauncher.input.tsv";
+			inputHistFile = (i + 2 < argc) ? argv[i + 2] : "SonicLauncher.input-hist.tsv";
+		} else if (stricmp(argv[i], "-RecordEvents") == 0) {
+			recordFile = (i + 1 < argc) ? argv[i + 1] : "SonicLauncher.events";
+		} else if (stricmp(argv[i], "-ReplayEvents") == 0) {
+			replayFile = (i + 1 < argc) ? argv[i + 1] : "SonicLauncher.events";
+			replayReport = (i + 2 < argc) ? argv[i + 2] : "SonicLauncher.replay.tsv";
+		} else if (stricmp(argv[i], "-PreSpawn") == 0) {
+			preSpawn = true;
+		}
+	}
+
+	const benchView_t views[] = {
+		{ "settings", view_settings },
+		{ "keyboard", view_keyboard },
+		{ "gamepad", view_gamepad }
+	};
+
+	if (inputFile) {
+		ALLOCPROF_END("startup");
+		rv = input_diagnostics(directinput, inputFile, inputHistFile) ? 0 : 1;
+	} else if (renderFile) {
+		const benchUi_t ui = { bench_build, bench_draw, teardownWindow };
+
+		ALLOCPROF_END("startup");
+		if (!config->loadConfig()) {
+			config->loadDefaultConfig();
+		}
+		rv = bench_render(&ui, langCodes, UI_LANGUAGES, views, ARRLEN(views), BENCH_RENDER_ITERATIONS, renderFile) ? 0 : 1;
+	} else if (replayFile) {
+		const eventlogUi_t ui = { replay_build, teardownWindow, handler_name };
+
+		ALLOCPROF_END("startup");
+		rv = eventlog_replay(&ui, replayFile, EVENTLOG_REPLAY_ITERATIONS, replayReport) ? 0 : 1;
+	} else if (exposeFile) {
+		ALLOCPROF_END("startup");
+		buildWindow(false);
+		showWindow(false);
+		Fl::check();
+		rv = bench_expose(win, views, ARRLEN(views), cache_layers, BENCH_EXPOSE_ITERATIONS, exposeFile) ? 0 : 1;
+		teardownWindow();
+	} else {
+		for (bool restart = false; ; restart = true) {
+			rebuildWindow = false;
+			buildWindow(restart);
+			showWindow(restart);
+			padtest_enable(config->controls() == GAMEPAD_CTRLS);
+
+			/* a rebuilt window has other widgets, so only the first one is recorded */
+			if (recordFile && !restart) {
+				eventlog_record(win, config->language());
+			}
+
+			Fl::run();
+
+			if (recordFile && !restart && !eventlog_stop(recordFile)) {
+				MessageBoxA(0, "Couldn't write the event log.", "Error", MB_ICONERROR|MB_OK);
+			}
+			teardownWindow();
+
+			if (!rebuildWindow) {
+				break;
+			}
+		}
+
+#ifdef SL_PIXELCACHE
+		/* variants added after the window became ready */
+		pixels.save();
+#endif
+
+		if (launchRequested) {
+			rv = launchGame();
+		} else {
+			/* quit without launching: drop the pre-spawned game */
+			uiGame.discard();
+		}
+	}
+
+	if (paintStats) {
+		fclose(paintStats);
+	}
 
+	/* the workers must be done before the images are destroyed */
+	futureImage::wait_all();
+	hotplug.stop();
 	delete directinput;
 	delete config;
-	return rv;
+	delete inst;
+	return ALLOCPROF_EXIT(rv);
 }
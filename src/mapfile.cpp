@@ -0,0 +1,122 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <limits.h>
+#include <stdlib.h>
+#endif
+
+#include "mapfile.hpp"
+
+
+bool mappedFile::open(const wchar_t *path, bool priv)
+{
+	close();
+
+#ifdef _WIN32
+	HANDLE file;
+	DWORD size;
+	void *view;
+
+	file = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	size = GetFileSize(file, NULL);
+	if (size == 0 || size == INVALID_FILE_SIZE) {
+		CloseHandle(file);
+		return false;
+	}
+
+	/* the mapping keeps its own reference to the file */
+	_map = CreateFileMappingW(file, NULL, priv ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(file);
+	if (!_map) {
+		return false;
+	}
+
+	if ((view = MapViewOfFile(_map, priv ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0)) == NULL) {
+		CloseHandle(_map);
+		_map = NULL;
+		return false;
+	}
+
+	_data = static_cast<char *>(view);
+	_size = size;
+#else
+	char mbs[PATH_MAX];
+	struct stat st;
+	void *view;
+	int fd;
+
+	if (wcstombs(mbs, path, sizeof(mbs)) == static_cast<size_t>(-1)) {
+		return false;
+	}
+
+	if ((fd = ::open(mbs, O_RDONLY)) == -1) {
+		return false;
+	}
+
+	if (fstat(fd, &st) == -1 || st.st_size == 0) {
+		::close(fd);
+		return false;
+	}
+
+	view = mmap(NULL, st.st_size, priv ? PROT_READ | PROT_WRITE : PROT_READ, priv ? MAP_PRIVATE : MAP_SHARED, fd, 0);
+	::close(fd);
+	if (view == MAP_FAILED) {
+		return false;
+	}
+
+	_data = static_cast<char *>(view);
+	_size = st.st_size;
+#endif
+
+	return true;
+}
+
+void mappedFile::close()
+{
+	if (!_data) {
+		return;
+	}
+
+#ifdef _WIN32
+	UnmapViewOfFile(_data);
+	CloseHandle(_map);
+	_map = NULL;
+#else
+	munmap(_data, _size);
+#endif
+
+	_data = NULL;
+	_size = 0;
+}
@@ -0,0 +1,59 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef MAPFILE_HPP
+#define MAPFILE_HPP
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <stddef.h>
+
+
+/* a whole file mapped into memory */
+class mappedFile
+{
+private:
+#ifdef _WIN32
+	HANDLE _map = NULL;
+#endif
+	char *_data = NULL;
+	size_t _size = 0;
+
+public:
+	mappedFile() {}
+	mappedFile(const mappedFile &) = delete;
+	mappedFile &operator=(const mappedFile &) = delete;
+	~mappedFile() { close(); }
+
+	/* a private mapping is copy-on-write: written pages are copied
+	 * and the changes never reach the file */
+	bool open(const wchar_t *path, bool priv);
+	void close();
+
+	char *data() { return _data; }
+	size_t size() { return _size; }
+};
+
+#endif  /* MAPFILE_HPP */
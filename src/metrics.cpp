@@ -0,0 +1,312 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include <string>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "clock.hpp"
+#include "metrics.hpp"
+
+
+namespace metrics
+{
+	/* the list only grows during static initialization */
+	static metric *first = NULL;
+	static metric **last = &first;
+
+	static const uint64_t started = clock_us();
+
+	/* v / scale, exact for microseconds */
+	static void append_value(std::string &out, int64_t v, uint64_t scale)
+	{
+		char buf[48];
+
+		if (scale == 1) {
+			snprintf(buf, sizeof(buf), "%lld", static_cast<long long>(v));
+		} else {
+			uint64_t a = static_cast<uint64_t>(v < 0 ? -v : v);
+			snprintf(buf, sizeof(buf), "%s%llu.%06llu", v < 0 ? "-" : "",
+				static_cast<unsigned long long>(a / scale),
+				static_cast<unsigned long long>(a % scale * 1000000 / scale));
+		}
+		out += buf;
+	}
+
+	/* name{labels,extra} */
+	static void append_series(std::string &out, const char *name, const char *suffix,
+		const char *labels, const char *extra)
+	{
+		out += METRICS_PREFIX;
+		out += name;
+		out += suffix;
+
+		if (*labels || *extra) {
+			out += '{';
+			out += labels;
+			if (*labels && *extra) {
+				out += ',';
+			}
+			out += extra;
+			out += '}';
+		}
+		out += ' ';
+	}
+
+	metric::metric(const char *name, const char *type, const char *unit, const char *help,
+		const char *labels, uint64_t scale)
+		: _name(name), _type(type), _unit(unit), _help(help), _labels(labels), _scale(scale)
+	{
+		*last = this;
+		last = &_next;
+	}
+
+	void counter::samples(std::string &out) const
+	{
+		append_series(out, _name, "_total", _labels, "");
+		append_value(out, static_cast<int64_t>(value()), _scale);
+		out += '\n';
+	}
+
+	void gauge::samples(std::string &out) const
+	{
+		append_series(out, _name, "", _labels, "");
+		append_value(out, value(), _scale);
+		out += '\n';
+	}
+
+	histogram::histogram(const char *name, const char *unit, const char *help, const uint64_t *bounds, int n,
+		const char *labels, uint64_t scale)
+		: metric(name, "histogram", unit, help, labels, scale), _bounds(bounds), _n(n < METRICS_MAX_BUCKETS ? n : METRICS_MAX_BUCKETS)
+	{
+		for (int i = 0; i <= METRICS_MAX_BUCKETS; ++i) {
+			_buckets[i].store(0, std::memory_order_relaxed);
+		}
+	}
+
+	void histogram::observe(uint64_t v)
+	{
+		int i = 0;
+
+		while (i < _n && v > _bounds[i]) {
+			++i;
+		}
+		_buckets[i].fetch_add(1, std::memory_order_relaxed);
+		_sum.fetch_add(v, std::memory_order_relaxed);
+	}
+
+	uint64_t histogram::count() const
+	{
+		uint64_t n = 0;
+
+		for (int i = 0; i <= _n; ++i) {
+			n += _buckets[i].load(std::memory_order_relaxed);
+		}
+		return n;
+	}
+
+	void histogram::samples(std::string &out) const
+	{
+		uint64_t n = 0;
+		std::string le;
+
+		/* the buckets are cumulative */
+		for (int i = 0; i <= _n; ++i) {
+			n += _buckets[i].load(std::memory_order_relaxed);
+			le = "le=\"";
+			if (i < _n) {
+				append_value(le, static_cast<int64_t>(_bounds[i]), _scale);
+			} else {
+				le += "+Inf";
+			}
+			le += '"';
+			append_series(out, _name, "_bucket", _labels, le.c_str());
+			append_value(out, static_cast<int64_t>(n), 1);
+			out += '\n';
+		}
+
+		append_series(out, _name, "_count", _labels, "");
+		append_value(out, static_cast<int64_t>(n), 1);
+		out += '\n';
+		append_series(out, _name, "_sum", _labels, "");
+		append_value(out, static_cast<int64_t>(_sum.load(std::memory_order_relaxed)), _scale);
+		out += '\n';
+	}
+
+	void text(std::string &out)
+	{
+		const char *family = NULL;
+
+		for (const metric *m = first; m; m = m->_next) {
+			/* one set of metadata per family */
+			if (!family || strcmp(family, m->_name) != 0) {
+				family = m->_name;
+
+				out += "# TYPE " METRICS_PREFIX;
+				out += m->_name;
+				out += ' ';
+				out += m->_type;
+				out += '\n';
+
+				if (m->_unit) {
+					out += "# UNIT " METRICS_PREFIX;
+					out += m->_name;
+					out += ' ';
+					out += m->_unit;
+					out += '\n';
+				}
+
+				out += "# HELP " METRICS_PREFIX;
+				out += m->_name;
+				out += ' ';
+				out += m->_help;
+				out += '\n';
+			}
+			m->samples(out);
+		}
+
+		out += "# EOF\n";
+	}
+
+	bool write(const char *path)
+	{
+		std::string s, tmp;
+		FILE *fp;
+		bool ok;
+
+		if (!path) {
+			path = getenv("SONICLAUNCHER_METRICS");
+		}
+		if (!path || !*path) {
+			return true;
+		}
+
+		text(s);
+		tmp = std::string(path) + ".tmp";
+
+		if ((fp = fopen(tmp.c_str(), "wb")) == NULL) {
+			return false;
+		}
+		ok = fwrite(s.data(), 1, s.size(), fp) == s.size();
+
+		if (fclose(fp) != 0 || !ok) {
+			remove(tmp.c_str());
+			return false;
+		}
+
+#ifdef _WIN32
+		ok = MoveFileExA(tmp.c_str(), path, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+		ok = rename(tmp.c_str(), path) == 0;
+#endif
+		if (!ok) {
+			remove(tmp.c_str());
+		}
+		return ok;
+	}
+
+	uint64_t uptime_us()
+	{
+		return clock_us() - started;
+	}
+
+	uint64_t page_faults()
+	{
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS pmc;
+
+		pmc.cb = sizeof(pmc);
+		if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) {
+			return 0;
+		}
+		/* soft and hard faults */
+		return pmc.PageFaultCount;
+#else
+		struct rusage ru;
+
+		if (getrusage(RUSAGE_SELF, &ru) != 0) {
+			return 0;
+		}
+		return static_cast<uint64_t>(ru.ru_minflt) + ru.ru_majflt;
+#endif
+	}
+
+	gauge phaseImages("startup_phase_seconds", "seconds", "Time from process start to a startup phase.",
+		"phase=\"images\"", METRICS_US);
+	gauge phaseFirstPaint("startup_phase_seconds", "seconds", "Time from process start to a startup phase.",
+		"phase=\"first_paint\"", METRICS_US);
+	gauge phaseReady("startup_phase_seconds", "seconds", "Time from process start to a startup phase.",
+		"phase=\"ready\"", METRICS_US);
+	gauge startupFaults("startup_page_faults", NULL, "Page faults until the window was ready.");
+
+	gauge stateStarting("state", NULL, "Current launcher state.", "state=\"starting\"");
+	gauge stateUi("state", NULL, "Current launcher state.", "state=\"ui\"");
+	gauge stateGame("state", NULL, "Current launcher state.", "state=\"game\"");
+
+	counter configLoadOk("config_loads", "Configuration loads.", "result=\"ok\"");
+	counter configLoadMissing("config_loads", "Configuration loads.", "result=\"missing\"");
+	counter configLoadInvalid("config_loads", "Configuration loads.", "result=\"invalid\"");
+	counter configSaveOk("config_saves", "Configuration saves.", "result=\"ok\"");
+	counter configSaveError("config_saves", "Configuration saves.", "result=\"error\"");
+
+	counter keyCaptureChanged("key_captures", "Keys captured for a binding.", "result=\"changed\"");
+	counter keyCaptureUnchanged("key_captures", "Keys captured for a binding.", "result=\"unchanged\"");
+	counter keyCaptureDuplicate("key_captures", "Keys captured for a binding.", "result=\"duplicate\"");
+
+	counter launchOk("game_launches", "Game process starts.", "result=\"ok\"");
+	counter launchError("game_launches", "Game process starts.", "result=\"error\"");
+
+	counter exitClean("game_exits", "Game exits by exit code.", "result=\"clean\"");
+	counter exitError("game_exits", "Game exits by exit code.", "result=\"error\"");
+	counter exitCrash("game_exits", "Game exits by exit code.", "result=\"crash\"");
+	gauge lastExitCode("game_last_exit_code", NULL, "Exit code of the last game process.");
+
+	/* 10 s to 4 h */
+	static const uint64_t sessionBounds[] = {
+		10 * METRICS_US, 60 * METRICS_US, 300 * METRICS_US, 900 * METRICS_US, 1800 * METRICS_US,
+		3600ULL * METRICS_US, 7200ULL * METRICS_US, 14400ULL * METRICS_US
+	};
+	histogram session("game_session_seconds", "seconds", "How long the game ran.",
+		sessionBounds, sizeof(sessionBounds) / sizeof(*sessionBounds), "", METRICS_US);
+
+	/* 1 ms to 1 s */
+	static const uint64_t launchBounds[] = {
+		1000, 2000, 5000, 10000, 20000, 50000, 100000, 200000, 500000, 1000000
+	};
+	histogram launchSpawn("launch_latency_seconds", "seconds",
+		"From the launch button to the game's first instruction.",
+		launchBounds, sizeof(launchBounds) / sizeof(*launchBounds), "mode=\"spawn\"", METRICS_US);
+	histogram launchPrespawn("launch_latency_seconds", "seconds",
+		"From the launch button to the game's first instruction.",
+		launchBounds, sizeof(launchBounds) / sizeof(*launchBounds), "mode=\"prespawn\"", METRICS_US);
+}
@@ -0,0 +1,164 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Launcher metrics for fleet monitoring, always compiled in. Counters,
+ * gauges and histograms are atomics updated with relaxed ordering, a few
+ * ns per event, so they can sit on the UI and control paths.
+ *
+ * All metrics are defined in metrics.cpp, series of the same family next
+ * to each other. metrics::text() formats them in the OpenMetrics text
+ * format; metrics::write() replaces the file named in
+ * $SONICLAUNCHER_METRICS with it (for a node exporter's textfile
+ * collector), and the "metrics" control request returns it. Times are
+ * kept in microseconds and exported in seconds. */
+
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <atomic>
+#include <string>
+#include <stdint.h>
+
+#define METRICS_PREFIX        "sonic_launcher_"
+#define METRICS_MAX_BUCKETS   12
+#define METRICS_US            1000000  /* scale of the time metrics */
+
+
+namespace metrics
+{
+	class metric
+	{
+	private:
+		metric *_next = NULL;
+
+	protected:
+		const char *_name;    /* family, without prefix and _total */
+		const char *_type;
+		const char *_unit;    /* or NULL */
+		const char *_help;
+		const char *_labels;  /* `name="value",...' or "" */
+		uint64_t _scale;
+
+		virtual void samples(std::string &out) const = 0;
+
+	public:
+		metric(const char *name, const char *type, const char *unit, const char *help,
+			const char *labels, uint64_t scale);
+		metric(const metric &) = delete;
+		metric &operator=(const metric &) = delete;
+
+		friend void text(std::string &out);
+	};
+
+	class counter : public metric
+	{
+	private:
+		std::atomic<uint64_t> _v{0};
+
+		void samples(std::string &out) const;
+
+	public:
+		counter(const char *name, const char *help, const char *labels = "")
+			: metric(name, "counter", NULL, help, labels, 1) {}
+
+		void inc(uint64_t n = 1) { _v.fetch_add(n, std::memory_order_relaxed); }
+		uint64_t value() const { return _v.load(std::memory_order_relaxed); }
+	};
+
+	class gauge : public metric
+	{
+	private:
+		std::atomic<int64_t> _v{0};
+
+		void samples(std::string &out) const;
+
+	public:
+		gauge(const char *name, const char *unit, const char *help, const char *labels = "", uint64_t scale = 1)
+			: metric(name, "gauge", unit, help, labels, scale) {}
+
+		void set(int64_t v) { _v.store(v, std::memory_order_relaxed); }
+		int64_t value() const { return _v.load(std::memory_order_relaxed); }
+	};
+
+	/* bounds ascending, in the unscaled unit; +Inf is implied */
+	class histogram : public metric
+	{
+	private:
+		const uint64_t *_bounds;
+		int _n;
+		std::atomic<uint64_t> _buckets[METRICS_MAX_BUCKETS + 1];
+		std::atomic<uint64_t> _sum{0};
+
+		void samples(std::string &out) const;
+
+	public:
+		histogram(const char *name, const char *unit, const char *help, const uint64_t *bounds, int n,
+			const char *labels = "", uint64_t scale = 1);
+
+		void observe(uint64_t v);
+		uint64_t count() const;
+	};
+
+	/* all metrics in the OpenMetrics text format, "# EOF" included */
+	void text(std::string &out);
+
+	/* write text() to path, or to $SONICLAUNCHER_METRICS if path is NULL;
+	 * true if there is nowhere to write to. The file is replaced, so a
+	 * reader never sees half of it. */
+	bool write(const char *path = NULL);
+
+	/* since the process started */
+	uint64_t uptime_us();
+
+	/* of this process so far */
+	uint64_t page_faults();
+
+	/* startup, in seconds since the process started */
+	extern gauge phaseImages, phaseFirstPaint, phaseReady;
+	extern gauge startupFaults;
+
+	/* launcher state, 1 for the current one */
+	extern gauge stateStarting, stateUi, stateGame;
+
+	extern counter configLoadOk, configLoadMissing, configLoadInvalid;
+	extern counter configSaveOk, configSaveError;
+
+	/* keyboard bindings picked on the keyboard page */
+	extern counter keyCaptureChanged, keyCaptureUnchanged, keyCaptureDuplicate;
+
+	extern counter launchOk, launchError;
+
+	/* exit codes 0, others, and NTSTATUS errors (0xC0000000 and up) */
+	extern counter exitClean, exitError, exitCrash;
+	extern gauge lastExitCode;
+
+	/* how long the game ran */
+	extern histogram session;
+
+	/* launch button to the game's first instruction, with the game created
+	 * on the click or pre-spawned (-PreSpawn) */
+	extern histogram launchSpawn, launchPrespawn;
+}
+
+#endif  /* METRICS_HPP */
@@ -0,0 +1,194 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <windows.h>
+#include <mmsystem.h>
+
+#include <string.h>
+
+#include "clock.hpp"
+#include "padtest.hpp"
+
+static BOOL CALLBACK first_gamepad(LPCDIDEVICEINSTANCE inst, LPVOID ctx)
+{
+	*reinterpret_cast<GUID *>(ctx) = inst->guidInstance;
+	return DIENUM_STOP;
+}
+
+bool padPoller::start(IDirectInput8 *dinput)
+{
+	GUID guid = GUID_NULL;
+	DIPROPRANGE range;
+
+	if (_dev || !dinput) {
+		return false;
+	}
+
+	dinput->EnumDevices(DI8DEVCLASS_GAMECTRL, first_gamepad, &guid, DIEDFL_ATTACHEDONLY);
+
+	if (guid == GUID_NULL || dinput->CreateDevice(guid, &_dev, NULL) != DI_OK) {
+		_dev = NULL;
+		return false;
+	}
+
+	range.diph.dwSize = sizeof(DIPROPRANGE);
+	range.diph.dwHeaderSize = sizeof(DIPROPHEADER);
+	range.diph.dwObj = 0;
+	range.diph.dwHow = DIPH_DEVICE;
+	range.lMin = -PADTEST_AXIS_RANGE;
+	range.lMax = PADTEST_AXIS_RANGE;
+
+	if (_dev->SetDataFormat(&c_dfDIJoystick2) != DI_OK) {
+		_dev->Release();
+		_dev = NULL;
+		return false;
+	}
+
+	/* not every axis accepts a range, the others keep their own */
+	_dev->SetProperty(DIPROP_RANGE, &range.diph);
+
+	/* must be set while the device isn't acquired */
+	_notify = CreateEventW(NULL, FALSE, FALSE, NULL);
+	if (_notify && _dev->SetEventNotification(_notify) != DI_OK) {
+		CloseHandle(_notify);
+		_notify = NULL;
+	}
+
+	_dev->Acquire();
+
+	_ring.clear();
+	_dropped.store(0);
+	_stop.store(false);
+
+	/* so a polled device gets read every PADTEST_POLL_MS */
+	timeBeginPeriod(1);
+
+	if (!_thread.start(pollThread, this)) {
+		stop();
+		return false;
+	}
+
+	return true;
+}
+
+void padPoller::stop()
+{
+	if (!_dev) {
+		return;
+	}
+
+	_stop.store(true);
+	if (_notify) {
+		SetEvent(_notify);
+	}
+	_thread.join();
+	timeEndPeriod(1);
+
+	_dev->Unacquire();
+	_dev->SetEventNotification(NULL);
+	_dev->Release();
+	_dev = NULL;
+
+	if (_notify) {
+		CloseHandle(_notify);
+		_notify = NULL;
+	}
+}
+
+bool padPoller::read(padSample_t &s)
+{
+	DIJOYSTATE2 js;
+	HRESULT res;
+
+	_dev->Poll();
+	res = _dev->GetDeviceState(sizeof(js), &js);
+
+	if (res == DIERR_INPUTLOST || res == DIERR_NOTACQUIRED) {
+		_dev->Acquire();
+		return false;
+	} else if (res != DI_OK) {
+		return false;
+	}
+
+	s.t = clock_us();
+	s.lx = js.lX;
+	s.ly = js.lY;
+	s.rx = js.lRx;
+	s.ry = js.lRy;
+	s.buttons = 0;
+	s.pov = LOWORD(js.rgdwPOV[0]);
+
+	for (int i = 0; i < 32; ++i) {
+		if (js.rgbButtons[i] & 0x80) {
+			s.buttons |= 1u << i;
+		}
+	}
+
+	return true;
+}
+
+void padPoller::run()
+{
+	padSample_t last, s;
+	bool pending = false;
+
+	memset(&last, 0, sizeof(last));
+	last.pov = 0xFFFF;
+
+	while (!_stop.load()) {
+		bool notified = _notify && WaitForSingleObject(_notify, PADTEST_POLL_MS) == WAIT_OBJECT_0;
+
+		if (!_notify) {
+			Sleep(PADTEST_POLL_MS);
+		}
+
+		if (_stop.load()) {
+			break;
+		}
+
+		if (read(s)) {
+			/* a notification is a device report even if nothing we show
+			 * changed; when polling, only changes count */
+			bool changed = (s.lx != last.lx || s.ly != last.ly || s.rx != last.rx || s.ry != last.ry ||
+				s.buttons != last.buttons || s.pov != last.pov);
+
+			if (notified || changed) {
+				if (pending) {
+					_dropped++;
+				}
+				last = s;
+				pending = true;
+			}
+		}
+
+		if (pending && _ring.push(last)) {
+			pending = false;
+		}
+	}
+}
+
+void padPoller::pollThread(void *p)
+{
+	reinterpret_cast<padPoller *>(p)->run();
+}
@@ -0,0 +1,88 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Live controller test for the gamepad view. A thread reads the first
+ * attached game controller as fast as the device reports: it sleeps on
+ * DirectInput's event notification and, for devices that need polling,
+ * wakes up at least every PADTEST_POLL_MS. Each new state goes into an
+ * spscRing that the FLTK thread drains once per frame, so the UI never
+ * waits for the device and the device never waits for a repaint.
+ *
+ * If the ring is full, the newest state is held back and pushed as soon
+ * as there is room again; states replaced in the meantime count as
+ * dropped. */
+
+#ifndef PADTEST_HPP
+#define PADTEST_HPP
+
+#include <atomic>
+#include <stdint.h>
+
+#include "input.hpp"
+#include "spscring.hpp"
+#include "threads.hpp"
+
+#define PADTEST_POLL_MS     4
+#define PADTEST_RING        256
+#define PADTEST_AXIS_RANGE  1000  /* axes report -PADTEST_AXIS_RANGE..PADTEST_AXIS_RANGE */
+
+
+typedef struct {
+	uint64_t t;  /* clock_us() when the state was read */
+	int32_t lx, ly, rx, ry;
+	uint32_t buttons;  /* bit n: button n is down */
+	uint32_t pov;  /* hundredths of a degree clockwise from up, 0xFFFF if centered */
+} padSample_t;
+
+class padPoller
+{
+private:
+	spscRing<padSample_t, PADTEST_RING> _ring;
+	IDirectInputDevice8 *_dev = NULL;
+	HANDLE _notify = NULL;
+	std::atomic<bool> _stop{false};
+	std::atomic<unsigned long> _dropped{0};
+	thread _thread;
+
+	static void pollThread(void *p);
+	void run();
+	bool read(padSample_t &s);
+
+public:
+	~padPoller() { stop(); }
+
+	/* open the first attached controller and start reading it; false if
+	 * there is none */
+	bool start(IDirectInput8 *dinput);
+	void stop();
+	bool running() const { return _dev != NULL; }
+
+	/* FLTK thread only */
+	bool pop(padSample_t &s) { return _ring.pop(s); }
+	size_t depth() const { return _ring.size(); }
+	static constexpr size_t capacity() { return PADTEST_RING; }
+	unsigned long dropped() const { return _dropped.load(); }
+};
+
+#endif  /* PADTEST_HPP */
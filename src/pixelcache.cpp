@@ -0,0 +1,365 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef _WIN32
+#include <windows.h>
+#include <shlobj.h>
+#else
+#include <sys/stat.h>
+#include <limits.h>
+#include <stdlib.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <wchar.h>
+
+#include "pixelcache.hpp"
+#include "trace.hpp"
+
+enum { ENTRY_UNCHECKED, ENTRY_GOOD, ENTRY_BAD };
+
+
+uint64_t pixelcache_hash(const void *data, size_t size)
+{
+	const unsigned char *p = static_cast<const unsigned char *>(data);
+	uint64_t h = 0x9E3779B97F4A7C15ULL ^ size;
+	uint64_t v;
+
+	for ( ; size >= 8; p += 8, size -= 8) {
+		memcpy(&v, p, 8);
+		h = (h ^ v) * 0xFF51AFD7ED558CCDULL;
+		h ^= h >> 32;
+	}
+
+	for ( ; size > 0; ++p, --size) {
+		h = (h ^ *p) * 0xC4CEB9FE1A85EC53ULL;
+	}
+
+	h ^= h >> 33;
+	h *= 0xFF51AFD7ED558CCDULL;
+	h ^= h >> 33;
+
+	return h;
+}
+
+#ifdef _WIN32
+static bool default_path(std::wstring &path)
+{
+	wchar_t dir[MAX_PATH];
+
+	if (SHGetFolderPathW(NULL, CSIDL_LOCAL_APPDATA, NULL, 0, dir) != S_OK) {
+		return false;
+	}
+
+	path = dir;
+	path += L"\\" PIXELCACHE_DIR;
+	CreateDirectoryW(path.c_str(), NULL);
+	path += L"\\" PIXELCACHE_FILE;
+
+	return true;
+}
+
+static bool replace_file(const wchar_t *from, const wchar_t *to)
+{
+	return MoveFileExW(from, to, MOVEFILE_REPLACE_EXISTING) != 0;
+}
+
+static FILE *create_file(const wchar_t *path)
+{
+	FILE *fp = NULL;
+	return (_wfopen_s(&fp, path, L"wb") == 0) ? fp : NULL;
+}
+#else
+static bool default_path(std::wstring &path)
+{
+	const char *xdg = getenv("XDG_CACHE_HOME");
+	const char *home = getenv("HOME");
+	std::string dir;
+	wchar_t wcs[PATH_MAX];
+
+	if (xdg && *xdg) {
+		dir = xdg;
+	} else if (home && *home) {
+		dir = std::string(home) + "/.cache";
+		mkdir(dir.c_str(), 0755);
+	} else {
+		return false;
+	}
+
+	dir += "/SonicLauncher";
+	mkdir(dir.c_str(), 0755);
+	dir += "/pixels.cache";
+
+	if (mbstowcs(wcs, dir.c_str(), PATH_MAX) == static_cast<size_t>(-1)) {
+		return false;
+	}
+	path = wcs;
+
+	return true;
+}
+
+static bool to_mbs(const wchar_t *path, char *mbs)
+{
+	return wcstombs(mbs, path, PATH_MAX) != static_cast<size_t>(-1);
+}
+
+static bool replace_file(const wchar_t *from, const wchar_t *to)
+{
+	char a[PATH_MAX], b[PATH_MAX];
+	return to_mbs(from, a) && to_mbs(to, b) && rename(a, b) == 0;
+}
+
+static FILE *create_file(const wchar_t *path)
+{
+	char mbs[PATH_MAX];
+	return to_mbs(path, mbs) ? fopen(mbs, "wb") : NULL;
+}
+#endif
+
+bool pixelCache::open(const wchar_t *path)
+{
+	TRACE_SCOPE("pixelCache::open");
+
+	const char *env = getenv("SONICLAUNCHER_PIXEL_CACHE");
+	const header_t *hdr;
+
+	close();
+
+	if (path) {
+		_path = path;
+	} else if (env && *env) {
+		wchar_t wcs[1024];
+
+		if (mbstowcs(wcs, env, sizeof(wcs) / sizeof(*wcs)) == static_cast<size_t>(-1)) {
+			return false;
+		}
+		_path = wcs;
+	} else if (!default_path(_path)) {
+		return false;
+	}
+
+	/* written by the last run */
+	replace_file((_path + PIXELCACHE_NEW).c_str(), _path.c_str());
+
+	if (!_map.open(_path.c_str(), false) || _map.size() < sizeof(header_t)) {
+		_map.close();
+		return false;
+	}
+
+	hdr = reinterpret_cast<const header_t *>(_map.data());
+
+	if (memcmp(hdr->magic, PIXELCACHE_MAGIC, 4) != 0 || hdr->version != PIXELCACHE_VERSION ||
+		hdr->size != _map.size() || hdr->count > (_map.size() - sizeof(header_t)) / sizeof(entry_t) ||
+		pixelcache_hash(hdr + 1, hdr->count * sizeof(entry_t)) != hdr->checksum)
+	{
+		/* not ours, truncated or damaged: rewrite it */
+		_map.close();
+		return false;
+	}
+
+	_entries = reinterpret_cast<const entry_t *>(hdr + 1);
+	_count = hdr->count;
+	_state.assign(_count, ENTRY_UNCHECKED);
+	_used.assign(_count, false);
+
+	return true;
+}
+
+void pixelCache::close()
+{
+	_map.close();
+	_entries = NULL;
+	_count = 0;
+	_state.clear();
+	_used.clear();
+	_added.clear();
+	_saved = 0;
+}
+
+/* bounds and pixel checksum of entry i, once */
+bool pixelCache::verify(uint32_t i)
+{
+	const entry_t *e = _entries + i;
+
+	if (_state[i] == ENTRY_UNCHECKED) {
+		uint64_t expected = static_cast<uint64_t>(e->w) * e->h * e->d;
+
+		if (e->format != PIXELCACHE_RGB8 || e->d < 1 || e->d > 4 || e->size != expected ||
+			e->offset % PIXELCACHE_ALIGN != 0 || e->offset > _map.size() || e->size > _map.size() - e->offset ||
+			pixelcache_hash(_map.data() + e->offset, e->size) != e->checksum)
+		{
+			_state[i] = ENTRY_BAD;
+		} else {
+			_state[i] = ENTRY_GOOD;
+		}
+	}
+
+	return _state[i] == ENTRY_GOOD;
+}
+
+bool pixelCache::find(uint64_t hash, int scale, const unsigned char **pixels, int *w, int *h, int *d)
+{
+	for (uint32_t i = 0; i < _count; ++i) {
+		const entry_t *e = _entries + i;
+
+		if (e->hash != hash || e->scale != static_cast<uint32_t>(scale) || e->format != PIXELCACHE_RGB8) {
+			continue;
+		}
+
+		/* the workers look up different images, so this rarely waits */
+		_lock.lock();
+		bool good = verify(i);
+		if (good) {
+			_used[i] = true;
+		}
+		_lock.unlock();
+
+		if (!good) {
+			break;
+		}
+
+		*pixels = reinterpret_cast<const unsigned char *>(_map.data() + e->offset);
+		*w = static_cast<int>(e->w);
+		*h = static_cast<int>(e->h);
+		*d = static_cast<int>(e->d);
+		_hits++;
+		return true;
+	}
+
+	_misses++;
+	return false;
+}
+
+void pixelCache::add(uint64_t hash, int scale, const unsigned char *pixels, int w, int h, int d)
+{
+	added_t a;
+
+	if (!pixels || w < 1 || h < 1 || d < 1 || d > 4) {
+		return;
+	}
+
+	a.hash = hash;
+	a.scale = static_cast<uint32_t>(scale);
+	a.w = w;
+	a.h = h;
+	a.d = d;
+	a.pixels.assign(pixels, pixels + static_cast<size_t>(w) * h * d);
+
+	_lock.lock();
+	_added.push_back(std::move(a));
+	_lock.unlock();
+}
+
+bool pixelCache::save()
+{
+	TRACE_SCOPE("pixelCache::save");
+
+	_lock.lock();
+	bool ok = write();
+	_lock.unlock();
+
+	return ok;
+}
+
+/* everything used and added to path.new; with the lock held */
+bool pixelCache::write()
+{
+	std::vector<entry_t> entries;
+	std::vector<const unsigned char *> data;
+	static const char zeros[PIXELCACHE_ALIGN] = { 0 };
+	header_t hdr;
+	uint64_t offset;
+	FILE *fp;
+	bool ok;
+
+	if (_added.size() == _saved || _path.empty()) {
+		return true;
+	}
+
+	for (uint32_t i = 0; i < _count; ++i) {
+		if (_used[i]) {
+			entries.push_back(_entries[i]);
+			data.push_back(reinterpret_cast<const unsigned char *>(_map.data() + _entries[i].offset));
+		}
+	}
+
+	for (size_t i = 0; i < _added.size(); ++i) {
+		const added_t *a = &_added[i];
+		entry_t e;
+
+		memset(&e, 0, sizeof(e));
+		e.hash = a->hash;
+		e.scale = a->scale;
+		e.format = PIXELCACHE_RGB8;
+		e.w = static_cast<uint32_t>(a->w);
+		e.h = static_cast<uint32_t>(a->h);
+		e.d = static_cast<uint32_t>(a->d);
+		e.size = a->pixels.size();
+		e.checksum = pixelcache_hash(a->pixels.data(), a->pixels.size());
+		entries.push_back(e);
+		data.push_back(a->pixels.data());
+	}
+
+	/* the pixels start on aligned offsets after the table */
+	offset = sizeof(header_t) + entries.size() * sizeof(entry_t);
+
+	for (size_t i = 0; i < entries.size(); ++i) {
+		offset = (offset + PIXELCACHE_ALIGN - 1) / PIXELCACHE_ALIGN * PIXELCACHE_ALIGN;
+		entries[i].offset = offset;
+		offset += entries[i].size;
+	}
+
+	memset(&hdr, 0, sizeof(hdr));
+	memcpy(hdr.magic, PIXELCACHE_MAGIC, 4);
+	hdr.version = PIXELCACHE_VERSION;
+	hdr.count = static_cast<uint32_t>(entries.size());
+	hdr.size = offset;
+	hdr.checksum = pixelcache_hash(entries.data(), entries.size() * sizeof(entry_t));
+
+	if ((fp = create_file((_path + PIXELCACHE_NEW).c_str())) == NULL) {
+		return false;
+	}
+
+	ok = fwrite(&hdr, sizeof(hdr), 1, fp) == 1 &&
+		fwrite(entries.data(), sizeof(entry_t), entries.size(), fp) == entries.size();
+	offset = sizeof(header_t) + entries.size() * sizeof(entry_t);
+
+	for (size_t i = 0; i < entries.size() && ok; ++i) {
+		size_t pad = static_cast<size_t>(entries[i].offset - offset);
+
+		ok = (pad == 0 || fwrite(zeros, 1, pad, fp) == pad) &&
+			fwrite(data[i], 1, static_cast<size_t>(entries[i].size), fp) == entries[i].size;
+		offset = entries[i].offset + entries[i].size;
+	}
+
+	if (fclose(fp) != 0) {
+		ok = false;
+	}
+
+	if (ok) {
+		_saved = _added.size();
+	}
+	return ok;
+}
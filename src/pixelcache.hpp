@@ -0,0 +1,135 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Decoded artwork kept on disk between launches (make PIXELCACHE=1).
+ * All entries live in one file in the user's cache directory
+ * (%LOCALAPPDATA%\SonicLauncher, $XDG_CACHE_HOME/SonicLauncher or
+ * ~/.cache/SonicLauncher), or in $SONICLAUNCHER_PIXEL_CACHE. It's mapped
+ * read-only and images point straight into it, so a warm start neither
+ * inflates nor copies the pixels.
+ *
+ * An entry is keyed by a hash of the embedded PNG, the scale in percent
+ * and the pixel format. The file header carries a checksum of the entry
+ * table and each entry one of its pixels, which is checked on the first
+ * lookup; a damaged or missing entry is a miss and the image is decoded
+ * as before. Pixels decoded after a miss are kept in memory, and save()
+ * writes a new file with everything this run used. Since the current
+ * file may still be mapped, the new one goes next to it and replaces it
+ * on the next open(). */
+
+#ifndef PIXELCACHE_HPP
+#define PIXELCACHE_HPP
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mapfile.hpp"
+#include "threads.hpp"
+
+#define PIXELCACHE_DIR      L"SonicLauncher"
+#define PIXELCACHE_FILE     L"pixels.cache"
+#define PIXELCACHE_NEW      L".new"
+#define PIXELCACHE_MAGIC    "SLPX"
+#define PIXELCACHE_VERSION  1
+#define PIXELCACHE_ALIGN    64
+#define PIXELCACHE_RGB8     1  /* d interleaved 8 bit channels, rows without padding */
+
+
+/* hash of the embedded data, 64 bits at a time */
+uint64_t pixelcache_hash(const void *data, size_t size);
+
+class pixelCache
+{
+private:
+	typedef struct {
+		char magic[4];
+		uint32_t version;
+		uint32_t count;
+		uint32_t reserved;
+		uint64_t size;  /* of the whole file */
+		uint64_t checksum;  /* of the entry table */
+	} header_t;
+
+	typedef struct {
+		uint64_t hash;
+		uint32_t scale;
+		uint32_t format;
+		uint32_t w, h, d;
+		uint32_t reserved;
+		uint64_t offset;
+		uint64_t size;
+		uint64_t checksum;  /* of the pixels */
+	} entry_t;
+
+	typedef struct {
+		uint64_t hash;
+		uint32_t scale;
+		int w, h, d;
+		std::vector<unsigned char> pixels;
+	} added_t;
+
+	std::wstring _path;
+	mappedFile _map;
+	const entry_t *_entries = NULL;
+	uint32_t _count = 0;
+
+	mutex _lock;
+	std::vector<unsigned char> _state;  /* per entry: unchecked, good, bad */
+	std::vector<bool> _used;
+	std::vector<added_t> _added;
+	size_t _saved = 0;  /* of _added, written by the last save() */
+	std::atomic<unsigned int> _hits{0};
+	std::atomic<unsigned int> _misses{0};
+
+	bool verify(uint32_t i);
+	bool write();
+
+public:
+	pixelCache() {}
+	pixelCache(const pixelCache &) = delete;
+	pixelCache &operator=(const pixelCache &) = delete;
+
+	/* the default file if path is NULL; false if there is no usable cache
+	 * yet, lookups miss then and save() creates it */
+	bool open(const wchar_t *path = NULL);
+	void close();
+
+	/* thread-safe; the pixels stay valid until close() */
+	bool find(uint64_t hash, int scale, const unsigned char **pixels, int *w, int *h, int *d);
+
+	/* thread-safe; pixels decoded after a miss, copied for save() */
+	void add(uint64_t hash, int scale, const unsigned char *pixels, int w, int h, int d);
+
+	/* thread-safe; write the entries this run used if anything was added
+	 * since the last call */
+	bool save();
+
+	unsigned int hits() const { return _hits.load(); }
+	unsigned int misses() const { return _misses.load(); }
+};
+
+#endif  /* PIXELCACHE_HPP */
@@ -0,0 +1,241 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <FL/Fl_RGB_Image.H>
+
+#include <math.h>
+#include <string.h>
+
+#include "scaledimage.hpp"
+#include "trace.hpp"
+
+
+/* source pixels contributing to one destination pixel; the weights of
+ * all of them are stored at a fixed stride */
+typedef struct {
+	int first;
+	int n;
+} span_t;
+
+static int filter_weights(int len, int dlen, std::vector<span_t> &spans, std::vector<float> &weights)
+{
+	float scale = static_cast<float>(dlen) / len;
+	float radius = (scale < 1.0f) ? 1.0f / scale : 1.0f;
+	int stride = static_cast<int>(ceilf(radius * 2)) + 1;
+
+	spans.resize(dlen);
+	weights.assign(static_cast<size_t>(dlen) * stride, 0.0f);
+
+	for (int i = 0; i < dlen; ++i) {
+		float center = (i + 0.5f) / scale;
+		int first = static_cast<int>(floorf(center - radius + 0.5f));
+		int last = static_cast<int>(ceilf(center + radius - 0.5f));
+		float *w = &weights[static_cast<size_t>(i) * stride];
+		float sum = 0.0f;
+
+		if (first < 0) {
+			first = 0;
+		}
+		if (last > len - 1) {
+			last = len - 1;
+		}
+		if (last - first + 1 > stride) {
+			last = first + stride - 1;
+		}
+
+		for (int j = first; j <= last; ++j) {
+			float t = 1.0f - fabsf((j + 0.5f - center) / radius);
+			w[j - first] = (t > 0.0f) ? t : 0.0f;
+			sum += w[j - first];
+		}
+
+		if (sum > 0.0f) {
+			for (int j = 0; j <= last - first; ++j) {
+				w[j] /= sum;
+			}
+		} else {
+			/* can only happen for a single source pixel */
+			w[0] = 1.0f;
+			last = first;
+		}
+
+		spans[i].first = first;
+		spans[i].n = last - first + 1;
+	}
+
+	return stride;
+}
+
+void resample_image(const uchar *src, int w, int h, int d, int ld, uchar *dst, int dw, int dh)
+{
+	TRACE_SCOPE("resample_image");
+
+	std::vector<span_t> hspans, vspans;
+	std::vector<float> hweights, vweights;
+	int hstride = filter_weights(w, dw, hspans, hweights);
+	int vstride = filter_weights(h, dh, vspans, vweights);
+	int alpha = (d == 2 || d == 4) ? d - 1 : -1;
+	size_t row = static_cast<size_t>(dw) * d;
+
+	/* premultiplied source pixels, then horizontally resampled rows */
+	std::vector<float> line(static_cast<size_t>(w) * d);
+	std::vector<float> rows(static_cast<size_t>(h) * row);
+	std::vector<float> acc(row);
+
+	if (ld == 0) {
+		ld = w * d;
+	}
+
+	for (int y = 0; y < h; ++y) {
+		const uchar *s = src + static_cast<size_t>(y) * ld;
+		float *out = &rows[static_cast<size_t>(y) * row];
+
+		for (int x = 0; x < w * d; ++x) {
+			line[x] = s[x];
+		}
+
+		if (alpha >= 0) {
+			for (int x = 0; x < w; ++x) {
+				float a = line[x * d + alpha] * (1.0f / 255.0f);
+
+				for (int c = 0; c < alpha; ++c) {
+					line[x * d + c] *= a;
+				}
+			}
+		}
+
+		for (int x = 0; x < dw; ++x) {
+			const float *wt = &hweights[static_cast<size_t>(x) * hstride];
+			const float *p = &line[static_cast<size_t>(hspans[x].first) * d];
+			float px[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+			for (int k = 0; k < hspans[x].n; ++k, p += d) {
+				for (int c = 0; c < d; ++c) {
+					px[c] += wt[k] * p[c];
+				}
+			}
+
+			for (int c = 0; c < d; ++c) {
+				out[x * d + c] = px[c];
+			}
+		}
+	}
+
+	/* vertical pass over whole rows, which the compiler vectorizes */
+	for (int y = 0; y < dh; ++y) {
+		const float *wt = &vweights[static_cast<size_t>(y) * vstride];
+		uchar *out = dst + static_cast<size_t>(y) * row;
+
+		memset(acc.data(), 0, row * sizeof(float));
+
+		for (int k = 0; k < vspans[y].n; ++k) {
+			const float *in = &rows[static_cast<size_t>(vspans[y].first + k) * row];
+			const float f = wt[k];
+
+			for (size_t i = 0; i < row; ++i) {
+				acc[i] += f * in[i];
+			}
+		}
+
+		for (int x = 0; x < dw; ++x) {
+			float *px = &acc[static_cast<size_t>(x) * d];
+
+			if (alpha >= 0) {
+				float a = px[alpha];
+
+				for (int c = 0; c < alpha; ++c) {
+					px[c] = (a > 0.0f) ? px[c] * 255.0f / a : 0.0f;
+				}
+			}
+
+			for (int c = 0; c < d; ++c) {
+				float v = px[c] + 0.5f;
+				out[x * d + c] = (v <= 0.0f) ? 0 : (v >= 255.0f) ? 255 : static_cast<uchar>(v);
+			}
+		}
+	}
+}
+
+Fl_Image *scaledImages::get(Fl_Image *src, int scale, uint64_t hash)
+{
+	if (!src || scale == 100 || scale <= 0 || src->count() != 1 || src->d() < 1 || src->d() > 4 || !src->data()) {
+		return src;
+	}
+
+	for (size_t i = 0; i < _variants.size(); ++i) {
+		if (_variants[i].src == src && _variants[i].scale == scale) {
+			return _variants[i].img;
+		}
+	}
+
+	int dw = (src->w() * scale + 50) / 100;
+	int dh = (src->h() * scale + 50) / 100;
+
+	if (dw < 1 || dh < 1) {
+		return src;
+	}
+
+	size_t size = static_cast<size_t>(dw) * dh * src->d();
+	const uchar *cached;
+	int cw, ch, cd;
+	Fl_RGB_Image *img;
+
+	if (_cache && hash && _cache->find(hash, scale, &cached, &cw, &ch, &cd) &&
+		cw == dw && ch == dh && cd == src->d())
+	{
+		/* mapped, not owned */
+		img = new Fl_RGB_Image(cached, dw, dh, cd);
+	} else {
+		uchar *buf = new uchar[size];
+
+		resample_image(reinterpret_cast<const uchar *>(src->data()[0]), src->w(), src->h(), src->d(), src->ld(),
+			buf, dw, dh);
+
+		if (_cache && hash) {
+			_cache->add(hash, scale, buf, dw, dh, src->d());
+		}
+
+		/* the image owns buf from here on */
+		img = new Fl_RGB_Image(buf, dw, dh, src->d());
+		img->alloc_array = 1;
+	}
+
+	_variants.push_back({ src, scale, img });
+	_bytes += size;
+
+	return img;
+}
+
+void scaledImages::retain(int scale)
+{
+	for (size_t i = 0; i < _variants.size(); ) {
+		if (_variants[i].scale == scale) {
+			++i;
+			continue;
+		}
+		_bytes -= static_cast<size_t>(_variants[i].img->w()) * _variants[i].img->h() * _variants[i].img->d();
+		delete _variants[i].img;
+		_variants.erase(_variants.begin() + i);
+	}
+}
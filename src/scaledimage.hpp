@@ -0,0 +1,79 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Copies of the embedded artwork resampled for the display scale. FLTK
+ * draws images pixel for pixel, so on a scaled display each image is
+ * resampled once and the copy is drawn from then on. Variants are keyed
+ * by the source image and the scale in percent. */
+
+#ifndef SCALEDIMAGE_HPP
+#define SCALEDIMAGE_HPP
+
+#include <FL/Fl.H>
+#include <FL/Fl_Image.H>
+
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "pixelcache.hpp"
+
+
+/* resample a w*h image with d (1 to 4) channels and line length ld to
+ * dw*dh, with a triangle filter that widens to an area average when
+ * shrinking; alpha is taken into account for 2 and 4 channels */
+void resample_image(const uchar *src, int w, int h, int d, int ld, uchar *dst, int dw, int dh);
+
+class scaledImages
+{
+private:
+	typedef struct {
+		Fl_Image *src;
+		int scale;
+		Fl_RGB_Image *img;
+	} variant_t;
+
+	std::vector<variant_t> _variants;
+	size_t _bytes = 0;
+	pixelCache *_cache = NULL;
+
+public:
+	~scaledImages() { retain(0); }
+
+	/* src scaled to scale percent; src itself if it's 100 or if src
+	 * isn't an RGB image. With a cache and the hash of src's embedded
+	 * data, the variant is looked up there before it's resampled. */
+	Fl_Image *get(Fl_Image *src, int scale, uint64_t hash = 0);
+
+	void cache(pixelCache *c) { _cache = c; }
+
+	/* drop all variants of other scales; 0 drops everything */
+	void retain(int scale);
+
+	/* pixel memory held by the variants */
+	size_t bytes() const { return _bytes; }
+	size_t count() const { return _variants.size(); }
+};
+
+#endif  /* SCALEDIMAGE_HPP */
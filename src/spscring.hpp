@@ -0,0 +1,112 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Fixed-size ring for handing items from exactly one producer thread to
+ * exactly one consumer thread without locks. Either side only ever waits
+ * on its own loop: push() fails when the ring is full and pop() when it's
+ * empty. The head and tail counters live on their own cache lines, and
+ * each side keeps a copy of the other one's counter that it only
+ * refreshes when the ring looks full or empty, so in the steady state the
+ * threads don't touch each other's lines. */
+
+#ifndef SPSCRING_HPP
+#define SPSCRING_HPP
+
+#include <atomic>
+#include <stddef.h>
+
+#define SPSCRING_CACHE_LINE  64
+
+
+template<class T, size_t N>
+class spscRing
+{
+	static_assert(N >= 2 && (N & (N - 1)) == 0, "the ring size must be a power of two");
+
+private:
+	/* consumer side */
+	alignas(SPSCRING_CACHE_LINE) std::atomic<size_t> _head{0};
+	size_t _tailCache = 0;
+
+	/* producer side */
+	alignas(SPSCRING_CACHE_LINE) std::atomic<size_t> _tail{0};
+	size_t _headCache = 0;
+
+	alignas(SPSCRING_CACHE_LINE) T _items[N];
+
+public:
+	spscRing() {}
+	spscRing(const spscRing &) = delete;
+	spscRing &operator=(const spscRing &) = delete;
+
+	/* producer only; false if the ring is full */
+	bool push(const T &item)
+	{
+		size_t tail = _tail.load(std::memory_order_relaxed);
+
+		if (tail - _headCache == N) {
+			_headCache = _head.load(std::memory_order_acquire);
+			if (tail - _headCache == N) {
+				return false;
+			}
+		}
+
+		_items[tail & (N - 1)] = item;
+		_tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	/* consumer only; false if the ring is empty */
+	bool pop(T &item)
+	{
+		size_t head = _head.load(std::memory_order_relaxed);
+
+		if (head == _tailCache) {
+			_tailCache = _tail.load(std::memory_order_acquire);
+			if (head == _tailCache) {
+				return false;
+			}
+		}
+
+		item = _items[head & (N - 1)];
+		_head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	/* items waiting; exact on the consumer side, a snapshot elsewhere */
+	size_t size() const {
+		return _tail.load(std::memory_order_acquire) - _head.load(std::memory_order_acquire);
+	}
+
+	static constexpr size_t capacity() { return N; }
+
+	/* only while neither side is running */
+	void clear() {
+		_head.store(0);
+		_tail.store(0);
+		_headCache = _tailCache = 0;
+	}
+};
+
+#endif  /* SPSCRING_HPP */
@@ -0,0 +1,109 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <FL/fl_draw.H>
+
+#include "staticlayer.hpp"
+#include "trace.hpp"
+
+
+void staticLayer::invalidate()
+{
+	if (_off) {
+		fl_delete_offscreen(_off);
+		_off = 0;
+	}
+	_offW = _offH = 0;
+}
+
+void staticLayer::cache(bool b)
+{
+	_cache = b;
+
+	if (!b) {
+		invalidate();
+	}
+}
+
+void staticLayer::resize(int X, int Y, int W, int H)
+{
+	if (W != w() || H != h()) {
+		invalidate();
+	}
+	Fl_Group::resize(X, Y, W, H);
+}
+
+/* draw the children into the offscreen buffer; needs a current window */
+void staticLayer::render()
+{
+	TRACE_SCOPE("staticLayer::render");
+
+	_offW = x() + w();
+	_offH = y() + h();
+	_off = fl_create_offscreen(_offW, _offH);
+
+	if (!_off) {
+		_offW = _offH = 0;
+		return;
+	}
+
+	fl_begin_offscreen(_off);
+	fl_rectf(0, 0, _offW, _offH, color());
+	draw_children();
+	fl_end_offscreen();
+}
+
+void staticLayer::draw()
+{
+	int X, Y, W, H;
+
+	if (!_cache) {
+		fl_rectf(x(), y(), w(), h(), color());
+		draw_children();
+		return;
+	}
+
+	if (!_off) {
+		/* draw_children() only draws damaged children
+		 * unless the whole layer is damaged */
+		uchar d = damage();
+		clear_damage(FL_DAMAGE_ALL);
+		render();
+		clear_damage(d);
+
+		if (!_off) {
+			/* no buffer, draw directly */
+			fl_rectf(x(), y(), w(), h(), color());
+			draw_children();
+			return;
+		}
+	}
+
+	/* only copy what is visible through the current clip region */
+	fl_clip_box(x(), y(), w(), h(), X, Y, W, H);
+
+	if (W > 0 && H > 0) {
+		fl_copy_offscreen(X, Y, W, H, _off, X, Y);
+	}
+}
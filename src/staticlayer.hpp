@@ -0,0 +1,79 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* A group of widgets that never change after the window was built
+ * (backgrounds, frames, glyphs and captions). They are drawn once into
+ * an offscreen buffer and later exposes only copy that buffer to the
+ * window; the interactive widgets are drawn on top of it.
+ *
+ * FLTK widgets draw in window coordinates, so the buffer reaches from
+ * the window's origin to the bottom right corner of the layer; keep the
+ * layer near the origin. Parts not covered by a child are filled with
+ * the layer's color(). */
+
+#ifndef STATICLAYER_HPP
+#define STATICLAYER_HPP
+
+#include <FL/Fl.H>
+#include <FL/Fl_Group.H>
+#include <FL/x.H>
+
+#include <stddef.h>
+
+
+class staticLayer : public Fl_Group
+{
+private:
+	Fl_Offscreen _off = 0;
+	int _offW = 0;
+	int _offH = 0;
+	bool _cache = true;
+
+	void render();
+
+public:
+	staticLayer(int X, int Y, int W, int H)
+		: Fl_Group(X, Y, W, H, NULL)
+	{}
+
+	~staticLayer() { invalidate(); }
+
+	/* drop the cached pixels; they are drawn again on the next expose */
+	void invalidate();
+
+	/* turn the cache on and off (for benchmarks) */
+	void cache(bool b);
+	bool cache() const { return _cache; }
+
+	/* size of the cached pixels */
+	size_t bytes() const { return static_cast<size_t>(_offW) * _offH * 4; }
+
+	/* nothing in here takes events */
+	int handle(int) { return 0; }
+
+	void resize(int X, int Y, int W, int H);
+	void draw();
+};
+
+#endif  /* STATICLAYER_HPP */
@@ -0,0 +1,189 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Minimal thread primitives. The MinGW build uses the win32 thread model
+ * (no std::thread), so these wrap the native APIs directly. */
+
+#ifndef THREADS_HPP
+#define THREADS_HPP
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <errno.h>
+#include <time.h>
+#endif
+
+
+typedef void (*threadFunc_t)(void *);
+
+class mutex
+{
+private:
+#ifdef _WIN32
+	CRITICAL_SECTION _cs;
+#else
+	pthread_mutex_t _m;
+#endif
+
+public:
+#ifdef _WIN32
+	mutex()  { InitializeCriticalSection(&_cs); }
+	~mutex() { DeleteCriticalSection(&_cs); }
+	void lock()   { EnterCriticalSection(&_cs); }
+	void unlock() { LeaveCriticalSection(&_cs); }
+#else
+	mutex()  { pthread_mutex_init(&_m, NULL); }
+	~mutex() { pthread_mutex_destroy(&_m); }
+	void lock()   { pthread_mutex_lock(&_m); }
+	void unlock() { pthread_mutex_unlock(&_m); }
+	pthread_mutex_t *native() { return &_m; }
+#endif
+};
+
+/* auto-reset event */
+class event
+{
+private:
+#ifdef _WIN32
+	HANDLE _h;
+#else
+	pthread_mutex_t _m;
+	pthread_cond_t _c;
+	bool _signaled = false;
+#endif
+
+public:
+#ifdef _WIN32
+	event()  { _h = CreateEventW(NULL, FALSE, FALSE, NULL); }
+	~event() { CloseHandle(_h); }
+	void set() { SetEvent(_h); }
+
+	/* returns false on time-out; ms < 0 waits forever */
+	bool wait(int ms = -1) {
+		return WaitForSingleObject(_h, (ms < 0) ? INFINITE : static_cast<DWORD>(ms)) == WAIT_OBJECT_0;
+	}
+#else
+	event() {
+		pthread_mutex_init(&_m, NULL);
+		pthread_cond_init(&_c, NULL);
+	}
+
+	~event() {
+		pthread_cond_destroy(&_c);
+		pthread_mutex_destroy(&_m);
+	}
+
+	void set() {
+		pthread_mutex_lock(&_m);
+		_signaled = true;
+		pthread_cond_signal(&_c);
+		pthread_mutex_unlock(&_m);
+	}
+
+	bool wait(int ms = -1) {
+		struct timespec ts;
+		int rc = 0;
+
+		if (ms >= 0) {
+			clock_gettime(CLOCK_REALTIME, &ts);
+			ts.tv_sec += ms / 1000;
+			ts.tv_nsec += (ms % 1000) * 1000000L;
+			if (ts.tv_nsec >= 1000000000L) {
+				ts.tv_sec++;
+				ts.tv_nsec -= 1000000000L;
+			}
+		}
+
+		pthread_mutex_lock(&_m);
+		while (!_signaled && rc != ETIMEDOUT) {
+			rc = (ms < 0) ? pthread_cond_wait(&_c, &_m) : pthread_cond_timedwait(&_c, &_m, &ts);
+		}
+		bool rv = _signaled;
+		_signaled = false;
+		pthread_mutex_unlock(&_m);
+		return rv;
+	}
+#endif
+};
+
+class thread
+{
+private:
+	threadFunc_t _fn = NULL;
+	void *_arg = NULL;
+	bool _running = false;
+#ifdef _WIN32
+	HANDLE _h = NULL;
+
+	static DWORD WINAPI entry(LPVOID p) {
+		thread *t = reinterpret_cast<thread *>(p);
+		t->_fn(t->_arg);
+		return 0;
+	}
+#else
+	pthread_t _t;
+
+	static void *entry(void *p) {
+		thread *t = reinterpret_cast<thread *>(p);
+		t->_fn(t->_arg);
+		return NULL;
+	}
+#endif
+
+public:
+	~thread() { join(); }
+
+	bool start(threadFunc_t fn, void *arg) {
+		if (_running) {
+			return false;
+		}
+		_fn = fn;
+		_arg = arg;
+#ifdef _WIN32
+		_h = CreateThread(NULL, 0, entry, this, 0, NULL);
+		_running = (_h != NULL);
+#else
+		_running = (pthread_create(&_t, NULL, entry, this) == 0);
+#endif
+		return _running;
+	}
+
+	void join() {
+		if (!_running) {
+			return;
+		}
+#ifdef _WIN32
+		WaitForSingleObject(_h, INFINITE);
+		CloseHandle(_h);
+		_h = NULL;
+#else
+		pthread_join(_t, NULL);
+#endif
+		_running = false;
+	}
+};
+
+#endif  /* THREADS_HPP */
@@ -0,0 +1,159 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+#include <atomic>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "trace.hpp"
+
+
+void startup_mark(const char *name)
+{
+	const char *file = getenv("SONICLAUNCHER_STARTUP_MARKS");
+	unsigned long long us;
+	FILE *fp;
+
+	if (!file || !*file || (fp = fopen(file, "a")) == NULL) {
+		return;
+	}
+
+#ifdef _WIN32
+	FILETIME ft;
+	GetSystemTimeAsFileTime(&ft);
+	/* 100ns intervals since 1601-01-01 */
+	us = ((static_cast<unsigned long long>(ft.dwHighDateTime) << 32 | ft.dwLowDateTime) - 116444736000000000ULL) / 10;
+#else
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	us = static_cast<unsigned long long>(tv.tv_sec) * 1000000 + tv.tv_usec;
+#endif
+
+	fprintf(fp, "%s %llu\n", name, us);
+	fclose(fp);
+}
+
+#ifdef SL_TRACE
+#define TRACE_RING_SIZE  4096
+
+
+typedef struct {
+	const char *name;
+	uint64_t ts;
+	uint64_t dur;
+	unsigned long tid;
+	char phase;
+} traceEvent_t;
+
+static traceEvent_t ring[TRACE_RING_SIZE];
+static std::atomic<unsigned int> ringNext(0);
+static std::atomic<bool> registered(false);
+
+
+static unsigned long thread_id(void)
+{
+#ifdef _WIN32
+	return GetCurrentThreadId();
+#else
+	return static_cast<unsigned long>(pthread_self());
+#endif
+}
+
+static unsigned long process_id(void)
+{
+#ifdef _WIN32
+	return GetCurrentProcessId();
+#else
+	return static_cast<unsigned long>(getpid());
+#endif
+}
+
+static void dump_atexit(void)
+{
+	trace::dump();
+}
+
+void trace::event(const char *name, char phase, uint64_t ts, uint64_t dur)
+{
+	traceEvent_t *e = &ring[ringNext.fetch_add(1) % TRACE_RING_SIZE];
+
+	e->name = name;
+	e->ts = ts;
+	e->dur = dur;
+	e->tid = thread_id();
+	e->phase = phase;
+
+	if (!registered.exchange(true)) {
+		atexit(dump_atexit);
+	}
+}
+
+bool trace::dump()
+{
+	const char *file = getenv("SONICLAUNCHER_TRACE");
+	unsigned int end = ringNext.load();
+	unsigned int i = (end > TRACE_RING_SIZE) ? end - TRACE_RING_SIZE : 0;
+	unsigned long pid = process_id();
+	FILE *fp;
+
+	if (!file || !*file) {
+		file = "SonicLauncher.trace.json";
+	}
+
+	if ((fp = fopen(file, "w")) == NULL) {
+		return false;
+	}
+
+	fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+	for (const char *sep = "\n"; i < end; ++i, sep = ",\n") {
+		const traceEvent_t *e = &ring[i % TRACE_RING_SIZE];
+
+		fprintf(fp, "%s{\"name\":\"%s\",\"cat\":\"launcher\",\"ph\":\"%c\",\"ts\":%llu,", sep, e->name, e->phase,
+			static_cast<unsigned long long>(e->ts));
+		if (e->phase == 'X') {
+			fprintf(fp, "\"dur\":%llu,", static_cast<unsigned long long>(e->dur));
+		} else if (e->phase == 'C') {
+			/* counters keep their value in dur */
+			fprintf(fp, "\"args\":{\"value\":%llu},", static_cast<unsigned long long>(e->dur));
+		}
+		fprintf(fp, "\"pid\":%lu,\"tid\":%lu}", pid, e->tid);
+	}
+
+	fprintf(fp, "\n]}\n");
+	fclose(fp);
+
+	return true;
+}
+
+#endif  /* SL_TRACE */
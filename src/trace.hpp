@@ -0,0 +1,104 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Startup instrumentation. Compiled out unless SL_TRACE is defined
+ * (make TRACE=1). Events are kept in a fixed size in-memory ring and
+ * written as Chrome trace-event JSON (chrome://tracing, Perfetto) on exit
+ * to $SONICLAUNCHER_TRACE or SonicLauncher.trace.json. */
+
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+/* Startup milestones for external benchmarks, always compiled in. If
+ * $SONICLAUNCHER_STARTUP_MARKS names a file, "<name> <unix time in us>"
+ * is appended to it. */
+void startup_mark(const char *name);
+
+#ifdef SL_TRACE
+
+#include <stdint.h>
+#include "clock.hpp"
+
+#define TRACE_CONCAT_(a,b)  a##b
+#define TRACE_CONCAT(a,b)   TRACE_CONCAT_(a,b)
+
+/* time the rest of the current block */
+#define TRACE_SCOPE(name)   traceScope TRACE_CONCAT(_trace_scope_, __LINE__)(name)
+
+/* spans that don't follow block scope; begin and end must be on the same thread */
+#define TRACE_BEGIN(name)   trace::event(name, 'B', clock_us(), 0)
+#define TRACE_END(name)     trace::event(name, 'E', clock_us(), 0)
+
+/* a value over time, such as memory held by a cache */
+#define TRACE_COUNTER(name, value)  trace::event(name, 'C', clock_us(), value)
+
+/* time static initializers; both must be placed at namespace scope
+ * in the same translation unit */
+#define TRACE_STATIC_BEGIN(id)        static const uint64_t id##_trace_start = clock_us();
+#define TRACE_STATIC_END(id, name)    static traceScope id##_trace_end(name, id##_trace_start);
+
+#define TRACE_DUMP()        trace::dump()
+
+namespace trace
+{
+	void event(const char *name, char phase, uint64_t ts, uint64_t dur);
+	bool dump();
+}
+
+class traceScope
+{
+private:
+	const char *_name;
+	uint64_t _start;
+	bool _closed = false;
+
+public:
+	traceScope(const char *name) : _name(name), _start(clock_us()) {}
+
+	/* completes a span that started at an earlier timestamp */
+	traceScope(const char *name, uint64_t start) : _name(name), _start(start) {
+		trace::event(_name, 'X', _start, clock_us() - _start);
+		_closed = true;
+	}
+
+	~traceScope() {
+		if (!_closed) {
+			trace::event(_name, 'X', _start, clock_us() - _start);
+		}
+	}
+};
+
+#else
+
+#define TRACE_SCOPE(name)
+#define TRACE_BEGIN(name)
+#define TRACE_END(name)
+#define TRACE_COUNTER(name, value)
+#define TRACE_STATIC_BEGIN(id)
+#define TRACE_STATIC_END(id, name)
+#define TRACE_DUMP()
+
+#endif  /* SL_TRACE */
+
+#endif  /* TRACE_HPP */
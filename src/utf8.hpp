@@ -0,0 +1,63 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019-2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef UTF8_HPP
+#define UTF8_HPP
+
+
+// https://www.daemonology.net/blog/2008-06-05-faster-utf8-strlen.html
+static inline void strip_last_utf8_char(char *s)
+{
+	int i = 0;
+	int last_char = 0;
+
+	/* bytes 0xC0 through 0xFF are the first byte
+	 * of a UTF-8 multi-byte character */
+	while (s[i]) {
+		if ((s[i] & 0xC0) != 0x80) {
+			last_char = i;
+		}
+		i++;
+	}
+
+	s[last_char] = 0;
+}
+
+/* shrink a label until measure(s) fits into limit pixels */
+template<typename F>
+static inline void fit_utf8_label(char *s, int limit, F measure)
+{
+	if (static_cast<int>(measure(s)) <= limit) {
+		return;
+	}
+
+	while (s[0] != 0) {
+		strip_last_utf8_char(s);
+		if (static_cast<int>(measure(s)) <= limit) {
+			break;
+		}
+	}
+}
+
+#endif  /* UTF8_HPP */